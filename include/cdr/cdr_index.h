@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct CdrIndexEntry {
+    uint64_t imsi_key;
+    uint64_t offset;
+};
+
+// Индекс закрытого сегмента CDR: отсортированный список (IMSI, смещение записи)
+// и разреженный индекс (каждый kSparseStep-й ключ), который держится в памяти.
+// Поиск читает с диска только блок(и) записей, где может лежать ключ.
+class CdrSegmentIndex {
+public:
+    static constexpr uint64_t kSparseStep = 256;   // 256 * 16 байт = одна страница
+
+    explicit CdrSegmentIndex(const std::string& index_path);
+    ~CdrSegmentIndex() noexcept;
+
+    CdrSegmentIndex(const CdrSegmentIndex&) = delete;
+    CdrSegmentIndex& operator=(const CdrSegmentIndex&) = delete;
+
+    // Смещения всех записей IMSI в сегменте, по возрастанию
+    std::vector<uint64_t> find(uint64_t imsi_key) const;
+    uint64_t size() const noexcept { return count_; }
+
+    // Ключ IMSI - Imsi::key(): десятичное значение и длина (ведущие нули значимы).
+    // 0 - строку отвергает Imsi::parse
+    static uint64_t make_key(std::string_view imsi) noexcept;
+
+    // Ключ из строки CDR вида "<время>,<imsi>,<действие>"
+    static uint64_t key_from_record(std::string_view record) noexcept;
+
+    static void write(const std::string& index_path, std::vector<CdrIndexEntry>& entries);
+    // Индекс записей файла начиная со смещения from_offset (начала записи)
+    static std::vector<CdrIndexEntry> build_from_segment(const std::string& segment_path, uint64_t from_offset = 0);
+
+private:
+    int fd_ = -1;
+    uint64_t count_ = 0;
+    std::vector<uint64_t> sparse_keys_;
+};
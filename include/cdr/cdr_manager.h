@@ -2,25 +2,81 @@
 #include <string>
 #include <fstream>
 #include <mutex>
+#include <shared_mutex>
 #include <queue>
 #include <thread>
 #include <atomic>
+#include <memory>
+#include <vector>
 #include <string_view>
+#include <utility>
+#include "cdr/cdr_index.h"
+#include "utils/imsi.h"
+
+struct CdrSegmentInfo {
+    uint64_t sequence;
+    std::string name;   // имя файла без каталога
+    std::string path;
+    uint64_t size;
+};
 
 class CdrManager {
 public:
-    CdrManager(const std::string& filename);
+    // segment_max_bytes > 0 включает ротацию: заполненный файл закрывается в сегмент
+    // <filename>.<N> с индексом <filename>.<N>.idx
+    CdrManager(const std::string& filename, uint64_t segment_max_bytes = 0);
     ~CdrManager() noexcept;
-    
-    virtual void add_record(std::string_view imsi, std::string_view action);
+
+    virtual void add_record(Imsi imsi, std::string_view action);
+    // Время add_record в текущем потоке нарастающим итогом, нс: разность до и после
+    // обработки запроса - его стадия CdrEnqueue
+    static uint64_t thread_enqueue_nanos() noexcept;
     virtual void flush();
 
+    // История IMSI по закрытым сегментам и текущему файлу (только уже записанные на диск записи)
+    std::vector<std::string> find_records(Imsi imsi, size_t limit) const;
+
+    // Закрытые (неизменяемые) сегменты, от старых к новым
+    std::vector<CdrSegmentInfo> list_segments() const;
+
+    size_t queue_depth() const;
+
+    // Перечитать сегменты и текущий файл, дописанные другим процессом после конструктора
+    // (передача работы); сам менеджер до этого ничего не пишет
+    void resync();
+
+    // Текущий (незакрытый) файл CDR
+    const std::string& active_file() const noexcept { return filename_; }
+
 private:
+    struct Segment {
+        uint64_t sequence;
+        std::string path;
+        std::unique_ptr<CdrSegmentIndex> index;
+    };
+
+    std::string filename_;
+    const uint64_t segment_max_bytes_;
+
     std::ofstream file_;
-    std::mutex mutex_;
+    mutable std::mutex mutex_;
+    std::mutex flush_mutex_;
     std::queue<std::string> queue_;
     std::atomic<bool> running_{true};
+
+    // Закрытые сегменты и индекс текущего файла; пишет только поток flush
+    mutable std::shared_mutex segments_mutex_;
+    std::vector<Segment> segments_;
+    std::vector<CdrIndexEntry> active_index_;
+    uint64_t active_size_ = 0;
+    uint64_t next_sequence_ = 1;
+
     std::thread worker_;
-    
+
     void process_queue();
-};
\ No newline at end of file
+    std::vector<std::pair<uint64_t, std::string>> find_segments() const;
+    void add_segment(uint64_t sequence, std::string path);
+    void load_segments();
+    void rotate_segment();
+    std::string segment_path(uint64_t sequence) const;
+};
@@ -15,6 +15,11 @@ public:
     const std::string& get_log_level() const noexcept { return log_level_; }
     bool get_console_output() const noexcept { return console_output_; }
 
+    int get_request_timeout_ms() const noexcept { return request_timeout_ms_; }
+    int get_max_retries() const noexcept { return max_retries_; }
+    double get_retry_budget_ratio() const noexcept { return retry_budget_ratio_; }
+    bool get_hedge_requests() const noexcept { return hedge_requests_; }
+
 private:
     void load_config(std::string_view config_file_path);
     void validate_config();
@@ -24,4 +29,8 @@ private:
     std::string log_file_;
     std::string log_level_ = "INFO";
     bool console_output_ = false;
+    int request_timeout_ms_ = 2000;
+    int max_retries_ = 3;
+    double retry_budget_ratio_ = 0.2;
+    bool hedge_requests_ = false;
 };
\ No newline at end of file
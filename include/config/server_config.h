@@ -13,13 +13,31 @@ public:
     const std::string& get_cdr_file() const noexcept{ return cdr_file_; }
     const std::string& get_log_level() const noexcept{ return log_level_; }
     const std::string& get_log_file() const noexcept{ return log_file_; }
+    const std::string& get_log_flush_level() const noexcept{ return log_flush_level_; }
+    const std::string& get_log_overflow() const noexcept{ return log_overflow_; }
+    const std::string& get_shm_session_table() const noexcept{ return shm_session_table_; }
+    const std::string& get_session_snapshot_dir() const noexcept{ return session_snapshot_dir_; }
+    const std::string& get_handoff_socket() const noexcept{ return handoff_socket_; }
+    const std::string& get_replication_standby_ip() const noexcept{ return replication_standby_ip_; }
     
     int get_udp_port() const noexcept{ return udp_port_; }
     int get_session_timeout_sec() const noexcept{ return session_timeout_sec_; }
     int get_http_port() const noexcept{ return http_port_; }
     int get_graceful_shutdown_rate() const noexcept{ return graceful_shutdown_rate_; }
+    int get_cdr_segment_size_mb() const noexcept{ return cdr_segment_size_mb_; }
+    int get_cdr_export_port() const noexcept{ return cdr_export_port_; }
+    int get_slow_request_threshold_us() const noexcept{ return slow_request_threshold_us_; }
+    int get_log_queue_size() const noexcept{ return log_queue_size_; }
+    int get_log_flush_interval_sec() const noexcept{ return log_flush_interval_sec_; }
+    int get_shm_session_capacity() const noexcept{ return shm_session_capacity_; }
+    int get_session_snapshot_interval_sec() const noexcept{ return session_snapshot_interval_sec_; }
+    int get_replication_standby_port() const noexcept{ return replication_standby_port_; }
+    int get_replication_port() const noexcept{ return replication_port_; }
+    int get_replication_batch_ms() const noexcept{ return replication_batch_ms_; }
     
     bool get_console_output() const noexcept { return console_output_; }
+    bool get_log_async() const noexcept { return log_async_; }
+    bool get_recover_sessions_from_cdr() const noexcept { return recover_sessions_from_cdr_; }
     
     const std::vector<std::string>& get_blacklist() const noexcept{ return blacklist_; }
     
@@ -30,11 +48,29 @@ private:
     int udp_port_;
     int session_timeout_sec_;
     std::string cdr_file_;
+    int cdr_segment_size_mb_ = 0;
+    int cdr_export_port_ = 0;
+    int slow_request_threshold_us_ = 10000;
     int http_port_;
     int graceful_shutdown_rate_;
     std::string log_file_;
     std::string log_level_;
     bool console_output_ = false;
+    bool log_async_ = false;
+    int log_queue_size_ = 8192;
+    std::string log_overflow_ = "block";
+    std::string log_flush_level_ = "WARN";
+    int log_flush_interval_sec_ = 1;
+    std::string shm_session_table_;         // имя shm-региона ("/pgw_sessions"), пусто - выключено
+    int shm_session_capacity_ = 1048576;
+    std::string session_snapshot_dir_;      // снимки и журнал сессий, пусто - выключено
+    int session_snapshot_interval_sec_ = 60;
+    bool recover_sessions_from_cdr_ = false;
+    std::string handoff_socket_;            // Unix-сокет передачи работы новому процессу, пусто - выключено
+    std::string replication_standby_ip_;    // основной узел: адрес резервного, пусто - выключено
+    int replication_standby_port_ = 0;
+    int replication_port_ = 0;              // резервный узел: порт приёма репликации, 0 - выключено
+    int replication_batch_ms_ = 20;         // период отправки изменений: верхняя граница задержки
     std::vector<std::string> blacklist_;
 
     bool is_valid_ = false;
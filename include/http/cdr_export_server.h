@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include "cdr/cdr_manager.h"
+
+// Выгрузка закрытых сегментов CDR: GET /cdr_export/<segment>[?offset=N], заголовок Range.
+// httplib не отдаёт сокет клиента, поэтому выгрузка идёт через отдельный порт:
+// файл передаётся в сокет через sendfile() без копирования в пространство пользователя,
+// а поток работает с политикой SCHED_IDLE и не отнимает CPU у UDP.
+class CdrExportServer {
+public:
+    CdrExportServer(int port, const std::string& host, std::shared_ptr<CdrManager> cdr_manager);
+    // Слушающий сокет, переданный прежним процессом (session/session_handoff.h)
+    CdrExportServer(int listen_fd, std::shared_ptr<CdrManager> cdr_manager);
+    ~CdrExportServer();
+
+    void start();
+    void stop();
+    bool is_running() const noexcept { return running_; }
+    int socket_fd() const noexcept { return listen_fd_; }
+
+    CdrExportServer(const CdrExportServer&) = delete;
+    CdrExportServer& operator=(const CdrExportServer&) = delete;
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::string request;
+        std::string header;
+        size_t header_sent = 0;
+        int file_fd = -1;
+        uint64_t offset = 0;
+        uint64_t remaining = 0;
+        std::chrono::steady_clock::time_point last_activity;
+    };
+
+    void worker_thread();
+    bool setup_socket();
+    bool setup_epoll();
+    void accept_connections();
+    void handle_readable(Connection& conn);
+    bool handle_writable(Connection& conn);
+    void prepare_response(Connection& conn);
+    void set_error(Connection& conn, int status, std::string_view reason);
+    void close_connection(int fd);
+
+    int port_;
+    std::string host_;
+    std::shared_ptr<CdrManager> cdr_manager_;
+
+    int listen_fd_ = -1;
+    int epoll_fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread worker_thread_;
+    std::unordered_map<int, Connection> connections_;
+};
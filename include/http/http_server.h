@@ -19,6 +19,7 @@ public:
     
     // Регистрация endpoint'ов
     void add_get_handler(std::string_view path, RequestHandler handler);
+    void add_post_handler(std::string_view path, RequestHandler handler);
 
 
 private:
@@ -27,10 +28,13 @@ private:
     std::unique_ptr<httplib::Server> server_;
     std::thread server_thread_;
     std::atomic<bool> running_{false};
-    std::atomic<size_t> request_count_{0};
     int port_;
     std::string host_;
     
     // Встроенные обработчики
     void handle_health_check(const httplib::Request&, httplib::Response& res);
+    void handle_metrics(const httplib::Request&, httplib::Response& res);
+    void handle_latency(const httplib::Request&, httplib::Response& res);
+    void handle_profile(const httplib::Request& req, httplib::Response& res);
+    void handle_slow_requests(const httplib::Request& req, httplib::Response& res);
 };
\ No newline at end of file
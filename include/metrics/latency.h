@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Этапы обработки UDP-запроса
+enum class Stage : size_t {
+    Receive,        // ожидание в очереди сокета: от метки ядра до recvmsg
+    Decode,         // BCD -> IMSI и валидация в handle_udp_message
+    SessionCreate,  // SessionManager::create_session (чёрный список, блокировка, CDR)
+    CdrEnqueue,     // CdrManager::add_record
+    Send,           // отправка ответа
+    Total,          // весь handle_udp_message
+    Count
+};
+
+// Лог-линейная гистограмма в духе HdrHistogram: значения до 2^kSubBucketBits
+// хранятся точно, дальше каждая степень двойки делится на kSubBucketCount
+// линейных корзин (относительная ошибка не больше 1/32). Писатель один, читать
+// можно параллельно: счётчики атомарные, но без RMW.
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 5;
+    static constexpr uint64_t kSubBucketCount = uint64_t{1} << kSubBucketBits;
+    static constexpr unsigned kMaxValueBits = 40;   // ~18 минут в наносекундах
+    static constexpr uint64_t kMaxValue = (uint64_t{1} << kMaxValueBits) - 1;
+    static constexpr size_t kBucketCount = (kMaxValueBits - kSubBucketBits + 1) * kSubBucketCount;
+
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t value) noexcept {
+        if (value > kMaxValue) value = kMaxValue;
+        bump(counts_[bucket_index(value)], 1);
+        bump(total_count_, 1);
+        bump(sum_, value);
+        if (value > max_.load(std::memory_order_relaxed)) {
+            max_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    // Добавить значения другой гистограммы (вызывается только читателем-владельцем this)
+    void merge(const LatencyHistogram& other) noexcept;
+    void reset() noexcept;
+
+    uint64_t count() const noexcept { return total_count_.load(std::memory_order_relaxed); }
+    uint64_t max() const noexcept { return max_.load(std::memory_order_relaxed); }
+    double mean() const noexcept;
+    // Верхняя граница корзины, в которую попадает перцентиль (0..100)
+    uint64_t value_at_percentile(double percentile) const noexcept;
+
+    static constexpr size_t bucket_index(uint64_t value) noexcept {
+        if (value < 2 * kSubBucketCount) return static_cast<size_t>(value);
+        const unsigned shift = (63u - static_cast<unsigned>(__builtin_clzll(value))) - kSubBucketBits;
+        return static_cast<size_t>(shift * kSubBucketCount + (value >> shift));
+    }
+
+    static constexpr uint64_t bucket_upper_bound(size_t index) noexcept {
+        if (index < 2 * kSubBucketCount) return index;
+        const uint64_t shift = index / kSubBucketCount - 1;
+        const uint64_t mantissa = index - shift * kSubBucketCount;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+private:
+    static void bump(std::atomic<uint64_t>& cell, uint64_t value) noexcept {
+        cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> counts_[kBucketCount] = {};
+    std::atomic<uint64_t> total_count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Гистограммы задержек по этапам: по набору на поток, слияние при чтении (/latency)
+class Latency {
+public:
+    static void record(Stage stage, uint64_t nanos) noexcept;
+
+    // Сумма по всем потокам
+    static void snapshot(Stage stage, LatencyHistogram& out);
+
+    // JSON: для каждого этапа count, mean, p50, p90, p99, p99.9 и max в микросекундах
+    static std::string render_json();
+
+    static const char* stage_name(Stage stage) noexcept;
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+enum class Counter : size_t {
+    UdpPacketsIn,
+    UdpPacketsOut,
+    UdpDecodeFailures,
+    SessionsCreated,
+    SessionsProlonged,
+    SessionsRejected,
+    SessionsExpired,
+    SessionsRemoved,
+    CdrRecordsWritten,
+    CdrBytesWritten,
+    HttpRequests,
+    SessionEventsDropped,
+    Count
+};
+
+// Счётчики сервера. У каждого потока свой слот, выровненный по кэш-линии:
+// на горячем пути только load/store в собственный слот, без атомарных RMW и
+// без разделяемых кэш-линий. Слоты суммируются только при чтении (/metrics).
+class Metrics {
+public:
+    static constexpr size_t kCacheLineSize = 64;
+
+    struct alignas(kCacheLineSize) CounterSlot {
+        std::atomic<uint64_t> values[static_cast<size_t>(Counter::Count)] = {};
+    };
+
+    static void increment(Counter counter, uint64_t value = 1) noexcept {
+        auto& cell = local_slot().values[static_cast<size_t>(counter)];
+        // Писатель у слота один, поэтому достаточно relaxed load + store
+        cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    // Сумма по всем потокам, включая завершившиеся
+    static uint64_t value(Counter counter);
+
+    // Значение вычисляется в момент чтения метрик
+    using GaugeFn = std::function<double()>;
+    static void register_gauge(const std::string& name, const std::string& help, GaugeFn fn);
+    // Монотонный счётчик, который компонент ведёт сам (имя с суффиксом _total)
+    using CounterFn = std::function<uint64_t()>;
+    static void register_counter(const std::string& name, const std::string& help, CounterFn fn);
+    // Снять метрику register_gauge или register_counter
+    static void unregister_gauge(const std::string& name);
+
+    // Текстовый формат Prometheus (text/plain; version=0.0.4)
+    static std::string render_prometheus();
+
+private:
+    static CounterSlot& local_slot() noexcept;
+};
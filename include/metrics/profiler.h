@@ -0,0 +1,25 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+// Семплирующий CPU-профайлер всего процесса: ITIMER_PROF раз в 1/hz секунды
+// процессорного времени присылает SIGPROF потоку, который сейчас исполняется,
+// обработчик сохраняет стек в заранее выделенный буфер. Пока профиль не снимается,
+// обработчик не установлен и таймер выключен - накладных расходов нет.
+class Profiler {
+public:
+    static constexpr int kMaxHz = 1000;
+    static constexpr std::chrono::seconds kMaxDuration{60};
+    static constexpr size_t kMaxDepth = 64;
+
+    struct Result {
+        std::string folded;    // "frame;frame;frame count" по строке на уникальный стек
+        size_t samples = 0;
+        size_t dropped = 0;    // не поместились в буфер
+    };
+
+    // Блокирует вызывающий поток на duration. Одновременно идёт только один профиль:
+    // повторный вызов бросает std::runtime_error. Таймер не запустился - std::system_error.
+    static Result profile(std::chrono::seconds duration, int hz);
+};
@@ -0,0 +1,50 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "metrics/latency.h"
+#include "utils/imsi.h"
+
+// Разбивка одного UDP-запроса по этапам. Тривиально копируемая: пишется в кольцо
+// словами по 8 байт без блокировок
+struct RequestTrace {
+    static constexpr size_t kStageCount = static_cast<size_t>(Stage::Count);
+
+    int64_t timestamp_ms = 0;       // system_clock, мс с эпохи
+    uint32_t source_ip = 0;         // сетевой порядок байт
+    uint16_t source_port = 0;       // сетевой порядок байт
+    Imsi imsi;
+    uint32_t stage_nanos[kStageCount] = {};   // насыщается на ~4.29 с
+
+    void set_stage(Stage stage, uint64_t nanos) noexcept {
+        stage_nanos[static_cast<size_t>(stage)] = nanos > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(nanos);
+    }
+    uint32_t total_nanos() const noexcept { return stage_nanos[static_cast<size_t>(Stage::Total)]; }
+};
+
+// Трассы запросов: у каждого потока кольцо последних kRingSize запросов (seqlock на
+// запись, читатель пропускает записи, перезаписанные во время чтения). Запросы
+// дольше порога дополнительно копируются в общий набор kSlowestCapacity самых медленных.
+class RequestTraces {
+public:
+    static constexpr size_t kRingSize = 1024;
+    static constexpr size_t kSlowestCapacity = 128;
+
+    static void record(const RequestTrace& trace) noexcept;
+
+    // 0 - набор медленных запросов не ведётся
+    static void set_slow_threshold(std::chrono::microseconds threshold) noexcept;
+    static std::chrono::microseconds slow_threshold() noexcept;
+
+    // Последние запросы всех потоков, от новых к старым
+    static std::vector<RequestTrace> recent(size_t limit);
+    // Самые медленные запросы выше порога, от медленных к быстрым
+    static std::vector<RequestTrace> slowest();
+    static void reset_slowest();
+
+    // JSON для /debug/slow_requests
+    static std::string render_json(size_t recent_limit);
+};
@@ -0,0 +1,143 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <netinet/in.h>
+
+// Оценка RTT и таймаута повтора по Jacobson/Karels (RFC 6298)
+class RttEstimator {
+public:
+    using Duration = std::chrono::steady_clock::duration;
+
+    RttEstimator(Duration initial_rto, Duration min_rto, Duration max_rto) noexcept
+        : rto_(initial_rto), min_rto_(min_rto), max_rto_(max_rto) {}
+
+    void sample(Duration rtt) noexcept;
+
+    Duration rto() const noexcept { return rto_; }
+    Duration srtt() const noexcept { return srtt_; }
+    Duration rttvar() const noexcept { return rttvar_; }
+    // Задержка дублирующего запроса: к этому времени ответ обычно уже есть (~p95)
+    Duration hedge_delay() const noexcept;
+    bool has_samples() const noexcept { return has_samples_; }
+
+private:
+    Duration srtt_{};
+    Duration rttvar_{};
+    Duration rto_;
+    const Duration min_rto_;
+    const Duration max_rto_;
+    bool has_samples_ = false;
+};
+
+// UDP-клиент с несколькими запросами в полёте на одном connect()-сокете. Запросы
+// помечаются тегом (network/request_tag.h), ответы сопоставляются по нему в
+// собственном потоке epoll. Потерянные запросы повторяются по адаптивному таймауту
+// с экспоненциальной задержкой в пределах бюджета повторов. send потокобезопасен.
+class AsyncUdpClient {
+public:
+    enum class Status {
+        Ok,
+        Timeout,
+        SendFailed,
+        Closed
+    };
+
+    struct Options {
+        std::chrono::milliseconds timeout{2000};        // общий срок запроса со всеми повторами
+        int max_retries = 3;                            // повторов на запрос
+        std::chrono::milliseconds initial_rto{200};     // до первого замера RTT
+        std::chrono::milliseconds min_rto{50};
+        std::chrono::milliseconds max_rto{1000};
+        // Бюджет повторов и дублей: каждый запрос добавляет ratio, накопление не больше burst.
+        // В среднем повторов не больше ratio от числа запросов - при массовой потере клиент
+        // не умножает нагрузку на сервер
+        double retry_budget_ratio = 0.2;
+        double retry_budget_burst = 20;
+    };
+
+    struct Stats {
+        uint64_t requests = 0;
+        uint64_t replies = 0;
+        uint64_t retransmits = 0;
+        uint64_t hedges = 0;
+        uint64_t timeouts = 0;
+        uint64_t budget_exhausted = 0;   // повтор или дубль не отправлен: бюджет исчерпан
+        std::chrono::microseconds srtt{0};
+        std::chrono::microseconds rttvar{0};
+        std::chrono::microseconds rto{0};
+    };
+
+    // Вызывается из потока клиента (или из send при ошибке отправки); payload - ответ без тега
+    using Callback = std::function<void(Status status, std::string_view payload)>;
+
+    AsyncUdpClient(std::string_view server_ip, int server_port);
+    AsyncUdpClient(std::string_view server_ip, int server_port, const Options& options);
+    ~AsyncUdpClient();
+
+    AsyncUdpClient(const AsyncUdpClient&) = delete;
+    AsyncUdpClient& operator=(const AsyncUdpClient&) = delete;
+
+    bool is_initialized() const { return sockfd_ != -1; }
+
+    // hedged - дополнительно отправить дубль, если ответа нет дольше обычного
+    // (для запросов, чувствительных к задержке)
+    void send(std::string_view payload, Callback callback, bool hedged = false);
+
+    size_t in_flight() const;
+    Stats stats() const;
+    static const char* status_name(Status status) noexcept;
+
+private:
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    struct Pending {
+        Callback callback;
+        std::string datagram;       // с тегом, для повторов
+        TimePoint first_sent;
+        TimePoint deadline;         // общий срок
+        TimePoint retransmit_at;
+        TimePoint hedge_at;         // TimePoint::max() - дубль не нужен или уже отправлен
+        int retries = 0;
+        bool resent = false;        // был повтор или дубль: RTT по ответу не замеряется
+        uint32_t generation = 0;    // актуальная запись в timers_
+    };
+
+    struct Timer {
+        TimePoint at;
+        uint32_t tag;
+        uint32_t generation;
+        bool operator>(const Timer& other) const noexcept { return at > other.at; }
+    };
+
+    void event_loop();
+    void handle_datagram(std::string_view datagram);
+    void process_timers(TimePoint now);
+    // Под mutex_: следующее событие запроса (дубль, повтор или срок) в timers_
+    void schedule(uint32_t tag, Pending& pending);
+    bool take_budget();
+
+    int sockfd_ = -1;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    const Options options_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<uint32_t, Pending> pending_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    RttEstimator rtt_;
+    double retry_budget_;
+    Stats stats_;
+    uint32_t next_tag_ = 0;
+
+    std::atomic<bool> running_{false};
+    std::thread loop_thread_;
+};
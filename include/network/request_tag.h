@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Тег запроса для нескольких запросов в полёте на одном сокете: датаграмма
+// 0xFF, тег (4 байта, little-endian), тело. Сервер возвращает тег в начале ответа.
+// Нетегированный запрос с 0xFF начинаться не может: нибл 0xF первым - пустой IMSI.
+class RequestTag {
+public:
+    static constexpr uint8_t kMarker = 0xFF;
+    static constexpr size_t kHeaderSize = 1 + sizeof(uint32_t);
+
+    static void write_header(uint32_t tag, char* out) noexcept {
+        out[0] = static_cast<char>(kMarker);
+        for (size_t i = 0; i < sizeof(tag); ++i) {
+            out[1 + i] = static_cast<char>((tag >> (8 * i)) & 0xFF);
+        }
+    }
+
+    // false - датаграмма без тега, body не меняется
+    static bool parse(std::string_view datagram, uint32_t& tag, std::string_view& body) noexcept {
+        if (datagram.size() < kHeaderSize || static_cast<uint8_t>(datagram[0]) != kMarker) {
+            return false;
+        }
+        tag = 0;
+        for (size_t i = 0; i < sizeof(tag); ++i) {
+            tag |= static_cast<uint32_t>(static_cast<uint8_t>(datagram[1 + i])) << (8 * i);
+        }
+        body = datagram.substr(kHeaderSize);
+        return true;
+    }
+};
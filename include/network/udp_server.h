@@ -5,6 +5,7 @@
 #include <atomic>
 #include <thread>
 #include <sys/epoll.h>
+#include <sys/socket.h>
 #include <netinet/in.h>
 #include <mutex>
 #include <arpa/inet.h>
@@ -15,6 +16,8 @@ public:
     using MessageHandler = std::function<void(const std::string&, const sockaddr_in&)>;
     
     UdpServer(std::string_view ip, int port, MessageHandler handler);
+    // Уже привязанный сокет, переданный прежним процессом (session/session_handoff.h)
+    UdpServer(int sockfd, MessageHandler handler);
     ~UdpServer();
     
     bool start();
@@ -23,11 +26,18 @@ public:
     
     void send(std::string_view message, const sockaddr_in& addr);
 
+    int socket_fd() const noexcept { return sockfd_; }
+
+    // Время в очереди сокета для датаграммы, которую сейчас обрабатывает
+    // message_handler_ (0, если ядро не дало метку); читать только из обработчика
+    uint64_t current_receive_delay_ns() const noexcept { return receive_delay_ns_; }
+
 private:
     void worker_thread();
     bool setup_socket();
     bool setup_epoll();
     void handle_events();
+    void record_queue_delay(const msghdr& msg);
     
     int sockfd_ = -1;
     int epoll_fd_ = -1;
@@ -40,5 +50,6 @@ private:
 
 
     struct sockaddr_in client_addr_;
+    uint64_t receive_delay_ns_ = 0;
     char buffer_[65536]; // Максимальный размер UDP пакета
 };
\ No newline at end of file
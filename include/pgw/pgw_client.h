@@ -1,27 +1,49 @@
 #pragma once
+#include <functional>
+#include <future>
 #include <memory>
 #include <string>
+#include <vector>
 #include "config/client_config.h"
-#include "network/udp_client.h"
+#include "network/async_udp_client.h"
 
 class PgwClient {
 public:
+    // Ответ сервера ("created", "rejected", ...) или ошибка клиента
+    // ("invalid_imsi", "timeout", "network_error", "client_error")
+    using ResponseCallback = std::function<void(std::string response)>;
+
+    static constexpr size_t kDefaultMaxInFlight = 1024;
+
     explicit PgwClient() = default;
     void init(const std::string& config_file);
 
+    // Синхронный запрос: submit + ожидание ответа
     std::string send_imsi(const std::string& imsi);
 
+    // Асинхронные запросы: несколько в полёте на одном сокете, ответ по тегу.
+    // Колбэк вызывается из потока клиента (при ошибке до отправки - сразу).
+    void submit(const std::string& imsi, ResponseCallback callback);
+    std::future<std::string> submit(const std::string& imsi);
+
+    // Ответы в порядке imsis, не больше max_in_flight запросов одновременно
+    std::vector<std::string> send_many(const std::vector<std::string>& imsis,
+                                       size_t max_in_flight = kDefaultMaxInFlight);
+
     void interactive_mode();
+
+    // Повторы, дубли и таймауты транспорта с момента init
+    AsyncUdpClient::Stats transport_stats() const;
     
     // Запрещаем копирование и присваивание
     PgwClient(const PgwClient&) = delete;
     PgwClient& operator=(const PgwClient&) = delete;
 
 private:
-    std::unique_ptr<ClientConfig> config_;      // Конфигурация клиента
-    std::unique_ptr<UdpClient> udp_client_;     // UDP транспорт
+    std::unique_ptr<ClientConfig> config_;          // Конфигурация клиента
+    std::unique_ptr<AsyncUdpClient> udp_client_;    // UDP транспорт
 
     bool is_ready() const {
         return udp_client_ && udp_client_->is_initialized();
     }
-};
\ No newline at end of file
+};
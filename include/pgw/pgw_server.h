@@ -1,19 +1,30 @@
 #pragma once
 #include "config/server_config.h"
 #include "session/session_manager.h"
+#include "session/session_snapshot.h"
+#include "session/session_handoff.h"
 #include "network/udp_server.h"
 #include "http/http_server.h"
+#include "http/cdr_export_server.h"
 #include "cdr/cdr_manager.h"
+#include "session/session_events.h"
 #include "utils/bcd_converter.h"
 #include <memory>
 #include <atomic>
+#include <mutex>
 #include <csignal>
+#include <optional>
 
 class PgwServer {
 public:
     explicit PgwServer() = default;
     void init(const std::string& config_file);
     void run();
+
+    // Перечитать конфигурацию: чёрный список, session_timeout_sec и log_level
+    // применяются без остановки трафика. Возвращает описание результата,
+    // при ошибке бросает исключение, текущая конфигурация остаётся в силе.
+    std::string reload_config();
     
     // Запрещаем копирование и присваивание
     PgwServer(const PgwServer&) = delete;
@@ -22,19 +33,39 @@ public:
 private:
     // Конфигурация сервера
     std::unique_ptr<ServerConfig> config_;
+    std::string config_file_;
+    std::mutex reload_mutex_;
     
     // Основные компоненты
     std::shared_ptr<CdrManager> cdr_manager_;
+    std::shared_ptr<SessionEventBus> event_bus_;
     std::unique_ptr<SessionManager> session_manager_;
+    std::unique_ptr<SessionSnapshotter> session_snapshotter_;
+    // Репликация на резервный узел (session/session_replication.h): одно из двух
+    std::unique_ptr<SessionReplicator> session_replicator_;
+    std::unique_ptr<ReplicationReceiver> replication_receiver_;
     std::unique_ptr<UdpServer> udp_server_;
     std::unique_ptr<HttpServer> http_server_;
+    std::unique_ptr<CdrExportServer> cdr_export_server_;
+
+    // Передача работы между версиями бинарника (session/session_handoff.h)
+    std::unique_ptr<HandoffClient> handoff_client_;      // до подтверждения старому процессу
+    std::unique_ptr<HandoffListener> handoff_listener_;
+    // Очистка сессий не идёт, пока таблица передаётся новому процессу
+    std::mutex maintenance_mutex_;
 
     void setup_http_server();
 
+    // Отдать сокеты и сессии подключившемуся новому процессу. true - он принимает трафик
+    // и этот процесс завершается; false - работа продолжается
+    bool hand_off();
+
     void handle_udp_message(const std::string& message, const sockaddr_in& client_addr);
 
-    void send_udp_response(const std::string& response, const sockaddr_in& addr);
+    // tag - тег запроса, если он был (network/request_tag.h)
+    void send_udp_response(std::string_view response, const sockaddr_in& addr, std::optional<uint32_t> tag);
 };
 
 // Объявление глобального флага для обработки сигналов
-extern std::atomic<bool> shutdown_flag;
\ No newline at end of file
+extern std::atomic<bool> shutdown_flag;
+extern std::atomic<bool> reload_flag;
\ No newline at end of file
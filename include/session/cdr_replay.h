@@ -0,0 +1,44 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CdrManager;
+class SessionManager;
+
+struct CdrReplayStats {
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    uint64_t records = 0;
+    uint64_t restored = 0;
+    uint64_t expired = 0;           // последняя запись created/prolonged старше session_timeout_sec
+    double seconds = 0;
+
+    double records_per_sec() const {
+        return seconds > 0 ? static_cast<double>(records) / seconds : 0;
+    }
+};
+
+// Восстановление таблицы сессий по файлам CDR, без отдельного снимка. Для каждого IMSI
+// важна последняя запись: created/prolonged - сессия жива до времени записи плюс
+// session_timeout_sec, expired/graceful_removal - сессии нет. Время в CDR с точностью
+// до секунды, поэтому сессия может истечь до секунды раньше, чем до перезапуска.
+//
+// Файлы режутся на куски по границам строк; куски разбирают threads потоков, раскладывая
+// последние записи по корзинам хеша IMSI, затем корзины сводятся тоже параллельно.
+class CdrReplay {
+public:
+    static constexpr size_t kDefaultChunkBytes = 8 << 20;
+
+    // Файлы, где могут быть записи живых сессий: закрытые сегменты, изменённые за
+    // последние window, и текущий файл; от старых к новым
+    static std::vector<std::string> recent_files(const CdrManager& cdr_manager, std::chrono::seconds window);
+
+    // files - от старых к новым. Результат загружается в session_manager (restore_sessions);
+    // IMSI из текущего чёрного списка пропускаются
+    static CdrReplayStats restore(const std::vector<std::string>& files, int session_timeout_sec,
+                                  SessionManager& session_manager, unsigned threads,
+                                  size_t chunk_bytes = kDefaultChunkBytes);
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "utils/imsi.h"
+
+enum class SessionEventType : uint8_t {
+    Created,
+    Prolonged,
+    Expired,
+    Removed
+};
+
+// Событие фиксированного размера: в кольце подписчика нет аллокаций
+struct SessionEvent {
+    SessionEventType type;
+    Imsi imsi;
+    int64_t timestamp_ms;   // system_clock, мс с эпохи
+};
+
+// Подписка: кольцо одного производителя и одного потребителя на атомарных индексах.
+// Производитель никогда не ждёт потребителя: при переполнении затирает самые старые
+// события, потребитель замечает это по номерам ячеек и учитывает их в dropped.
+// Производителей сериализует SessionEventBus; потребитель - один поток SSE.
+class SessionSubscription {
+public:
+    explicit SessionSubscription(size_t capacity);
+
+    // Только под блокировкой производителей шины; без ожидания потребителя
+    void push(const SessionEvent& event) noexcept;
+
+    // Ждёт события не дольше timeout, забирает всё накопленное в out.
+    // Возвращает число событий, потерянных с прошлого вызова.
+    uint64_t drain(std::vector<SessionEvent>& out, std::chrono::milliseconds timeout);
+
+    void close();
+    bool closed() const noexcept { return closed_.load(std::memory_order_relaxed); }
+
+private:
+    // Ячейка с последовательным номером, как в ShmSessionTable: seq нечётный во время
+    // записи, 2 * (номер события + 1) после неё
+    struct Slot {
+        std::atomic<uint64_t> seq{0};
+        std::atomic<uint64_t> key{0};
+        std::atomic<int64_t> timestamp_ms{0};
+        std::atomic<uint8_t> type{0};
+    };
+
+    std::unique_ptr<Slot[]> ring_;
+    const size_t capacity_;
+    alignas(64) std::atomic<uint64_t> head_{0};   // следующий номер события; пишет производитель
+    alignas(64) uint64_t tail_ = 0;               // первое непрочитанное; только потребитель
+
+    std::mutex close_mutex_;                      // только для пробуждения при close()
+    std::condition_variable cv_;
+    std::atomic<bool> closed_{false};
+};
+
+// Шина событий сессий: публикуется в тех же местах, где SessionManager пишет CDR
+class SessionEventBus {
+public:
+    static constexpr size_t kDefaultCapacity = 16384;
+
+    explicit SessionEventBus(size_t max_subscribers = 4);
+    ~SessionEventBus();
+
+    void publish(SessionEventType type, Imsi imsi) noexcept;
+
+    // nullptr, если достигнут предел подписчиков
+    std::shared_ptr<SessionSubscription> subscribe(size_t capacity = kDefaultCapacity);
+    void unsubscribe(const std::shared_ptr<SessionSubscription>& subscription);
+
+    // Закрыть все подписки (остановка сервера)
+    void close();
+
+    size_t subscriber_count() const;
+    static const char* type_name(SessionEventType type) noexcept;
+
+private:
+    const size_t max_subscribers_;
+    // Держат только производители (publish делает каждое кольцо однопоточным по записи)
+    // и короткие subscribe/unsubscribe; потребители её не берут
+    mutable std::mutex mutex_;
+    std::vector<std::shared_ptr<SessionSubscription>> subscribers_;
+    std::atomic<size_t> active_{0};   // быстрая проверка без блокировки, когда подписчиков нет
+};
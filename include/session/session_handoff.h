@@ -0,0 +1,121 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class SessionManager;
+struct SessionInfo;
+
+// Слушающие сокеты, которые старый процесс отдаёт новому; -1 - сокета нет
+struct HandoffSockets {
+    int udp_fd = -1;
+    int cdr_export_fd = -1;
+};
+
+// Передача работы новому бинарнику без graceful_shutdown (обновление без простоя).
+//
+// Старый процесс слушает Unix-сокет handoff_socket. Передача в две фазы, чтобы трафик
+// стоял только на время второй:
+//  1. Новый подключается; старый, не прерывая работы, присылает всю таблицу сессий.
+//     Новый тем временем строит менеджеры (CDR, журнал, сессии) и загружает эту таблицу.
+//  2. Новый просит переключения. Старый останавливает приём UDP, последний раз чистит
+//     истёкшие сессии, дописывает CDR и отдаёт через SCM_RIGHTS сокет UDP (и сокет
+//     выгрузки CDR) вместе с сессиями, созданными и продлёнными после фазы 1, и моментом
+//     очистки: всё, что истекло к нему, старый уже закрыл с записью CDR. Датаграммы ждут
+//     в очереди того же сокета и читаются новым процессом.
+// Новый применяет изменения, удаляет закрытые старым сессии и подтверждает, что принимает
+// трафик; старый завершается без записей CDR. Если подтверждения нет, старый продолжает работу.
+//
+// Протокол (little-endian): запрос - magic "PGWHOFF1"; ответ фазы 1 - заголовок (magic,
+// u32 версия, u32 маска сокетов, u64 число сессий, i64 момент очистки), затем по 16 байт
+// на сессию: u64 Imsi::key(), i64 срок по steady_clock, нс (CLOCK_MONOTONIC общий для всех
+// процессов хоста); запрос переключения - байт 'S'; ответ фазы 2 - такой же заголовок с
+// маской сокетов (бит 0 - UDP, бит 1 - выгрузка CDR) и сессиями; подтверждение - байт 'R'.
+class HandoffListener {
+public:
+    // Старый сокетный файл по path удаляется. Исключение std::runtime_error, если сокет не создать
+    explicit HandoffListener(std::string path);
+    ~HandoffListener();
+
+    HandoffListener(const HandoffListener&) = delete;
+    HandoffListener& operator=(const HandoffListener&) = delete;
+
+    // Принять запрос нового процесса, если он есть; не блокирует
+    bool accept_request();
+
+    // Фаза 1: вся таблица страницами list_sessions, трафик не останавливается.
+    // false - новый процесс отключился
+    bool send_sessions(const SessionManager& session_manager);
+
+    // Ждать запроса переключения
+    bool wait_switch(std::chrono::milliseconds timeout);
+
+    // Фаза 2: сокеты и изменения после фазы 1. Таблица заморожена (UDP и очистка стоят),
+    // сессии со сроком до cleaned_at уже закрыты
+    bool send_state(const HandoffSockets& sockets, const SessionManager& session_manager,
+                    std::chrono::steady_clock::time_point cleaned_at);
+
+    // Ждать подтверждения, что новый процесс принимает трафик
+    bool wait_ready(std::chrono::milliseconds timeout);
+
+    // Закрыть текущее подключение (откат)
+    void reset();
+
+    uint64_t sessions_sent() const noexcept { return sessions_sent_; }
+    uint64_t changes_sent() const noexcept { return changes_sent_; }
+    const std::string& path() const noexcept { return path_; }
+
+private:
+    std::string path_;
+    int listen_fd_ = -1;
+    int conn_fd_ = -1;
+    uint64_t inode_ = 0;
+    uint64_t queue_mark_ = 0;       // позиция очереди истечения на момент фазы 1
+    uint64_t sessions_sent_ = 0;
+    uint64_t changes_sent_ = 0;
+
+    bool wait_byte(char expected, std::chrono::milliseconds timeout);
+};
+
+class HandoffClient {
+public:
+    // Подключиться к работающему процессу и получить таблицу (фаза 1). nullptr, если по path
+    // никто не слушает (обычный старт); при обрыве посреди передачи - std::runtime_error
+    static std::unique_ptr<HandoffClient> connect(const std::string& path, std::chrono::milliseconds timeout);
+    ~HandoffClient();
+
+    HandoffClient(const HandoffClient&) = delete;
+    HandoffClient& operator=(const HandoffClient&) = delete;
+
+    // Фаза 2: старый процесс останавливает трафик и отдаёт сокеты и изменения.
+    // Таблица фазы 1 должна быть уже забрана take_sessions. std::runtime_error при обрыве
+    void switch_over();
+
+    // Сокеты переходят к вызывающему; не забранные закрываются в деструкторе
+    HandoffSockets release_sockets();
+
+    // Сессии по возрастанию expires_at - вход SessionManager::restore_sessions. После connect -
+    // таблица фазы 1, после switch_over - только изменения фазы 2 без закрытых старым процессом
+    std::vector<SessionInfo> take_sessions();
+
+    // После switch_over: сессии со сроком до этого момента старый процесс закрыл с записью CDR,
+    // их удаляет SessionManager::drop_closed_sessions
+    std::chrono::steady_clock::time_point cleaned_at() const noexcept { return cleaned_at_; }
+
+    // Трафик принимается: старый процесс может завершаться
+    bool ready();
+
+    uint64_t changes_received() const noexcept { return changes_received_; }
+
+private:
+    HandoffClient() = default;
+
+    int conn_fd_ = -1;
+    std::string path_;
+    HandoffSockets sockets_;
+    std::vector<SessionInfo> sessions_;
+    uint64_t changes_received_ = 0;
+    std::chrono::steady_clock::time_point cleaned_at_{};
+};
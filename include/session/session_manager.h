@@ -7,21 +7,93 @@
 #include <fstream>
 #include <deque>
 #include <string_view>
+#include <span>
+#include <vector>
 #include "utils/logger.h"
 #include "cdr/cdr_manager.h"
+#include "session/session_events.h"
+#include "session/session_snapshot.h"
+#include "session/session_replication.h"
+#include "session/shm_session_table.h"
+#include "utils/imsi.h"
+
+// Позиция обхода таблицы сессий: номер корзины unordered_map и число корзин
+// на момент выдачи курсора (после рехеширования обход начинается заново)
+struct SessionCursor {
+    size_t bucket_count = 0;
+    size_t bucket = 0;
+
+    // Текстовый вид "<bucket_count>-<bucket>"; "0" - начало обхода
+    std::string to_string() const;
+    static SessionCursor parse(std::string_view text);
+};
+
+struct SessionInfo {
+    Imsi imsi;
+    std::chrono::steady_clock::time_point expires_at;
+};
+
+struct SessionPage {
+    std::vector<SessionInfo> sessions;
+    SessionCursor next;
+    bool done = false;
+    bool restarted = false;  // таблица рехеширована, обход начат с начала: возможны повторы
+};
+
+// Параметры, которые меняются при перезагрузке конфигурации. Объект неизменяем:
+// новая версия публикуется целиком через Rcu
+struct SessionPolicy {
+    int session_timeout_sec;
+    std::unordered_set<Imsi> blacklist;
+};
 
 class SessionManager {
 public:
     SessionManager(
         std::shared_ptr<CdrManager> cdr_manager,
         int session_timeout_sec,
-        const std::vector<std::string>& blacklist
+        const std::vector<std::string>& blacklist,
+        std::shared_ptr<SessionEventBus> event_bus = nullptr,
+        std::shared_ptr<ShmSessionTable> shm_table = nullptr,
+        std::shared_ptr<SessionJournal> journal = nullptr,
+        std::shared_ptr<ReplicationLog> replication = nullptr
     );
-    bool create_session(std::string_view imsi);
-    bool session_exists(std::string_view imsi) const;
-    void cleanup_expired_sessions();
+    ~SessionManager();
+    bool create_session(Imsi imsi);
+    bool session_exists(Imsi imsi) const;
+    // Проверка пачки IMSI за один захват блокировки
+    std::vector<bool> sessions_exist(std::span<const Imsi> imsis) const;
+    size_t session_count() const;
+    // Страница обхода: не больше limit сессий (плюс остаток последней корзины)
+    // под короткой разделяемой блокировкой
+    SessionPage list_sessions(SessionCursor cursor, size_t limit) const;
+    void cleanup_expired_sessions(std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+    // Передача работы: сессии со сроком до cleaned_at прежний процесс уже закрыл с записью
+    // CDR; здесь они удаляются, как на резервном узле, без CDR, событий и метрик
+    void drop_closed_sessions(std::chrono::steady_clock::time_point cleaned_at);
+    // Загрузка восстановленных сессий (снимок, CDR, прежний процесс) до начала трафика;
+    // sessions упорядочены по expires_at. CDR не пишутся, в журнал - Upsert каждой сессии
+    void restore_sessions(std::vector<SessionInfo> sessions);
+    // Сессии по возрастанию expires_at (по очереди истечения) под одной разделяемой
+    // блокировкой - только при замороженной таблице (фаза 2 передачи работы); обход без
+    // остановки трафика - list_sessions. since - значение *next из прошлого вызова или
+    // expiry_position(): только созданные и продлённые после него
+    std::vector<SessionInfo> sessions_by_expiry(uint64_t since = 0, uint64_t* next = nullptr) const;
+    // Текущая позиция очереди истечения - since для sessions_by_expiry. Снятая перед обходом
+    // list_sessions, покрывает всё, что изменится во время обхода
+    uint64_t expiry_position() const;
+    // Изменения от основного узла (ReplicationReceiver): без CDR, событий и метрик
+    void apply_replicated(std::span<const ReplicatedChange> changes);
+    // Таблицу ведёт основной узел: истечение при очистке без CDR и событий,
+    // их пишет основной узел
+    void set_replica(bool replica) noexcept { replica_.store(replica, std::memory_order_relaxed); }
     void graceful_shutdown(int sessions_per_sec);
-    bool is_blacklisted(const std::string& imsi) const;
+    bool is_blacklisted(Imsi imsi) const;
+
+    // Новые таймаут и чёрный список; действуют для следующих запросов,
+    // уже созданные сессии не трогаются
+    void update_policy(int session_timeout_sec, const std::vector<std::string>& blacklist);
+    int session_timeout_sec() const;
 
 private:
     struct Session {
@@ -29,14 +101,25 @@ private:
     };
 
     mutable std::shared_mutex sessions_mutex_;
-    std::unordered_map<std::string, Session> sessions_;
-    std::deque<std::pair<std::chrono::steady_clock::time_point, std::string>> expiry_queue_;
-    std::unordered_set<std::string> blacklist_;
+    std::unordered_map<Imsi, Session> sessions_;
+    std::deque<std::pair<std::chrono::steady_clock::time_point, Imsi>> expiry_queue_;
+    uint64_t expiry_pushed_ = 0;    // всего добавлено в expiry_queue_: позиция для sessions_by_expiry
 
     std::shared_ptr<CdrManager> cdr_manager_;
+    std::shared_ptr<SessionEventBus> event_bus_;
+    // Зеркало sessions_ для локальных процессов; пишется под sessions_mutex_
+    std::shared_ptr<ShmSessionTable> shm_table_;
+    // Журнал изменений для снимков; пишется под sessions_mutex_
+    std::shared_ptr<SessionJournal> journal_;
+    // Изменения для резервного узла; пишутся под sessions_mutex_
+    std::shared_ptr<ReplicationLog> replication_;
+    std::atomic<const SessionPolicy*> policy_;
+    std::mutex policy_update_mutex_;
+    std::atomic<bool> replica_{false};
     std::mutex cdr_mutex_;
-    const int session_timeout_sec_;
 
-    void write_cdr(std::string_view imsi, std::string_view action) const;
-    bool validate_imsi(std::string_view imsi) const;
+    void expire_sessions(std::chrono::steady_clock::time_point now, bool replica);
+    void write_cdr(Imsi imsi, std::string_view action) const;
+    void publish_event(SessionEventType type, Imsi imsi) const;
+    const SessionPolicy* make_policy(int session_timeout_sec, const std::vector<std::string>& blacklist) const;
 };
\ No newline at end of file
@@ -0,0 +1,152 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#include "session/session_snapshot.h"
+#include "utils/imsi.h"
+
+class SessionManager;
+
+// Изменение таблицы сессий, полученное резервным узлом
+struct ReplicatedChange {
+    SessionJournal::Op op;
+    Imsi imsi;
+    std::chrono::steady_clock::time_point expires_at;
+};
+
+// Буфер изменений для резервного узла. SessionManager дописывает в него под эксклюзивной
+// блокировкой таблицы (как в SessionJournal), SessionReplicator забирает пачками. Пока
+// резервный узел не подключён, append ничего не копит: одна атомарная проверка.
+class ReplicationLog {
+public:
+    void append(SessionJournal::Op op, Imsi imsi, std::chrono::steady_clock::time_point expires_at = {});
+
+    // Начать копить изменения (резервный узел подключён) и перестать с очисткой буфера
+    void activate();
+    void deactivate();
+
+    // Забрать накопленное: записи по 17 байт в формате журнала. oldest - момент первой из них
+    bool take(std::vector<char>& out, std::chrono::steady_clock::time_point& oldest);
+
+    bool active() const noexcept { return active_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> active_{false};
+    std::mutex mutex_;
+    std::vector<char> buffer_;
+    std::chrono::steady_clock::time_point oldest_;
+};
+
+struct ReplicationStats {
+    bool connected = false;
+    uint64_t frames = 0;
+    uint64_t records = 0;
+    uint64_t raw_bytes = 0;
+    uint64_t compressed_bytes = 0;
+    uint64_t full_syncs = 0;
+    double lag_ms = 0;      // от изменения на основном узле до подтверждения его применения
+};
+
+// Репликация таблицы сессий на резервный узел (active/standby).
+//
+// Основной узел подключается к резервному по TCP. Сначала он шлёт всю таблицу (полная
+// синхронизация), затем раз в batch_interval - накопленные изменения: создание и
+// продление (Upsert), истечение и удаление (Erase). Пачка сжимается zlib. Резервный узел
+// применяет её к своей таблице без записи CDR и эхом возвращает момент самого старого
+// изменения пачки: задержка считается по часам основного узла, синхронизация часов
+// узлов не нужна. Без изменений раз в секунду уходит пустая пачка (проверка связи).
+//
+// Протокол (little-endian): при подключении - magic "PGWREPL1"; пачка - заголовок
+// (u32 байт сжатых данных, u32 записей, u32 флаги, u32 байт до сжатия, i64 steady_ns
+// отправки, i64 steady_ns самого старого изменения), затем сжатые записи журнала по
+// 17 байт. Сроки переводятся на часы резервного узла относительно момента отправки.
+// Флаги: 1 - часть полной синхронизации, 2 - её последняя пачка (сессии, которых в
+// синхронизации не было, резервный узел удаляет). Ответ на пачку - i64 steady_ns её
+// самого старого изменения.
+class SessionReplicator {
+public:
+    SessionReplicator(SessionManager& session_manager, std::shared_ptr<ReplicationLog> log,
+                      std::string standby_ip, int standby_port, std::chrono::milliseconds batch_interval);
+    ~SessionReplicator();
+
+    SessionReplicator(const SessionReplicator&) = delete;
+    SessionReplicator& operator=(const SessionReplicator&) = delete;
+
+    // Фоновый поток: подключение (с повтором раз в секунду), синхронизация, пачки
+    void start();
+    void stop();
+
+    ReplicationStats stats() const;
+
+private:
+    SessionManager& session_manager_;
+    std::shared_ptr<ReplicationLog> log_;
+    const std::string standby_ip_;
+    const int standby_port_;
+    const std::chrono::milliseconds batch_interval_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::thread worker_;
+
+    mutable std::mutex stats_mutex_;
+    ReplicationStats stats_;
+    std::vector<unsigned char> compressed_;     // только поток репликации
+
+    void run();
+    bool wait(std::chrono::milliseconds timeout);
+    // Ждать следующей пачки, читая подтверждения по мере прихода: задержка меряется
+    // без ошибки на интервал пачки. true - остановка, ok = false - связь потеряна
+    bool wait_batch(int fd, bool& ok);
+    int connect_standby();
+    bool full_sync(int fd);
+    bool send_frame(int fd, const char* records, size_t count, uint32_t flags,
+                    std::chrono::steady_clock::time_point oldest);
+    bool read_acks(int fd);
+};
+
+// Приём репликации на резервном узле. Одно подключение основного узла; новое подключение
+// (например, основной узел обновлён без простоя) заменяет старое. Пока основной узел
+// подключён, SessionManager работает как реплика: истечение сессий без CDR.
+class ReplicationReceiver {
+public:
+    // Исключение std::runtime_error, если порт не открыть; port 0 - любой свободный
+    ReplicationReceiver(SessionManager& session_manager, const std::string& ip, int port);
+    ~ReplicationReceiver();
+
+    ReplicationReceiver(const ReplicationReceiver&) = delete;
+    ReplicationReceiver& operator=(const ReplicationReceiver&) = delete;
+
+    void start();
+    void stop();
+
+    int port() const noexcept { return port_; }
+    ReplicationStats stats() const;
+
+private:
+    SessionManager& session_manager_;
+    int listen_fd_ = -1;
+    int port_ = 0;
+
+    std::atomic<bool> stopping_{false};
+    std::thread worker_;
+
+    mutable std::mutex stats_mutex_;
+    ReplicationStats stats_;
+    std::vector<unsigned char> payload_;
+    std::vector<unsigned char> raw_;
+
+    void run();
+    void accept_primary(int& conn_fd);
+    bool receive_frame(int fd, std::vector<ReplicatedChange>& changes, std::vector<uint64_t>& synced);
+    void drop_unsynced(std::vector<ReplicatedChange>& changes, std::vector<uint64_t>& synced);
+    void set_connected(bool connected);
+};
@@ -0,0 +1,122 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utils/imsi.h"
+
+class SessionManager;
+struct SessionInfo;
+
+// Журнал изменений таблицы сессий между снимками: <dir>/journal.<N>, только дописывается.
+// Записи копятся в памяти и сбрасываются в файл фоновым потоком SessionSnapshotter;
+// после падения процесса теряется не больше одного интервала сброса (100 мс).
+//
+// Формат (little-endian): заголовок - magic "PGWJRNL1", u64 номер, i64 wall_ns и i64 steady_ns
+// одного момента (по ним сроки переводятся в системное время), затем записи по 17 байт:
+// u8 операция, u64 Imsi::key(), i64 срок истечения по steady_clock, нс.
+class SessionJournal {
+public:
+    enum class Op : uint8_t {
+        Upsert = 1,
+        Erase = 2
+    };
+
+    // Открывает новый журнал с номером больше всех найденных в dir
+    explicit SessionJournal(std::string dir);
+    ~SessionJournal();
+
+    SessionJournal(const SessionJournal&) = delete;
+    SessionJournal& operator=(const SessionJournal&) = delete;
+
+    // Вызывается под эксклюзивной блокировкой таблицы сессий: порядок записей
+    // совпадает с порядком изменений
+    void append(Op op, Imsi imsi, std::chrono::steady_clock::time_point expires_at = {});
+
+    // Дописать накопленное в файл (без fsync)
+    void flush();
+
+    // Сбросить текущий журнал на диск и начать следующий; возвращает его номер
+    uint64_t rotate();
+
+    uint64_t sequence() const;
+    const std::string& dir() const noexcept { return dir_; }
+
+private:
+    std::string dir_;
+    std::mutex buffer_mutex_;
+    std::vector<char> buffer_;
+    mutable std::mutex file_mutex_;     // flush и rotate
+    int fd_ = -1;
+    uint64_t sequence_ = 0;
+
+    void open_journal(uint64_t sequence);
+};
+
+// Части, каждая упорядочена по expires_at, - в один упорядоченный массив (очередь истечения
+// SessionManager::restore_sessions). Слияние попарное, пары одного уровня параллельно
+std::vector<SessionInfo> merge_by_expiry(std::vector<std::vector<SessionInfo>> parts);
+
+struct SessionRestoreStats {
+    uint64_t snapshot_sessions = 0;
+    uint64_t journal_records = 0;
+    uint64_t restored = 0;
+    uint64_t expired = 0;           // истекли по системным часам, пока сервер не работал
+    double seconds = 0;
+
+    double records_per_sec() const {
+        return seconds > 0 ? static_cast<double>(snapshot_sessions + journal_records) / seconds : 0;
+    }
+};
+
+// Периодические снимки таблицы сессий в <dir>/sessions.snap и восстановление при старте.
+//
+// Снимок пишется постранично через list_sessions: блокировка таблицы держится на одну
+// страницу, UDP-поток не останавливается. Перед обходом журнал переключается на новый
+// номер, и этот номер записывается в снимок: изменения, сделанные во время обхода, есть
+// в журнале и при восстановлении применяются поверх снимка. Снимок пишется во временный
+// файл, fsync и rename; старые журналы удаляются только после этого.
+//
+// Снимок: magic "PGWSNAP1", u64 номер журнала, u64 число записей, i64 время записи
+// (system_clock, нс), затем записи по 16 байт: u64 Imsi::key(), i64 срок по system_clock, нс.
+class SessionSnapshotter {
+public:
+    SessionSnapshotter(SessionManager& session_manager, std::shared_ptr<SessionJournal> journal,
+                       std::chrono::seconds interval);
+    ~SessionSnapshotter();
+
+    SessionSnapshotter(const SessionSnapshotter&) = delete;
+    SessionSnapshotter& operator=(const SessionSnapshotter&) = delete;
+
+    // Фоновый поток: сброс журнала каждые 100 мс, снимок - сразу и затем раз в interval
+    void start();
+    // Остановить поток и сбросить журнал
+    void stop();
+
+    // Снимок синхронно; возвращает число сессий в нём
+    uint64_t write_snapshot();
+
+    // Загрузить снимок и журналы из dir в пустой session_manager. Записи снимка
+    // разбираются threads потоками; сессии с истёкшим по системным часам сроком
+    // отбрасываются. Повреждённый снимок - исключение std::runtime_error
+    static SessionRestoreStats restore(const std::string& dir, SessionManager& session_manager,
+                                       unsigned threads);
+
+    static std::string snapshot_path(const std::string& dir);
+
+private:
+    SessionManager& session_manager_;
+    std::shared_ptr<SessionJournal> journal_;
+    const std::chrono::seconds interval_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    std::thread worker_;
+
+    void run();
+};
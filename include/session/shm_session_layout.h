@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Раскладка таблицы сессий в разделяемой памяти (shm_open). Пишет только сервер
+// (ShmSessionTable), читают локальные процессы (ShmSessionReader). Меняется раскладка -
+// увеличивается kLayoutVersion: читатель старой версии откажется открывать регион.
+//
+// Открытая адресация с линейным пробированием, ключ - Imsi::key(). Удаление оставляет
+// надгробие, цепочки пробирования не сдвигаются. Каждый слот защищён своим seqlock,
+// вся таблица - общим table_seq (нечётный на время перестроения таблицы).
+namespace shm_session {
+
+inline constexpr uint64_t kMagic = 0x3153534557475050ULL;   // "PPGWESS1"
+inline constexpr uint32_t kLayoutVersion = 1;
+
+inline constexpr uint64_t kEmptyKey = 0;        // пустой Imsi
+inline constexpr uint64_t kTombstoneKey = 1;    // длина 1 - ни одному IMSI не равен
+
+enum class State : uint32_t {
+    Initializing = 0,
+    Ready = 1,
+    Overflow = 2,   // таблица переполнена, сервер перестал её вести
+    Closed = 3      // сервер остановлен или пересоздал регион: нужно открыть заново
+};
+
+struct alignas(64) Header {
+    uint64_t magic;
+    uint32_t layout_version;
+    uint32_t slot_size;
+    uint64_t slot_count;                    // степень двойки
+    uint32_t writer_pid;
+    std::atomic<uint32_t> state;
+    std::atomic<uint64_t> table_seq;
+    std::atomic<uint64_t> live_count;
+    std::atomic<uint64_t> generation;       // время создания региона (system_clock, нс)
+};
+
+struct Slot {
+    std::atomic<uint32_t> seq;
+    uint32_t reserved;
+    std::atomic<uint64_t> key;
+    std::atomic<int64_t> expires_ns;        // steady_clock (CLOCK_MONOTONIC), общий для процессов хоста
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "shared-memory atomics must be lock-free");
+static_assert(sizeof(Slot) == 24);
+
+inline constexpr size_t region_size(uint64_t slot_count) noexcept {
+    return sizeof(Header) + slot_count * sizeof(Slot);
+}
+
+inline Slot* slots(Header* header) noexcept {
+    return reinterpret_cast<Slot*>(reinterpret_cast<char*>(header) + sizeof(Header));
+}
+
+inline const Slot* slots(const Header* header) noexcept {
+    return reinterpret_cast<const Slot*>(reinterpret_cast<const char*>(header) + sizeof(Header));
+}
+
+// Перемешивание ключа (финализатор splitmix64): одинаково в сервере и читателях,
+// в отличие от std::hash
+inline constexpr uint64_t hash(uint64_t key) noexcept {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return key;
+}
+
+} // namespace shm_session
@@ -0,0 +1,177 @@
+#pragma once
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <string>
+#include "session/shm_session_layout.h"
+#include "utils/imsi.h"
+
+// Чтение таблицы сессий PGW из разделяемой памяти без RPC и копирования.
+// Заголовочная библиотека: достаточно этого файла, shm_session_layout.h и utils/imsi.h.
+//
+//   ShmSessionReader reader("/pgw_sessions");
+//   if (reader.lookup(imsi) == ShmSessionReader::Status::Active) { ... }
+//
+// Unavailable - региона нет, сервер остановлен или таблица переполнена: нужно
+// вызвать reopen() позже или спросить сервер по HTTP. Объект не потокобезопасен
+// только для open/reopen; lookup можно звать из любого числа потоков.
+class ShmSessionReader {
+public:
+    enum class Status {
+        Active,
+        NotFound,
+        Unavailable
+    };
+
+    explicit ShmSessionReader(std::string name) : name_(std::move(name)) { open(); }
+    ~ShmSessionReader() { close(); }
+
+    ShmSessionReader(const ShmSessionReader&) = delete;
+    ShmSessionReader& operator=(const ShmSessionReader&) = delete;
+
+    bool is_open() const noexcept { return header_ != nullptr; }
+
+    // Переоткрыть регион (после перезапуска сервера)
+    bool reopen() {
+        close();
+        return open();
+    }
+
+    // Сессия есть в таблице сервера (как SessionManager::session_exists).
+    // expires_ns - момент истечения по steady_clock, если нужен
+    Status lookup(Imsi imsi, int64_t* expires_ns = nullptr) const noexcept {
+        if (!header_ || imsi.empty()) return Status::Unavailable;
+
+        const uint64_t key = imsi.key();
+        const uint64_t mask = header_->slot_count - 1;
+        const shm_session::Slot* table = shm_session::slots(header_);
+
+        for (int attempt = 0; attempt < kMaxAttempts; ++attempt) {
+            if (state() != shm_session::State::Ready) return Status::Unavailable;
+            const uint64_t table_seq = header_->table_seq.load(std::memory_order_acquire);
+            if (table_seq & 1) {
+                backoff(attempt);
+                continue;
+            }
+
+            Status result = Status::NotFound;
+            int64_t expires = 0;
+            bool torn = false;
+            uint64_t index = shm_session::hash(key) & mask;
+            for (uint64_t probe = 0; probe <= mask; ++probe, index = (index + 1) & mask) {
+                // Для пробирования хватает атомарного ключа; seqlock слота - только
+                // за согласованной парой ключ/срок найденной сессии
+                const uint64_t slot_key = table[index].key.load(std::memory_order_acquire);
+                if (slot_key == shm_session::kEmptyKey) break;
+                if (slot_key != key) continue;
+
+                uint64_t stable_key = 0;
+                if (!read_slot(table[index], stable_key, expires)) {
+                    torn = true;
+                } else if (stable_key == key) {
+                    result = Status::Active;
+                } else {
+                    torn = true;    // слот переписан между чтениями - повторяем поиск
+                }
+                break;
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (torn || header_->table_seq.load(std::memory_order_relaxed) != table_seq) {
+                continue;
+            }
+            if (result == Status::Active && expires_ns) *expires_ns = expires;
+            return result;
+        }
+        // Запись не завершается (сервер остановлен посреди записи?) - не ждём бесконечно
+        return Status::Unavailable;
+    }
+
+    bool is_active(Imsi imsi) const noexcept { return lookup(imsi) == Status::Active; }
+
+    uint64_t session_count() const noexcept {
+        return header_ ? header_->live_count.load(std::memory_order_relaxed) : 0;
+    }
+
+    // Меняется, когда сервер пересоздаёт регион
+    uint64_t generation() const noexcept {
+        return header_ ? header_->generation.load(std::memory_order_relaxed) : 0;
+    }
+
+    shm_session::State state() const noexcept {
+        return header_ ? static_cast<shm_session::State>(header_->state.load(std::memory_order_acquire))
+                       : shm_session::State::Closed;
+    }
+
+private:
+    static constexpr int kMaxAttempts = 1 << 16;
+    static constexpr int kSlotAttempts = 1 << 10;
+    static constexpr int kSpinAttempts = 64;
+
+    bool open() {
+        const int fd = ::shm_open(name_.c_str(), O_RDONLY, 0);
+        if (fd < 0) return false;
+
+        struct stat info{};
+        if (::fstat(fd, &info) < 0 || static_cast<size_t>(info.st_size) < sizeof(shm_session::Header)) {
+            ::close(fd);
+            return false;
+        }
+        void* mapping = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) return false;
+
+        const auto* header = static_cast<const shm_session::Header*>(mapping);
+        if (header->magic != shm_session::kMagic || header->layout_version != shm_session::kLayoutVersion ||
+            header->slot_size != sizeof(shm_session::Slot) ||
+            shm_session::region_size(header->slot_count) > static_cast<size_t>(info.st_size)) {
+            ::munmap(mapping, static_cast<size_t>(info.st_size));
+            return false;
+        }
+        header_ = header;
+        mapped_size_ = static_cast<size_t>(info.st_size);
+        return true;
+    }
+
+    void close() noexcept {
+        if (header_) {
+            ::munmap(const_cast<shm_session::Header*>(header_), mapped_size_);
+            header_ = nullptr;
+        }
+    }
+
+    // Согласованная пара ключ/срок слота; false - слот долго под записью
+    static bool read_slot(const shm_session::Slot& slot, uint64_t& key, int64_t& expires) noexcept {
+        for (int attempt = 0; attempt < kSlotAttempts; ++attempt) {
+            const uint32_t seq = slot.seq.load(std::memory_order_acquire);
+            if (seq & 1) {
+                backoff(attempt);
+                continue;
+            }
+            key = slot.key.load(std::memory_order_relaxed);
+            expires = slot.expires_ns.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) == seq) return true;
+        }
+        return false;
+    }
+
+    // Сначала короткое ожидание, затем уступаем процессор: писатель мог быть
+    // вытеснен посреди записи, и крутиться до конца его кванта бессмысленно
+    static void backoff(int attempt) noexcept {
+        if (attempt < kSpinAttempts) {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        } else {
+            ::sched_yield();
+        }
+    }
+
+    std::string name_;
+    const shm_session::Header* header_ = nullptr;
+    size_t mapped_size_ = 0;
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "session/shm_session_layout.h"
+#include "utils/imsi.h"
+
+// Зеркало индекса сессий в именованной разделяемой памяти для локальных читателей
+// (ShmSessionReader). Единственный писатель - SessionManager, вызовы под его
+// эксклюзивной блокировкой; сам класс не синхронизирует писателей между собой.
+class ShmSessionTable {
+public:
+    // Регион name ("/pgw_sessions") создаётся заново: оставшийся от прошлого процесса
+    // помечается Closed и удаляется. staged - регион создаётся под скрытым именем, а прежний
+    // работает дальше до publish() (передача работы). Исключение std::runtime_error, если shm недоступна
+    ShmSessionTable(std::string name, size_t max_sessions, bool staged = false);
+    ~ShmSessionTable();
+
+    ShmSessionTable(const ShmSessionTable&) = delete;
+    ShmSessionTable& operator=(const ShmSessionTable&) = delete;
+
+    // Заполненный регион подменяет прежний под именем name атомарно; прежний помечается
+    // Closed, читатели по reopen() сразу видят полную таблицу. Без staged ничего не делает
+    void publish();
+
+    void upsert(Imsi imsi, std::chrono::steady_clock::time_point expires_at);
+    void erase(Imsi imsi);
+
+    const std::string& name() const noexcept { return name_; }
+    uint64_t slot_count() const noexcept { return slot_count_; }
+    uint64_t size() const noexcept;
+    bool overflowed() const noexcept;
+
+private:
+    std::string name_;
+    std::string staged_name_;   // пока не пусто, регион читателям не виден
+    shm_session::Header* header_ = nullptr;
+    shm_session::Slot* slots_ = nullptr;
+    uint64_t slot_count_ = 0;
+    uint64_t inode_ = 0;
+    uint64_t live_ = 0;
+    uint64_t tombstones_ = 0;
+
+    void write_slot(shm_session::Slot& slot, uint64_t key, int64_t expires_ns) noexcept;
+    void rebuild();
+};
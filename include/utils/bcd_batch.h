@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "utils/imsi.h"
+
+// Пачка IMSI в фиксированных слотах: kDigitSlot байт ASCII-цифр (хвост нулевой)
+// и длина. Один слот - один SIMD-регистр SSE, два - AVX2.
+struct ImsiBatch {
+    static constexpr size_t kDigitSlot = 16;
+    static constexpr size_t kBcdSlot = 8;   // BCD одного IMSI, хвост дополнен 0xFF
+
+    std::vector<char> digits;
+    std::vector<uint8_t> lengths;
+
+    size_t size() const noexcept { return lengths.size(); }
+    void clear() noexcept { digits.clear(); lengths.clear(); }
+    void resize(size_t count);
+
+    // Строки длиннее 15 символов сохраняются обрезанными с длиной 16 - проверку не пройдут
+    void push_back(std::string_view imsi);
+    std::string_view at(size_t index) const noexcept {
+        return {digits.data() + index * kDigitSlot, lengths[index]};
+    }
+};
+
+// Пакетные ядра BCD с выбором реализации по CPU при первом вызове:
+// AVX2 (два IMSI за итерацию), SSE4.1 (один), иначе скалярная версия.
+// Семантика совпадает с BCDConverter, но без исключений: ошибка - это флаг/длина 0.
+class BCDBatch {
+public:
+    enum class Isa { Scalar, Sse41, Avx2 };
+
+    // Лучшая поддерживаемая процессором реализация
+    static Isa best_isa() noexcept;
+    static const char* isa_name(Isa isa) noexcept;
+
+    // valid[i] = 1, если IMSI i - от 10 до 15 цифр (как BCDConverter::validate_imsi)
+    static void validate(const ImsiBatch& batch, uint8_t* valid, Isa isa = best_isa()) noexcept;
+
+    // kBcdSlot байт на IMSI; первые (длина + 1) / 2 байт совпадают с BCDConverter::imsi_to_bcd.
+    // Вход должен быть проверен validate: для неверных IMSI результат не определён.
+    static void encode(const ImsiBatch& batch, uint8_t* bcd, Isa isa = best_isa()) noexcept;
+
+    // Обратно из слотов по kBcdSlot байт (короче - дополнить 0xFF). Неверный BCD
+    // (нибл 0xA-0xE до конца номера) или длина вне 10..15 дают длину 0.
+    static void decode(const uint8_t* bcd, size_t count, ImsiBatch& out, Isa isa = best_isa());
+
+    // Imsi::key() каждого IMSI: (значение << 4) | длина, его принимает Imsi::from_key.
+    // Вход должен быть проверен validate: для неверных IMSI результат не определён.
+    static void pack_keys(const ImsiBatch& batch, uint64_t* keys, Isa isa = best_isa()) noexcept;
+
+    // Разбор списка строк (чёрный список, тело /check_subscribers): validate и pack_keys
+    // по всему списку, out[i] пуст (Imsi{}), если строка i не IMSI
+    static std::vector<Imsi> parse(std::span<const std::string> texts, Isa isa = best_isa());
+
+    // Переупаковка BCD одного запроса в слот
+    static void to_bcd_slot(const uint8_t* data, size_t size, uint8_t* slot) noexcept;
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Дешёвый источник времени для замеров на горячем пути: на x86 - счётчик TSC
+// (constant/invariant TSC на всех современных серверных CPU), иначе steady_clock.
+// Тики переводятся в наносекунды коэффициентом, откалиброванным один раз при старте.
+class CycleClock {
+public:
+    static uint64_t now() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    static uint64_t to_nanos(uint64_t ticks) noexcept {
+        return static_cast<uint64_t>(static_cast<double>(ticks) * nanos_per_tick());
+    }
+
+    // Первый вызов калибрует TSC (~10 мс); вызывается при инициализации сервера
+    static double nanos_per_tick() noexcept;
+};
@@ -0,0 +1,140 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+
+enum class ImsiError : uint8_t {
+    BadLength,   // не 10-15 цифр
+    NonDigit,    // символ не цифра
+    BadBcd       // нибл 0xA-0xE в BCD
+};
+
+constexpr const char* imsi_error_message(ImsiError error) noexcept {
+    switch (error) {
+        case ImsiError::BadLength: return "IMSI must be 10-15 digits";
+        case ImsiError::NonDigit: return "IMSI contains a non-digit character";
+        case ImsiError::BadBcd: return "Invalid BCD nibble";
+    }
+    return "Invalid IMSI";
+}
+
+// IMSI как значение: десятичное число и длина (ведущие нули сохраняются) в одном
+// uint64_t - (value << 4) | length, та же упаковка, что у ключей индекса CDR.
+// Тривиально копируется, ключ хеш-таблиц без аллокаций. Разбор и форматирование
+// constexpr и без исключений.
+class Imsi {
+public:
+    static constexpr size_t kMinLength = 10;
+    static constexpr size_t kMaxLength = 15;
+    static constexpr size_t kMaxBcdBytes = (kMaxLength + 1) / 2;
+
+    // Цифры в буфере на стеке
+    struct Digits {
+        char data[kMaxLength] = {};
+        uint8_t size = 0;
+
+        constexpr std::string_view view() const noexcept { return {data, size}; }
+        constexpr operator std::string_view() const noexcept { return view(); }
+    };
+
+    constexpr Imsi() noexcept = default;   // пустой, ни одному разобранному IMSI не равен
+
+    static constexpr std::expected<Imsi, ImsiError> parse(std::string_view text) noexcept {
+        if (text.size() < kMinLength || text.size() > kMaxLength) {
+            return std::unexpected(ImsiError::BadLength);
+        }
+        uint64_t value = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') return std::unexpected(ImsiError::NonDigit);
+            value = value * 10 + static_cast<uint64_t>(c - '0');
+        }
+        return Imsi((value << 4) | text.size());
+    }
+
+    // BCD как в запросе клиента: младший нибл - первая цифра, 0xF завершает номер
+    static constexpr std::expected<Imsi, ImsiError> from_bcd(std::span<const uint8_t> bcd) noexcept {
+        uint64_t value = 0;
+        size_t length = 0;
+        for (size_t n = 0; n < bcd.size() * 2; ++n) {
+            const unsigned nibble = n % 2 == 0 ? bcd[n / 2] & 0x0F : bcd[n / 2] >> 4;
+            if (nibble == 0xF) break;
+            if (nibble > 9) return std::unexpected(ImsiError::BadBcd);
+            if (++length > kMaxLength) return std::unexpected(ImsiError::BadLength);
+            value = value * 10 + nibble;
+        }
+        if (length < kMinLength) return std::unexpected(ImsiError::BadLength);
+        return Imsi((value << 4) | length);
+    }
+
+    // Обратно из key(), например прочитанного из файла: проверяются длина и число цифр
+    static constexpr std::expected<Imsi, ImsiError> from_key(uint64_t key) noexcept {
+        const size_t length = static_cast<size_t>(key & 0xF);
+        if (length < kMinLength || length > kMaxLength) return std::unexpected(ImsiError::BadLength);
+        uint64_t limit = 1;
+        for (size_t i = 0; i < length; ++i) limit *= 10;
+        if ((key >> 4) >= limit) return std::unexpected(ImsiError::BadLength);
+        return Imsi(key);
+    }
+
+    constexpr size_t length() const noexcept { return static_cast<size_t>(packed_ & 0xF); }
+    constexpr uint64_t value() const noexcept { return packed_ >> 4; }
+    constexpr uint64_t key() const noexcept { return packed_; }
+    constexpr bool empty() const noexcept { return packed_ == 0; }
+
+    constexpr Digits digits() const noexcept {
+        Digits out;
+        out.size = static_cast<uint8_t>(length());
+        uint64_t rest = value();
+        for (size_t i = out.size; i > 0; --i) {
+            out.data[i - 1] = static_cast<char>('0' + rest % 10);
+            rest /= 10;
+        }
+        return out;
+    }
+
+    std::string to_string() const { return std::string(digits().view()); }
+
+    // Запись в BCD (нечётная длина дополняется 0xF); возвращает число байт
+    constexpr size_t to_bcd(std::span<uint8_t, kMaxBcdBytes> out) const noexcept {
+        const Digits d = digits();
+        const size_t bytes = (d.size + 1) / 2;
+        for (size_t b = 0; b < bytes; ++b) {
+            const unsigned lo = static_cast<unsigned>(d.data[2 * b] - '0');
+            const unsigned hi = 2 * b + 1 < d.size ? static_cast<unsigned>(d.data[2 * b + 1] - '0') : 0xF;
+            out[b] = static_cast<uint8_t>(lo | (hi << 4));
+        }
+        return bytes;
+    }
+
+    friend constexpr bool operator==(Imsi, Imsi) noexcept = default;
+    friend constexpr auto operator<=>(Imsi, Imsi) noexcept = default;
+
+private:
+    constexpr explicit Imsi(uint64_t packed) noexcept : packed_(packed) {}
+
+    uint64_t packed_ = 0;
+};
+
+static_assert(sizeof(Imsi) == 8);
+static_assert(Imsi::parse("001010123456789")->digits().view() == "001010123456789");
+static_assert(Imsi::from_key(Imsi::parse("001010123456789")->key()) == Imsi::parse("001010123456789"));
+
+template<>
+struct std::hash<Imsi> {
+    size_t operator()(Imsi imsi) const noexcept { return std::hash<uint64_t>{}(imsi.key()); }
+};
+
+namespace imsi_literals {
+
+// "001010123456789"_imsi - проверка на этапе компиляции
+consteval Imsi operator""_imsi(const char* text, size_t size) {
+    const auto imsi = Imsi::parse(std::string_view(text, size));
+    if (!imsi) throw "invalid IMSI literal";
+    return *imsi;
+}
+
+} // namespace imsi_literals
@@ -1,18 +1,40 @@
 #pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
 #include <memory>
 #include <string>
 #include <spdlog/spdlog.h>
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
+
+// Режим записи логов
+struct LogOptions {
+    bool async = false;                 // запись в отдельном потоке через ограниченную очередь
+    size_t queue_size = 8192;           // сообщений в очереди асинхронного режима
+    bool drop_on_overflow = false;      // false - ждать место в очереди, true - вытеснять старые сообщения
+    std::string flush_level = "WARN";   // немедленный сброс на диск с этого уровня
+    int flush_interval_sec = 1;         // периодический сброс, 0 - отключён
+};
+
 class Logger {
 public:
     static void init(
         const std::string& log_file, 
         const std::string& logger_name,
         const std::string& log_level = "OFF",
-        bool console_output = true
+        bool console_output = true,
+        const LogOptions& options = {}
     );
 
+    // Дописать очередь асинхронного режима и освободить логгер
+    static void shutdown();
+
+    // Сообщения, вытесненные из переполненной очереди
+    static uint64_t dropped_messages();
+
     static std::shared_ptr<spdlog::logger> get_logger() {
         if (!logger_) {
             static auto null_logger = create_null_logger();
@@ -21,6 +43,11 @@ public:
         return logger_;
     }
 
+    // Без копирования shared_ptr: для макросов PGW_LOG_* на горячем пути
+    static spdlog::logger* raw_logger() {
+        return logger_ ? logger_.get() : get_logger().get();
+    }
+
     template<typename... Args>
     static void debug(spdlog::format_string_t<Args...> fmt, Args&&... args) {
         if (logger_) logger_->debug(fmt, std::forward<Args>(args)...);
@@ -46,12 +73,132 @@ public:
         if (logger_) logger_->critical(fmt, std::forward<Args>(args)...);
     }
 
+    // Смена уровня на лету (перезагрузка конфигурации); бросает invalid_argument
+    static void set_level(const std::string& log_level) {
+        const auto level = parse_level(log_level);
+        if (logger_) logger_->set_level(level);
+    }
+
     static void flush() {
         if (logger_) logger_->flush();
     }
 
 private:
     static std::shared_ptr<spdlog::logger> logger_;
+    static std::shared_ptr<spdlog::details::thread_pool> thread_pool_;
     static std::shared_ptr<spdlog::logger> create_null_logger();    
     static spdlog::level::level_enum parse_level(const std::string& level);
-};
\ No newline at end of file
+};
+
+// Не больше per_second сообщений в секунду с одного места вызова, остальные только
+// считаются. Окно - секунда CLOCK_MONOTONIC_COARSE (vDSO, без rdtsc). Счёт пропущенных
+// без атомарного RMW: при одновременных пропусках из нескольких потоков он приблизителен.
+class LogRateLimiter {
+public:
+    constexpr explicit LogRateLimiter(uint32_t per_second) noexcept : per_second_(per_second) {}
+
+    // true - писать; suppressed - сколько сообщений пропущено с прошлой записи
+    bool allow(uint64_t& suppressed) noexcept {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &now);
+        int64_t window = window_.load(std::memory_order_relaxed);
+        if (now.tv_sec != window &&
+            window_.compare_exchange_strong(window, now.tv_sec, std::memory_order_relaxed)) {
+            used_.store(0, std::memory_order_relaxed);
+        }
+        if (used_.load(std::memory_order_relaxed) >= per_second_ ||
+            used_.fetch_add(1, std::memory_order_relaxed) >= per_second_) {
+            suppressed_.store(suppressed_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    const uint32_t per_second_;
+    std::atomic<int64_t> window_{-1};
+    std::atomic<uint32_t> used_{0};
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+// Частоты для сообщений на каждый пакет
+inline constexpr uint32_t kPacketLogSampleRate = 1000;   // пишется 1 из N
+inline constexpr uint32_t kPacketLogPerSecond = 10;      // ошибки: не больше N в секунду
+
+// Уровень, ниже которого PGW_LOG_* вырезаются при компиляции вместе с вычислением
+// аргументов (-DPGW_LOG_ACTIVE_LEVEL=SPDLOG_LEVEL_INFO). Включённые проверяют уровень
+// логгера до форматирования.
+#ifndef PGW_LOG_ACTIVE_LEVEL
+#define PGW_LOG_ACTIVE_LEVEL SPDLOG_LEVEL_TRACE
+#endif
+
+#define PGW_LOG_AT(level, ...)                                   \
+    do {                                                         \
+        spdlog::logger* pgw_log_logger_ = Logger::raw_logger();  \
+        if (pgw_log_logger_->should_log(level)) {                \
+            pgw_log_logger_->log(level, __VA_ARGS__);            \
+        }                                                        \
+    } while (0)
+
+#if PGW_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_TRACE
+#define PGW_LOG_TRACE(...) PGW_LOG_AT(spdlog::level::trace, __VA_ARGS__)
+#else
+#define PGW_LOG_TRACE(...) (void)0
+#endif
+
+#if PGW_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define PGW_LOG_DEBUG(...) PGW_LOG_AT(spdlog::level::debug, __VA_ARGS__)
+#else
+#define PGW_LOG_DEBUG(...) (void)0
+#endif
+
+#if PGW_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
+#define PGW_LOG_INFO(...) PGW_LOG_AT(spdlog::level::info, __VA_ARGS__)
+#else
+#define PGW_LOG_INFO(...) (void)0
+#endif
+
+// Не больше per_second в секунду с места вызова; число пропущенных пишется следующей строкой
+#define PGW_LOG_AT_RATE(level, per_second, ...)                                               \
+    do {                                                                                      \
+        spdlog::logger* pgw_log_logger_ = Logger::raw_logger();                               \
+        if (pgw_log_logger_->should_log(level)) {                                             \
+            static LogRateLimiter pgw_log_limiter_(per_second);                               \
+            uint64_t pgw_log_suppressed_ = 0;                                                 \
+            if (pgw_log_limiter_.allow(pgw_log_suppressed_)) {                                \
+                pgw_log_logger_->log(level, __VA_ARGS__);                                     \
+                if (pgw_log_suppressed_ != 0) {                                               \
+                    pgw_log_logger_->log(level, "... {} similar messages suppressed ({}:{})",  \
+                                         pgw_log_suppressed_, __FILE_NAME__, __LINE__);       \
+                }                                                                             \
+            }                                                                                 \
+        }                                                                                     \
+    } while (0)
+
+// Каждое every_n-е сообщение места вызова в каждом потоке
+#define PGW_LOG_AT_SAMPLED(level, every_n, ...)                   \
+    do {                                                          \
+        static thread_local uint32_t pgw_log_sample_ = 0;         \
+        if (++pgw_log_sample_ >= (every_n)) {                     \
+            pgw_log_sample_ = 0;                                  \
+            PGW_LOG_AT(level, __VA_ARGS__);                       \
+        }                                                         \
+    } while (0)
+
+#if PGW_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_DEBUG
+#define PGW_LOG_DEBUG_SAMPLED(every_n, ...) PGW_LOG_AT_SAMPLED(spdlog::level::debug, every_n, __VA_ARGS__)
+#else
+#define PGW_LOG_DEBUG_SAMPLED(every_n, ...) (void)0
+#endif
+
+#if PGW_LOG_ACTIVE_LEVEL <= SPDLOG_LEVEL_INFO
+#define PGW_LOG_INFO_SAMPLED(every_n, ...) PGW_LOG_AT_SAMPLED(spdlog::level::info, every_n, __VA_ARGS__)
+#define PGW_LOG_INFO_RATE(per_second, ...) PGW_LOG_AT_RATE(spdlog::level::info, per_second, __VA_ARGS__)
+#else
+#define PGW_LOG_INFO_SAMPLED(every_n, ...) (void)0
+#define PGW_LOG_INFO_RATE(per_second, ...) (void)0
+#endif
+
+#define PGW_LOG_WARN_RATE(per_second, ...) PGW_LOG_AT_RATE(spdlog::level::warn, per_second, __VA_ARGS__)
+#define PGW_LOG_ERROR_RATE(per_second, ...) PGW_LOG_AT_RATE(spdlog::level::err, per_second, __VA_ARGS__)
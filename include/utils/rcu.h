@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Минимальный RCU для редко меняющихся неизменяемых объектов (конфигурация).
+// Читатель отмечает в слоте своего потока эпоху, в которой начал чтение, и
+// после этого читает указатель - без блокировок и RMW. Писатель публикует
+// новый объект обменом указателя и в synchronize() ждёт, пока все потоки,
+// читавшие до обмена, выйдут из секции; после этого старый объект можно удалить.
+class Rcu {
+public:
+    static constexpr size_t kCacheLineSize = 64;
+
+    struct alignas(kCacheLineSize) ReaderSlot {
+        std::atomic<uint64_t> epoch{0};   // 0 - поток вне секции чтения
+    };
+
+    // Секция чтения. Вложенные секции в одном потоке не поддерживаются.
+    class ReadGuard {
+    public:
+        ReadGuard() noexcept : slot_(local_slot()) {
+            slot_.epoch.store(global_epoch_.load(std::memory_order_relaxed), std::memory_order_seq_cst);
+            // Чтение указателя в секции - acquire, а не seq_cst: без барьера оно может
+            // обогнать запись эпохи, и synchronize() не дождётся читателя старого объекта
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+        ~ReadGuard() {
+            slot_.epoch.store(0, std::memory_order_release);
+        }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+    private:
+        ReaderSlot& slot_;
+    };
+
+    // Дождаться окончания всех секций чтения, начатых до вызова
+    static void synchronize();
+
+private:
+    static ReaderSlot& local_slot() noexcept;
+    static inline std::atomic<uint64_t> global_epoch_{1};
+};
@@ -0,0 +1,165 @@
+#include "cdr/cdr_index.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include "utils/imsi.h"
+
+namespace {
+
+constexpr char kIndexMagic[8] = {'P', 'G', 'W', 'C', 'D', 'R', 'I', '1'};
+
+struct IndexHeader {
+    char magic[8];
+    uint64_t count;
+    uint64_t sparse_step;
+    uint64_t sparse_count;
+};
+
+bool pread_all(int fd, void* buf, size_t size, uint64_t offset) {
+    auto* out = static_cast<char*>(buf);
+    while (size > 0) {
+        ssize_t n = ::pread(fd, out, size, static_cast<off_t>(offset));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+        out += n;
+        size -= static_cast<size_t>(n);
+        offset += static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+CdrSegmentIndex::CdrSegmentIndex(const std::string& index_path) {
+    fd_ = ::open(index_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open CDR index: " + index_path);
+    }
+
+    IndexHeader header{};
+    if (!pread_all(fd_, &header, sizeof(header), 0) ||
+        std::memcmp(header.magic, kIndexMagic, sizeof(kIndexMagic)) != 0 ||
+        header.sparse_step != kSparseStep) {
+        ::close(fd_);
+        throw std::runtime_error("Corrupted CDR index: " + index_path);
+    }
+
+    count_ = header.count;
+    sparse_keys_.resize(header.sparse_count);
+    const uint64_t sparse_offset = sizeof(header) + count_ * sizeof(CdrIndexEntry);
+    if (!pread_all(fd_, sparse_keys_.data(), sparse_keys_.size() * sizeof(uint64_t), sparse_offset)) {
+        ::close(fd_);
+        throw std::runtime_error("Truncated CDR index: " + index_path);
+    }
+}
+
+CdrSegmentIndex::~CdrSegmentIndex() noexcept {
+    if (fd_ != -1) {
+        ::close(fd_);
+    }
+}
+
+std::vector<uint64_t> CdrSegmentIndex::find(uint64_t imsi_key) const {
+    std::vector<uint64_t> offsets;
+    if (count_ == 0 || imsi_key == 0) return offsets;
+
+    // Блоки [first, last) - единственные, где могут лежать записи с этим ключом
+    auto lower = std::lower_bound(sparse_keys_.begin(), sparse_keys_.end(), imsi_key);
+    auto upper = std::upper_bound(lower, sparse_keys_.end(), imsi_key);
+    if (upper == sparse_keys_.begin()) return offsets;
+
+    const uint64_t first_block = lower == sparse_keys_.begin() ? 0 : (lower - sparse_keys_.begin()) - 1;
+    const uint64_t last_block = upper - sparse_keys_.begin();
+
+    const uint64_t first = first_block * kSparseStep;
+    const uint64_t last = std::min(count_, last_block * kSparseStep);
+
+    std::vector<CdrIndexEntry> block(last - first);
+    if (!pread_all(fd_, block.data(), block.size() * sizeof(CdrIndexEntry),
+                   sizeof(IndexHeader) + first * sizeof(CdrIndexEntry))) {
+        return offsets;
+    }
+
+    auto range = std::equal_range(block.begin(), block.end(), CdrIndexEntry{imsi_key, 0},
+        [](const CdrIndexEntry& a, const CdrIndexEntry& b) { return a.imsi_key < b.imsi_key; });
+    for (auto it = range.first; it != range.second; ++it) {
+        offsets.push_back(it->offset);
+    }
+    return offsets;
+}
+
+uint64_t CdrSegmentIndex::make_key(std::string_view imsi) noexcept {
+    const auto parsed = Imsi::parse(imsi);
+    return parsed ? parsed->key() : 0;
+}
+
+uint64_t CdrSegmentIndex::key_from_record(std::string_view record) noexcept {
+    const auto first = record.find(',');
+    if (first == std::string_view::npos) return 0;
+    const auto second = record.find(',', first + 1);
+    if (second == std::string_view::npos) return 0;
+    return make_key(record.substr(first + 1, second - first - 1));
+}
+
+void CdrSegmentIndex::write(const std::string& index_path, std::vector<CdrIndexEntry>& entries) {
+    std::sort(entries.begin(), entries.end(), [](const CdrIndexEntry& a, const CdrIndexEntry& b) {
+        return a.imsi_key != b.imsi_key ? a.imsi_key < b.imsi_key : a.offset < b.offset;
+    });
+
+    std::vector<uint64_t> sparse_keys;
+    sparse_keys.reserve(entries.size() / kSparseStep + 1);
+    for (size_t i = 0; i < entries.size(); i += kSparseStep) {
+        sparse_keys.push_back(entries[i].imsi_key);
+    }
+
+    IndexHeader header{};
+    std::memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+    header.count = entries.size();
+    header.sparse_step = kSparseStep;
+    header.sparse_count = sparse_keys.size();
+
+    // Пишем во временный файл, чтобы недописанный индекс никогда не был виден по основному имени
+    const std::string tmp_path = index_path + ".tmp";
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("Failed to create CDR index: " + tmp_path);
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(entries.data()),
+                  static_cast<std::streamsize>(entries.size() * sizeof(CdrIndexEntry)));
+        out.write(reinterpret_cast<const char*>(sparse_keys.data()),
+                  static_cast<std::streamsize>(sparse_keys.size() * sizeof(uint64_t)));
+        if (!out) {
+            throw std::runtime_error("Failed to write CDR index: " + tmp_path);
+        }
+    }
+
+    if (std::rename(tmp_path.c_str(), index_path.c_str()) != 0) {
+        throw std::runtime_error("Failed to publish CDR index: " + index_path);
+    }
+}
+
+std::vector<CdrIndexEntry> CdrSegmentIndex::build_from_segment(const std::string& segment_path, uint64_t from_offset) {
+    std::ifstream in(segment_path, std::ios::binary);
+    if (!in.is_open()) {
+        throw std::runtime_error("Failed to open CDR segment: " + segment_path);
+    }
+    in.seekg(static_cast<std::streamoff>(from_offset));
+
+    std::vector<CdrIndexEntry> entries;
+    std::string line;
+    uint64_t offset = from_offset;
+    while (std::getline(in, line)) {
+        if (uint64_t key = key_from_record(line); key != 0) {
+            entries.push_back({key, offset});
+        }
+        offset += line.size() + 1;
+    }
+    return entries;
+}
@@ -1,16 +1,63 @@
 #include "cdr/cdr_manager.h"
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <iomanip>
+#include <fcntl.h>
+#include <unistd.h>
 #include "utils/logger.h"
+#include "metrics/metrics.h"
+#include "metrics/latency.h"
+#include "utils/cycle_clock.h"
 
-CdrManager::CdrManager(const std::string& filename)
-    : file_(filename, std::ios::app),
-      worker_(&CdrManager::process_queue, this)
+namespace {
+
+// Запись CDR короче: время (19) + IMSI (15) + действие + разделители
+constexpr size_t MAX_RECORD_LENGTH = 256;
+
+thread_local uint64_t enqueue_nanos = 0;
+
+void read_records(const std::string& path, const std::vector<uint64_t>& offsets,
+                  size_t limit, std::vector<std::string>& records) {
+    if (offsets.empty()) return;
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+
+    char buffer[MAX_RECORD_LENGTH];
+    for (uint64_t offset : offsets) {
+        if (records.size() >= limit) break;
+
+        ssize_t n = ::pread(fd, buffer, sizeof(buffer), static_cast<off_t>(offset));
+        if (n <= 0) continue;
+
+        std::string_view record(buffer, static_cast<size_t>(n));
+        if (auto end = record.find('\n'); end != std::string_view::npos) {
+            record = record.substr(0, end);
+        }
+        records.emplace_back(record);
+    }
+    ::close(fd);
+}
+
+} // namespace
+
+CdrManager::CdrManager(const std::string& filename, uint64_t segment_max_bytes)
+    : filename_(filename),
+      segment_max_bytes_(segment_max_bytes),
+      file_(filename, std::ios::app)
 {
     if (!file_.is_open()) {
         throw std::runtime_error("Failed to open CDR file: " + filename);
     }
 
+    if (segment_max_bytes_ > 0) {
+        load_segments();
+    }
+    worker_ = std::thread(&CdrManager::process_queue, this);
+
     Logger::get_logger()->info("CDR manager initialized with file: {}", filename);
 }
 CdrManager::~CdrManager() {
@@ -18,38 +65,128 @@ CdrManager::~CdrManager() {
     if (worker_.joinable()) {
         worker_.join();
     }
-    flush();           
+    flush();
     file_.close();
 }
 
 
-void CdrManager::add_record(std::string_view imsi, std::string_view action) {
+void CdrManager::add_record(Imsi imsi, std::string_view action) {
+    const uint64_t start = CycleClock::now();
     auto now = std::chrono::system_clock::now();
     std::time_t time = std::chrono::system_clock::to_time_t(now);
-    
+
     std::ostringstream record;
     record << std::put_time(std::localtime(&time), "%F %T") << ","
-           << imsi << ","
+           << imsi.digits().view() << ","
            << action << "\n";
     {
         std::lock_guard<std::mutex> lock(mutex_);
         queue_.push(record.str());
     }
+    const uint64_t nanos = CycleClock::to_nanos(CycleClock::now() - start);
+    enqueue_nanos += nanos;
+    Latency::record(Stage::CdrEnqueue, nanos);
+}
+
+uint64_t CdrManager::thread_enqueue_nanos() noexcept {
+    return enqueue_nanos;
 }
 
 void CdrManager::flush() {
+    // Кроме фонового потока, flush зовут деструктор и передача работы новому процессу
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
     std::queue<std::string> local_queue;
     {
         std::lock_guard<std::mutex> lock(mutex_);
         queue_.swap(local_queue);
     }
-    
+
+    // Смещения записей публикуются в индекс только после file_.flush(),
+    // чтобы поиск никогда не читал ещё не записанные данные
+    const size_t records = local_queue.size();
+    uint64_t bytes = 0;
+
+    std::vector<CdrIndexEntry> written;
+    auto publish_written = [this, &written]() {
+        if (written.empty()) return;
+        std::unique_lock lock(segments_mutex_);
+        active_index_.insert(active_index_.end(), written.begin(), written.end());
+        written.clear();
+    };
+
     while (!local_queue.empty()) {
-        file_ << local_queue.front();
+        const std::string& record = local_queue.front();
+        if (segment_max_bytes_ > 0) {
+            if (uint64_t key = CdrSegmentIndex::key_from_record(record); key != 0) {
+                written.push_back({key, active_size_});
+            }
+        }
+        file_ << record;
+        active_size_ += record.size();
+        bytes += record.size();
         local_queue.pop();
+
+        if (segment_max_bytes_ > 0 && active_size_ >= segment_max_bytes_) {
+            file_.flush();
+            publish_written();
+            rotate_segment();
+        }
     }
-    
+
     file_.flush();
+    publish_written();
+
+    if (records > 0) {
+        Metrics::increment(Counter::CdrRecordsWritten, records);
+        Metrics::increment(Counter::CdrBytesWritten, bytes);
+    }
+}
+
+size_t CdrManager::queue_depth() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+std::vector<std::string> CdrManager::find_records(Imsi imsi, size_t limit) const {
+    std::vector<std::string> records;
+    // Imsi::key() - та же упаковка, что и ключ индекса
+    const uint64_t key = imsi.key();
+    if (key == 0 || limit == 0) return records;
+
+    std::shared_lock lock(segments_mutex_);
+
+    for (const auto& segment : segments_) {
+        if (!segment.index) continue;
+        read_records(segment.path, segment.index->find(key), limit, records);
+        if (records.size() >= limit) return records;
+    }
+
+    std::vector<uint64_t> offsets;
+    for (const auto& entry : active_index_) {
+        if (entry.imsi_key == key) {
+            offsets.push_back(entry.offset);
+        }
+    }
+    read_records(filename_, offsets, limit, records);
+
+    return records;
+}
+
+std::vector<CdrSegmentInfo> CdrManager::list_segments() const {
+    std::vector<CdrSegmentInfo> segments;
+    std::shared_lock lock(segments_mutex_);
+
+    segments.reserve(segments_.size());
+    for (const auto& segment : segments_) {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(segment.path, ec);
+        if (ec) continue;
+        segments.push_back({segment.sequence,
+                            std::filesystem::path(segment.path).filename().string(),
+                            segment.path,
+                            size});
+    }
+    return segments;
 }
 
 void CdrManager::process_queue() {
@@ -60,6 +197,125 @@ void CdrManager::process_queue() {
 
         if (!running_) break;
     }
-    
+
     Logger::get_logger()->debug("CDR worker thread stopped");
-}
\ No newline at end of file
+}
+
+std::vector<std::pair<uint64_t, std::string>> CdrManager::find_segments() const {
+    namespace fs = std::filesystem;
+
+    const fs::path active_path(filename_);
+    const fs::path directory = active_path.has_parent_path() ? active_path.parent_path() : fs::path(".");
+    const std::string prefix = active_path.filename().string() + ".";
+
+    std::vector<std::pair<uint64_t, std::string>> found;
+    for (const auto& entry : fs::directory_iterator(directory)) {
+        const std::string name = entry.path().filename().string();
+        if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) continue;
+
+        const std::string suffix = name.substr(prefix.size());
+        if (std::all_of(suffix.begin(), suffix.end(), ::isdigit)) {
+            found.emplace_back(std::stoull(suffix), entry.path().string());
+        }
+    }
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+void CdrManager::add_segment(uint64_t sequence, std::string path) {
+    Segment segment{sequence, std::move(path), nullptr};
+    const std::string index_path = segment.path + ".idx";
+    try {
+        if (!std::filesystem::exists(index_path)) {
+            // Сегмент закрыт, но индекс не успел записаться (падение процесса)
+            auto entries = CdrSegmentIndex::build_from_segment(segment.path);
+            CdrSegmentIndex::write(index_path, entries);
+            Logger::get_logger()->warn("Rebuilt missing CDR index: {}", index_path);
+        }
+        segment.index = std::make_unique<CdrSegmentIndex>(index_path);
+    } catch (const std::exception& e) {
+        Logger::get_logger()->error("CDR segment {} is not searchable: {}", segment.path, e.what());
+    }
+    segments_.push_back(std::move(segment));
+    next_sequence_ = sequence + 1;
+}
+
+void CdrManager::load_segments() {
+    for (auto& [sequence, path] : find_segments()) {
+        add_segment(sequence, std::move(path));
+    }
+
+    active_index_ = CdrSegmentIndex::build_from_segment(filename_);
+    active_size_ = std::filesystem::file_size(filename_);
+
+    Logger::get_logger()->info("Loaded {} CDR segments, active file has {} records",
+                               segments_.size(), active_index_.size());
+}
+
+void CdrManager::resync() {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+    std::unique_lock lock(segments_mutex_);
+
+    if (segment_max_bytes_ > 0) {
+        // Прежний процесс мог закрыть сегменты, в том числе файл, прочитанный load_segments
+        const uint64_t known = next_sequence_;
+        for (auto& [sequence, path] : find_segments()) {
+            if (sequence >= known) {
+                add_segment(sequence, std::move(path));
+            }
+        }
+        if (next_sequence_ != known) {
+            active_index_ = CdrSegmentIndex::build_from_segment(filename_);
+        } else {
+            auto tail = CdrSegmentIndex::build_from_segment(filename_, active_size_);
+            active_index_.insert(active_index_.end(), tail.begin(), tail.end());
+        }
+        active_size_ = std::filesystem::file_size(filename_);
+    }
+
+    // После ротации чужим процессом открытый файл - уже сегмент
+    file_.close();
+    file_.open(filename_, std::ios::app);
+    if (!file_.is_open()) {
+        throw std::runtime_error("Failed to reopen CDR file: " + filename_);
+    }
+}
+
+void CdrManager::rotate_segment() {
+    std::unique_lock lock(segments_mutex_);
+
+    Segment segment{next_sequence_, segment_path(next_sequence_), nullptr};
+
+    file_.close();
+    if (std::rename(filename_.c_str(), segment.path.c_str()) != 0) {
+        Logger::get_logger()->error("Failed to rotate CDR file {}: {}", filename_, strerror(errno));
+        file_.open(filename_, std::ios::app);
+        return;
+    }
+
+    file_.open(filename_, std::ios::app);
+    if (!file_.is_open()) {
+        Logger::get_logger()->critical("Failed to reopen CDR file after rotation: {}", filename_);
+    }
+
+    try {
+        const std::string index_path = segment.path + ".idx";
+        CdrSegmentIndex::write(index_path, active_index_);
+        segment.index = std::make_unique<CdrSegmentIndex>(index_path);
+    } catch (const std::exception& e) {
+        Logger::get_logger()->error("CDR segment {} is not searchable: {}", segment.path, e.what());
+    }
+
+    Logger::get_logger()->info("CDR segment closed: {} ({} records)", segment.path, active_index_.size());
+
+    segments_.push_back(std::move(segment));
+    ++next_sequence_;
+    active_index_.clear();
+    active_size_ = 0;
+}
+
+std::string CdrManager::segment_path(uint64_t sequence) const {
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%06llu", static_cast<unsigned long long>(sequence));
+    return filename_ + suffix;
+}
@@ -1,14 +1,58 @@
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 #include "pgw/pgw_client.h"
 
+namespace {
+
+// Пакетный режим: IMSI по одному на строку, ответы "<imsi> <ответ>" в том же порядке
+int send_file(PgwClient& client, const std::string& path) {
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            std::cerr << "Cannot open IMSI file: " << path << std::endl;
+            return 1;
+        }
+    }
+    std::istream& input = path == "-" ? std::cin : file;
+
+    std::vector<std::string> imsis;
+    for (std::string line; std::getline(input, line);) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (!line.empty()) imsis.push_back(std::move(line));
+    }
+
+    const auto responses = client.send_many(imsis);
+    std::string out;
+    for (size_t i = 0; i < imsis.size(); ++i) {
+        out += imsis[i];
+        out += ' ';
+        out += responses[i];
+        out += '\n';
+    }
+    std::cout << out;
+
+    const auto stats = client.transport_stats();
+    std::cerr << "requests=" << stats.requests << " replies=" << stats.replies
+              << " retransmits=" << stats.retransmits << " hedges=" << stats.hedges
+              << " timeouts=" << stats.timeouts << " budget_exhausted=" << stats.budget_exhausted
+              << " srtt_us=" << stats.srtt.count() << " rto_us=" << stats.rto.count() << std::endl;
+    return 0;
+}
+
+} // namespace
+
 
 int main(int argc, char* argv[]) {
 
-    if (argc < 2 || argc > 3) {
-        std::cerr << "Usage: " << argv[0] << " [config_file] [IMSI]\n"
+    if (argc < 2 || argc > 4 || (argc == 4 && std::string(argv[2]) != "--file")) {
+        std::cerr << "Usage: " << argv[0] << " [config_file] [IMSI | --file <path>]\n"
                   << "Examples:\n"
-                  << "  " << argv[0] << " config.json         # Interactive mode with config\n"
-                  << "  " << argv[0] << " config.json 123456  # Single request mode\n";
+                  << "  " << argv[0] << " config.json                # Interactive mode with config\n"
+                  << "  " << argv[0] << " config.json 123456         # Single request mode\n"
+                  << "  " << argv[0] << " config.json --file imsis   # Bulk mode, '-' reads stdin\n";
         return 1;
     }
 
@@ -22,7 +66,9 @@ int main(int argc, char* argv[]) {
         }
 
         // Режим работы
-        if (argc == 3) {
+        if (argc == 4) {
+            return send_file(client, argv[3]);
+        } else if (argc == 3) {
             // Режим однократного запроса
             std::string response = client.send_imsi(argv[2]);
             std::cout << response << std::endl;
@@ -31,6 +31,10 @@ void ClientConfig::load_config(std::string_view config_file_path) {
     log_file_ = config.value("log_file", log_file_);
     log_level_ = config.value("log_level", log_level_);
     console_output_ = config.value("console_output", console_output_);
+    request_timeout_ms_ = config.value("request_timeout_ms", request_timeout_ms_);
+    max_retries_ = config.value("max_retries", max_retries_);
+    retry_budget_ratio_ = config.value("retry_budget_ratio", retry_budget_ratio_);
+    hedge_requests_ = config.value("hedge_requests", hedge_requests_);
 }
 
 
@@ -43,6 +47,18 @@ void ClientConfig::validate_config() {
     if (server_port_ <= 0 || server_port_ > 65535) {
         throw std::runtime_error("Invalid server port number");
     }
+
+    if (request_timeout_ms_ <= 0) {
+        throw std::runtime_error("Request timeout must be positive");
+    }
+
+    if (max_retries_ < 0 || max_retries_ > 10) {
+        throw std::runtime_error("Max retries must be between 0 and 10");
+    }
+
+    if (retry_budget_ratio_ < 0.0 || retry_budget_ratio_ > 1.0) {
+        throw std::runtime_error("Retry budget ratio must be between 0 and 1");
+    }
     
     const std::vector<std::string> allowed_log_levels = {
         "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "CRITICAL", "OFF"
@@ -1,4 +1,5 @@
 #include "config/server_config.h"
+#include <arpa/inet.h>
 #include <fstream>
 #include <stdexcept>
 #include <algorithm>
@@ -33,11 +34,29 @@ void ServerConfig::load_config(std::string_view config_file_path) {
     udp_port_ = config.value("udp_port", udp_port_);
     session_timeout_sec_ = config.value("session_timeout_sec", session_timeout_sec_);
     cdr_file_ = config.value("cdr_file", cdr_file_);
+    cdr_segment_size_mb_ = config.value("cdr_segment_size_mb", cdr_segment_size_mb_);
+    cdr_export_port_ = config.value("cdr_export_port", cdr_export_port_);
+    slow_request_threshold_us_ = config.value("slow_request_threshold_us", slow_request_threshold_us_);
     http_port_ = config.value("http_port", http_port_);
     graceful_shutdown_rate_ = config.value("graceful_shutdown_rate", graceful_shutdown_rate_);
     log_file_ = config.value("log_file", log_file_);
     log_level_ = config.value("log_level", log_level_);
     console_output_ = config.value("console_output", console_output_);
+    log_async_ = config.value("log_async", log_async_);
+    log_queue_size_ = config.value("log_queue_size", log_queue_size_);
+    log_overflow_ = config.value("log_overflow", log_overflow_);
+    log_flush_level_ = config.value("log_flush_level", log_flush_level_);
+    log_flush_interval_sec_ = config.value("log_flush_interval_sec", log_flush_interval_sec_);
+    shm_session_table_ = config.value("shm_session_table", shm_session_table_);
+    shm_session_capacity_ = config.value("shm_session_capacity", shm_session_capacity_);
+    session_snapshot_dir_ = config.value("session_snapshot_dir", session_snapshot_dir_);
+    session_snapshot_interval_sec_ = config.value("session_snapshot_interval_sec", session_snapshot_interval_sec_);
+    recover_sessions_from_cdr_ = config.value("recover_sessions_from_cdr", recover_sessions_from_cdr_);
+    handoff_socket_ = config.value("handoff_socket", handoff_socket_);
+    replication_standby_ip_ = config.value("replication_standby_ip", replication_standby_ip_);
+    replication_standby_port_ = config.value("replication_standby_port", replication_standby_port_);
+    replication_port_ = config.value("replication_port", replication_port_);
+    replication_batch_ms_ = config.value("replication_batch_ms", replication_batch_ms_);
 
     // Загрузка blacklist
     if (config.contains("blacklist") && config["blacklist"].is_array()) {
@@ -60,11 +79,22 @@ void ServerConfig::validate_config() {
 
     validate_port(udp_port_, "UDP");
     validate_port(http_port_, "HTTP");
+    if (cdr_export_port_ != 0) {
+        validate_port(cdr_export_port_, "CDR export");
+    }
 
     if (session_timeout_sec_ <= 0) {
         throw std::runtime_error("Session timeout must be positive");
     }
 
+    if (cdr_segment_size_mb_ < 0) {
+        throw std::runtime_error("CDR segment size cannot be negative");
+    }
+
+    if (slow_request_threshold_us_ < 0) {
+        throw std::runtime_error("Slow request threshold cannot be negative");
+    }
+
     if (graceful_shutdown_rate_ < 0) {
         throw std::runtime_error("Graceful shutdown rate cannot be negative");
     }
@@ -77,6 +107,59 @@ void ServerConfig::validate_config() {
         throw std::runtime_error("Invalid log level");
     }
 
+    if (std::find(allowed_log_levels.begin(), allowed_log_levels.end(), log_flush_level_) == allowed_log_levels.end()) {
+        throw std::runtime_error("Invalid log flush level");
+    }
+
+    if (log_queue_size_ <= 0) {
+        throw std::runtime_error("Log queue size must be positive");
+    }
+
+    if (log_overflow_ != "block" && log_overflow_ != "drop") {
+        throw std::runtime_error("Log overflow policy must be \"block\" or \"drop\"");
+    }
+
+    if (log_flush_interval_sec_ < 0) {
+        throw std::runtime_error("Log flush interval cannot be negative");
+    }
+
+    if (!shm_session_table_.empty() &&
+        (shm_session_table_.front() != '/' || shm_session_table_.size() > 255 ||
+         shm_session_table_.find('/', 1) != std::string::npos)) {
+        throw std::runtime_error("Shared-memory session table name must look like \"/name\"");
+    }
+
+    if (shm_session_capacity_ <= 0) {
+        throw std::runtime_error("Shared-memory session capacity must be positive");
+    }
+
+    if (session_snapshot_interval_sec_ <= 0) {
+        throw std::runtime_error("Session snapshot interval must be positive");
+    }
+
+    // sun_path - 108 байт с завершающим нулём
+    if (!handoff_socket_.empty() && (handoff_socket_.front() != '/' || handoff_socket_.size() > 107)) {
+        throw std::runtime_error("Handoff socket must be an absolute path shorter than 108 characters");
+    }
+
+    if (!replication_standby_ip_.empty()) {
+        in_addr addr{};
+        if (::inet_pton(AF_INET, replication_standby_ip_.c_str(), &addr) != 1) {
+            throw std::runtime_error("Invalid replication standby IP: " + replication_standby_ip_);
+        }
+        validate_port(replication_standby_port_, "replication standby");
+    }
+    if (replication_port_ != 0) {
+        validate_port(replication_port_, "replication");
+    }
+    // Цепочки не поддерживаются: резервный узел изменения дальше не передаёт
+    if (!replication_standby_ip_.empty() && replication_port_ != 0) {
+        throw std::runtime_error("A node cannot be both a replication primary and a standby");
+    }
+    if (replication_batch_ms_ <= 0) {
+        throw std::runtime_error("Replication batch interval must be positive");
+    }
+
     // Валидация blacklist
     for (const auto& imsi : blacklist_) {
         if (imsi.empty() || imsi.length() > 15 || 
@@ -0,0 +1,434 @@
+#include "http/cdr_export_server.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "utils/logger.h"
+
+namespace {
+
+constexpr size_t MAX_REQUEST_SIZE = 8192;
+// Не больше 1 МБ за вызов sendfile, чтобы соединения обслуживались по очереди
+constexpr size_t SEND_CHUNK_SIZE = 1024 * 1024;
+constexpr auto IDLE_TIMEOUT = std::chrono::seconds(30);
+constexpr std::string_view EXPORT_PREFIX = "/cdr_export/";
+
+bool iequals_prefix(std::string_view text, std::string_view prefix) {
+    return text.size() >= prefix.size() &&
+        std::equal(prefix.begin(), prefix.end(), text.begin(),
+                   [](char a, char b) { return ::tolower(a) == ::tolower(b); });
+}
+
+std::string_view find_header(std::string_view request, std::string_view name) {
+    size_t pos = request.find("\r\n");
+    while (pos != std::string_view::npos && pos + 2 < request.size()) {
+        const size_t line_start = pos + 2;
+        const size_t line_end = request.find("\r\n", line_start);
+        std::string_view line = request.substr(line_start, line_end - line_start);
+        if (iequals_prefix(line, name) && line.size() > name.size() && line[name.size()] == ':') {
+            std::string_view value = line.substr(name.size() + 1);
+            while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+            return value;
+        }
+        pos = line_end;
+    }
+    return {};
+}
+
+bool parse_u64(std::string_view text, uint64_t& value) {
+    if (text.empty() || text.size() > 19) return false;
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return true;
+}
+
+const char* status_text(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 206: return "Partial Content";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 416: return "Range Not Satisfiable";
+        default: return "Internal Server Error";
+    }
+}
+
+} // namespace
+
+CdrExportServer::CdrExportServer(int port, const std::string& host, std::shared_ptr<CdrManager> cdr_manager)
+    : port_(port), host_(host), cdr_manager_(std::move(cdr_manager)) {
+
+    if (!setup_socket()) {
+        if (listen_fd_ != -1) close(listen_fd_);
+        if (epoll_fd_ != -1) close(epoll_fd_);
+        throw std::runtime_error("Failed to initialize CDR export server");
+    }
+}
+
+CdrExportServer::CdrExportServer(int listen_fd, std::shared_ptr<CdrManager> cdr_manager)
+    : port_(0), cdr_manager_(std::move(cdr_manager)), listen_fd_(listen_fd) {
+
+    struct sockaddr_in addr{};
+    socklen_t addr_len = sizeof(addr);
+    if (getsockname(listen_fd_, (struct sockaddr*)&addr, &addr_len) == 0) {
+        host_ = inet_ntoa(addr.sin_addr);
+        port_ = ntohs(addr.sin_port);
+    }
+    // Соединения из очереди accept прежнего процесса достаются этому
+    if (!setup_epoll()) {
+        close(listen_fd_);
+        if (epoll_fd_ != -1) close(epoll_fd_);
+        throw std::runtime_error("Failed to initialize CDR export server");
+    }
+}
+
+CdrExportServer::~CdrExportServer() {
+    stop();
+    if (listen_fd_ != -1) close(listen_fd_);
+    if (epoll_fd_ != -1) close(epoll_fd_);
+}
+
+void CdrExportServer::start() {
+    if (running_) return;
+
+    running_ = true;
+    worker_thread_ = std::thread(&CdrExportServer::worker_thread, this);
+
+    Logger::get_logger()->info("CDR export server started on {}:{}", host_, port_);
+}
+
+void CdrExportServer::stop() {
+    if (!running_) return;
+
+    running_ = false;
+    if (worker_thread_.joinable()) {
+        worker_thread_.join();
+    }
+
+    while (!connections_.empty()) {
+        close_connection(connections_.begin()->first);
+    }
+
+    Logger::get_logger()->info("CDR export server stopped");
+}
+
+bool CdrExportServer::setup_socket() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        Logger::get_logger()->critical("Export socket creation failed: {}", strerror(errno));
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port_);
+
+    if (inet_pton(AF_INET, host_.c_str(), &addr.sin_addr) <= 0) {
+        Logger::get_logger()->critical("Invalid export IP address: {}", host_);
+        return false;
+    }
+
+    if (bind(listen_fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listen_fd_, 16) < 0) {
+        Logger::get_logger()->critical("Export bind/listen failed: {}", strerror(errno));
+        return false;
+    }
+    return setup_epoll();
+}
+
+bool CdrExportServer::setup_epoll() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        Logger::get_logger()->critical("epoll_create1 failed: {}", strerror(errno));
+        return false;
+    }
+
+    struct epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event) < 0) {
+        Logger::get_logger()->critical("Epoll_ctl failed: {}", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void CdrExportServer::worker_thread() {
+    // Выгрузка получает CPU только когда остальные потоки простаивают
+    sched_param param{};
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0) {
+        Logger::get_logger()->warn("Failed to set SCHED_IDLE for CDR export thread");
+    }
+
+    const int max_events = 64;
+    struct epoll_event events[max_events];
+
+    while (running_) {
+        int num_events = epoll_wait(epoll_fd_, events, max_events, 100);
+        if (num_events < 0) {
+            if (errno == EINTR) continue;
+            Logger::get_logger()->error("epoll_wait error: {}", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < num_events; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == listen_fd_) {
+                accept_connections();
+                continue;
+            }
+
+            auto it = connections_.find(fd);
+            if (it == connections_.end()) continue;
+
+            Connection& conn = it->second;
+            conn.last_activity = std::chrono::steady_clock::now();
+
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close_connection(fd);
+            } else if (events[i].events & EPOLLOUT) {
+                if (!handle_writable(conn)) close_connection(fd);
+            } else if (events[i].events & EPOLLIN) {
+                handle_readable(conn);
+            }
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        for (auto it = connections_.begin(); it != connections_.end();) {
+            const int fd = it->first;
+            const bool idle = now - it->second.last_activity > IDLE_TIMEOUT;
+            ++it;
+            if (idle) close_connection(fd);
+        }
+    }
+}
+
+void CdrExportServer::accept_connections() {
+    while (true) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                Logger::get_logger()->error("Export accept failed: {}", strerror(errno));
+            }
+            return;
+        }
+
+        struct epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            continue;
+        }
+
+        Connection conn;
+        conn.fd = fd;
+        conn.last_activity = std::chrono::steady_clock::now();
+        connections_.emplace(fd, std::move(conn));
+    }
+}
+
+void CdrExportServer::handle_readable(Connection& conn) {
+    char buffer[2048];
+    while (true) {
+        ssize_t n = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            conn.request.append(buffer, static_cast<size_t>(n));
+            if (conn.request.size() > MAX_REQUEST_SIZE) {
+                set_error(conn, 400, "Request too large");
+                break;
+            }
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (n < 0 && errno == EINTR) continue;
+        close_connection(conn.fd);
+        return;
+    }
+
+    if (conn.header.empty()) {
+        if (conn.request.find("\r\n\r\n") == std::string::npos) return;
+        prepare_response(conn);
+    }
+
+    struct epoll_event event{};
+    event.events = EPOLLOUT;
+    event.data.fd = conn.fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &event);
+}
+
+void CdrExportServer::prepare_response(Connection& conn) {
+    std::string_view request = conn.request;
+    std::string_view request_line = request.substr(0, request.find("\r\n"));
+
+    const bool head = request_line.starts_with("HEAD ");
+    if (!head && !request_line.starts_with("GET ")) {
+        set_error(conn, 405, "Only GET and HEAD are supported");
+        return;
+    }
+
+    request_line.remove_prefix(head ? 5 : 4);
+    std::string_view target = request_line.substr(0, request_line.find(' '));
+    if (!target.starts_with(EXPORT_PREFIX)) {
+        set_error(conn, 404, "Unknown path");
+        return;
+    }
+    target.remove_prefix(EXPORT_PREFIX.size());
+
+    // Продолжение выгрузки: ?offset=N эквивалентен Range: bytes=N-
+    std::string_view name = target.substr(0, target.find('?'));
+    std::string_view query = name.size() < target.size() ? target.substr(name.size() + 1) : std::string_view{};
+
+    uint64_t start = 0;
+    uint64_t end = UINT64_MAX;
+    uint64_t suffix_length = 0;
+    bool suffix = false;
+    bool partial = false;
+
+    if (query.starts_with("offset=")) {
+        if (!parse_u64(query.substr(7), start)) {
+            set_error(conn, 400, "Invalid offset");
+            return;
+        }
+        partial = true;
+    }
+
+    std::string_view range = find_header(request, "Range");
+    // Несколько диапазонов не поддерживаются: такой запрос обслуживается целиком
+    if (!range.empty() && range.starts_with("bytes=") && range.find(',') == std::string_view::npos) {
+        range.remove_prefix(6);
+        const size_t dash = range.find('-');
+        if (dash == std::string_view::npos) {
+            set_error(conn, 400, "Invalid Range");
+            return;
+        }
+        std::string_view first = range.substr(0, dash);
+        std::string_view last = range.substr(dash + 1);
+
+        if (first.empty()) {
+            // bytes=-N: последние N байт
+            if (!parse_u64(last, suffix_length)) {
+                set_error(conn, 400, "Invalid Range");
+                return;
+            }
+            suffix = true;
+        } else {
+            if (!parse_u64(first, start) || (!last.empty() && !parse_u64(last, end))) {
+                set_error(conn, 400, "Invalid Range");
+                return;
+            }
+        }
+        partial = true;
+    }
+
+    const auto segments = cdr_manager_->list_segments();
+    auto segment = std::find_if(segments.begin(), segments.end(),
+        [name](const CdrSegmentInfo& s) { return s.name == name; });
+    if (segment == segments.end()) {
+        set_error(conn, 404, "Segment not found");
+        return;
+    }
+
+    const uint64_t size = segment->size;
+    if (suffix) {
+        start = suffix_length >= size ? 0 : size - suffix_length;
+    }
+    end = std::min(end, size == 0 ? 0 : size - 1);
+
+    if (partial && (start >= size || start > end)) {
+        conn.header = "HTTP/1.1 416 " + std::string(status_text(416)) + "\r\n"
+                      "Content-Range: bytes */" + std::to_string(size) + "\r\n"
+                      "Content-Length: 0\r\nConnection: close\r\n\r\n";
+        return;
+    }
+
+    const uint64_t length = size == 0 ? 0 : end - start + 1;
+    const int status = partial ? 206 : 200;
+
+    conn.header = "HTTP/1.1 " + std::to_string(status) + " " + status_text(status) + "\r\n"
+                  "Content-Type: application/octet-stream\r\n"
+                  "Content-Length: " + std::to_string(length) + "\r\n"
+                  "Accept-Ranges: bytes\r\n";
+    if (partial) {
+        conn.header += "Content-Range: bytes " + std::to_string(start) + "-" + std::to_string(end) +
+                       "/" + std::to_string(size) + "\r\n";
+    }
+    conn.header += "Connection: close\r\n\r\n";
+
+    if (head || length == 0) return;
+
+    conn.file_fd = ::open(segment->path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (conn.file_fd < 0) {
+        set_error(conn, 500, "Failed to open segment");
+        return;
+    }
+    conn.offset = start;
+    conn.remaining = length;
+
+    Logger::get_logger()->info("CDR export {} bytes {}-{} of {}", segment->name, start, end, size);
+}
+
+void CdrExportServer::set_error(Connection& conn, int status, std::string_view reason) {
+    conn.header = "HTTP/1.1 " + std::to_string(status) + " " + status_text(status) + "\r\n"
+                  "Content-Type: text/plain\r\n"
+                  "Content-Length: " + std::to_string(reason.size()) + "\r\n"
+                  "Connection: close\r\n\r\n" + std::string(reason);
+}
+
+bool CdrExportServer::handle_writable(Connection& conn) {
+    while (conn.header_sent < conn.header.size()) {
+        ssize_t n = send(conn.fd, conn.header.data() + conn.header_sent,
+                         conn.header.size() - conn.header_sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        conn.header_sent += static_cast<size_t>(n);
+    }
+
+    if (conn.remaining == 0) return false;
+
+    // Один фрагмент за пробуждение: остальные соединения не ждут окончания большой выгрузки
+    off_t offset = static_cast<off_t>(conn.offset);
+    ssize_t sent = ::sendfile(conn.fd, conn.file_fd, &offset,
+                              std::min<uint64_t>(conn.remaining, SEND_CHUNK_SIZE));
+    if (sent < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return true;
+        Logger::get_logger()->warn("CDR export sendfile failed: {}", strerror(errno));
+        return false;
+    }
+    if (sent == 0) {
+        // Файл стал короче заявленного Content-Length
+        return false;
+    }
+
+    conn.offset += static_cast<uint64_t>(sent);
+    conn.remaining -= static_cast<uint64_t>(sent);
+    return conn.remaining > 0;
+}
+
+void CdrExportServer::close_connection(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) return;
+
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    if (it->second.file_fd != -1) close(it->second.file_fd);
+    close(fd);
+    connections_.erase(it);
+}
@@ -1,5 +1,11 @@
 #include "http/http_server.h"
 #include <stdexcept>
+#include <system_error>
+#include <sys/socket.h>
+#include "metrics/metrics.h"
+#include "metrics/latency.h"
+#include "metrics/profiler.h"
+#include "metrics/request_trace.h"
 
 HttpServer::HttpServer(int port, const std::string& host) 
     : port_(port), host_(host) {
@@ -12,10 +18,20 @@ HttpServer::HttpServer(int port, const std::string& host)
     server_->set_read_timeout(5, 0);  
     server_->set_write_timeout(5, 0); 
 
+    // Вызывается для каждого запроса, включая встроенные обработчики
     server_->set_logger([](const auto& req, const auto& res) {
+        Metrics::increment(Counter::HttpRequests);
         Logger::debug("HTTP {} {} -> {}", req.method, req.path, res.status);
     });
     
+    // SO_REUSEPORT: при передаче работы (session/session_handoff.h) новый процесс занимает
+    // порт, пока старый ещё слушает. Слушающий сокет httplib нельзя передать другому процессу
+    server_->set_socket_options([](auto sock) {
+        int yes = 1;
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes));
+    });
+    
     setup_routes();
 }
 
@@ -26,12 +42,16 @@ HttpServer::~HttpServer() {
 void HttpServer::start() {
     if (running_) return;
     
+    Logger::info("Starting HTTP server on {}:{}", host_, port_);
+    // Порт занимается синхронно: после start() соединения уже принимаются
+    if (server_->bind_to_port(host_, port_) < 0) {
+        Logger::error("HTTP server failed to start on port {}", port_);
+        return;
+    }
+
     running_ = true;
     server_thread_ = std::thread([this]() {
-        Logger::info("Starting HTTP server on {}:{}", host_, port_);
-        if (!server_->listen(host_.c_str(), port_)) {
-            Logger::error("HTTP server failed to start on port {}", port_);
-        }
+        server_->listen_after_bind();
     });
 }
 
@@ -53,10 +73,11 @@ bool HttpServer::is_running() const noexcept{
 }
 
 void HttpServer::add_get_handler(std::string_view path, RequestHandler handler) {
-    server_->Get(std::string(path), [this, handler](const httplib::Request& req, httplib::Response& res) {
-        ++request_count_;
-        handler(req, res);
-    });
+    server_->Get(std::string(path), handler);
+}
+
+void HttpServer::add_post_handler(std::string_view path, RequestHandler handler) {
+    server_->Post(std::string(path), handler);
 }
 
 
@@ -64,8 +85,79 @@ void HttpServer::setup_routes() {
     server_->Get("/health", [this](const auto& req, auto& res) {
         handle_health_check(req, res);
     });
+
+    server_->Get("/metrics", [this](const auto& req, auto& res) {
+        handle_metrics(req, res);
+    });
+
+    server_->Get("/latency", [this](const auto& req, auto& res) {
+        handle_latency(req, res);
+    });
+
+    server_->Get("/debug/profile", [this](const auto& req, auto& res) {
+        handle_profile(req, res);
+    });
+
+    server_->Get("/debug/slow_requests", [this](const auto& req, auto& res) {
+        handle_slow_requests(req, res);
+    });
 }
 
 void HttpServer::handle_health_check(const httplib::Request&, httplib::Response& res) {
     res.set_content(R"({"status":"ok"})", "application/json");
-}
\ No newline at end of file
+}
+
+void HttpServer::handle_metrics(const httplib::Request&, httplib::Response& res) {
+    res.set_content(Metrics::render_prometheus(), "text/plain; version=0.0.4");
+}
+
+void HttpServer::handle_latency(const httplib::Request&, httplib::Response& res) {
+    res.set_content(Latency::render_json(), "application/json");
+}
+
+void HttpServer::handle_profile(const httplib::Request& req, httplib::Response& res) {
+    int seconds = 10;
+    int hz = 99;
+    try {
+        if (req.has_param("seconds")) seconds = std::stoi(req.get_param_value("seconds"));
+        if (req.has_param("hz")) hz = std::stoi(req.get_param_value("hz"));
+    } catch (const std::exception&) {
+        res.status = 400;
+        res.set_content("Invalid seconds or hz", "text/plain");
+        return;
+    }
+
+    try {
+        Logger::info("CPU profile started: {} s at {} Hz", seconds, hz);
+        const auto result = Profiler::profile(std::chrono::seconds(seconds), hz);
+        Logger::info("CPU profile finished: {} samples, {} dropped", result.samples, result.dropped);
+        res.set_header("X-Profile-Samples", std::to_string(result.samples));
+        res.set_header("X-Profile-Dropped", std::to_string(result.dropped));
+        res.set_content(result.folded, "text/plain");
+    } catch (const std::system_error& e) {
+        Logger::error("CPU profile failed: {}", e.what());
+        res.status = 500;
+        res.set_content(e.what(), "text/plain");
+    } catch (const std::runtime_error& e) {
+        res.status = 409;
+        res.set_content(e.what(), "text/plain");
+    }
+}
+
+void HttpServer::handle_slow_requests(const httplib::Request& req, httplib::Response& res) {
+    size_t recent = 100;
+    if (req.has_param("recent")) {
+        try {
+            recent = std::min<size_t>(std::stoul(req.get_param_value("recent")), RequestTraces::kRingSize);
+        } catch (const std::exception&) {
+            res.status = 400;
+            res.set_content("Invalid recent", "text/plain");
+            return;
+        }
+    }
+
+    res.set_content(RequestTraces::render_json(recent), "application/json");
+    if (req.get_param_value("reset") == "1") {
+        RequestTraces::reset_slowest();
+    }
+}
@@ -0,0 +1,143 @@
+#include "metrics/latency.h"
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+constexpr size_t kStageCount = static_cast<size_t>(Stage::Count);
+
+struct alignas(64) StageHistograms {
+    LatencyHistogram stages[kStageCount];
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<StageHistograms*> threads;
+    StageHistograms retired;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();  // не разрушается: потоки могут завершаться после main
+    return *instance;
+}
+
+struct ThreadHistograms {
+    StageHistograms* histograms;
+
+    ThreadHistograms() : histograms(new StageHistograms()) {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.threads.push_back(histograms);
+    }
+
+    ~ThreadHistograms() {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        for (size_t i = 0; i < kStageCount; ++i) {
+            reg.retired.stages[i].merge(histograms->stages[i]);
+        }
+        reg.threads.erase(std::find(reg.threads.begin(), reg.threads.end(), histograms));
+        delete histograms;
+    }
+};
+
+StageHistograms& local_histograms() noexcept {
+    thread_local ThreadHistograms handle;
+    return *handle.histograms;
+}
+
+double to_micros(uint64_t nanos) {
+    return static_cast<double>(nanos) / 1000.0;
+}
+
+} // namespace
+
+void LatencyHistogram::merge(const LatencyHistogram& other) noexcept {
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        const uint64_t count = other.counts_[i].load(std::memory_order_relaxed);
+        if (count != 0) bump(counts_[i], count);
+    }
+    bump(total_count_, other.total_count_.load(std::memory_order_relaxed));
+    bump(sum_, other.sum_.load(std::memory_order_relaxed));
+    max_.store(std::max(max(), other.max()), std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() noexcept {
+    for (auto& count : counts_) count.store(0, std::memory_order_relaxed);
+    total_count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const noexcept {
+    const uint64_t total = count();
+    return total == 0 ? 0.0 : static_cast<double>(sum_.load(std::memory_order_relaxed)) / total;
+}
+
+uint64_t LatencyHistogram::value_at_percentile(double percentile) const noexcept {
+    const uint64_t total = count();
+    if (total == 0) return 0;
+
+    const double clamped = std::clamp(percentile, 0.0, 100.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(clamped / 100.0 * total + 0.5));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i) {
+        seen += counts_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucket_upper_bound(i), max());
+        }
+    }
+    return max();
+}
+
+void Latency::record(Stage stage, uint64_t nanos) noexcept {
+    local_histograms().stages[static_cast<size_t>(stage)].record(nanos);
+}
+
+void Latency::snapshot(Stage stage, LatencyHistogram& out) {
+    const size_t index = static_cast<size_t>(stage);
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+
+    out.merge(reg.retired.stages[index]);
+    for (const auto* histograms : reg.threads) {
+        out.merge(histograms->stages[index]);
+    }
+}
+
+std::string Latency::render_json() {
+    nlohmann::json body = nlohmann::json::object();
+
+    for (size_t i = 0; i < kStageCount; ++i) {
+        const Stage stage = static_cast<Stage>(i);
+        LatencyHistogram merged;
+        snapshot(stage, merged);
+
+        body[stage_name(stage)] = {
+            {"count", merged.count()},
+            {"mean_us", to_micros(static_cast<uint64_t>(merged.mean()))},
+            {"p50_us", to_micros(merged.value_at_percentile(50.0))},
+            {"p90_us", to_micros(merged.value_at_percentile(90.0))},
+            {"p99_us", to_micros(merged.value_at_percentile(99.0))},
+            {"p999_us", to_micros(merged.value_at_percentile(99.9))},
+            {"max_us", to_micros(merged.max())}
+        };
+    }
+    return body.dump(2);
+}
+
+const char* Latency::stage_name(Stage stage) noexcept {
+    switch (stage) {
+        case Stage::Receive: return "receive";
+        case Stage::Decode: return "decode";
+        case Stage::SessionCreate: return "session_create";
+        case Stage::CdrEnqueue: return "cdr_enqueue";
+        case Stage::Send: return "send";
+        case Stage::Total: return "total";
+        case Stage::Count: break;
+    }
+    return "unknown";
+}
@@ -0,0 +1,161 @@
+#include "metrics/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct CounterInfo {
+    const char* name;
+    const char* help;
+};
+
+constexpr CounterInfo kCounters[] = {
+    {"pgw_udp_packets_received_total", "UDP datagrams received"},
+    {"pgw_udp_packets_sent_total", "UDP datagrams sent"},
+    {"pgw_udp_decode_failures_total", "Datagrams that failed BCD decoding or IMSI validation"},
+    {"pgw_sessions_created_total", "Sessions created"},
+    {"pgw_sessions_prolonged_total", "Existing sessions prolonged by a repeated attach"},
+    {"pgw_sessions_rejected_total", "Attach requests rejected (blacklist or invalid IMSI)"},
+    {"pgw_sessions_expired_total", "Sessions expired by timeout"},
+    {"pgw_sessions_removed_total", "Sessions removed during graceful shutdown"},
+    {"pgw_cdr_records_written_total", "CDR records written to disk"},
+    {"pgw_cdr_bytes_written_total", "CDR bytes written to disk"},
+    {"pgw_http_requests_total", "HTTP requests served"},
+    {"pgw_session_events_dropped_total", "Session events dropped because a subscriber ring was full"},
+};
+static_assert(std::size(kCounters) == static_cast<size_t>(Counter::Count));
+
+constexpr size_t kCounterCount = static_cast<size_t>(Counter::Count);
+
+// Метрика, значение которой вычисляется при чтении: задана ровно одна из функций
+struct Callback {
+    std::string help;
+    Metrics::GaugeFn gauge;
+    Metrics::CounterFn counter;
+};
+
+// Реестр слотов: мьютекс берётся только при создании/завершении потока и при чтении
+struct Registry {
+    std::mutex mutex;
+    std::vector<Metrics::CounterSlot*> slots;
+    uint64_t retired[kCounterCount] = {};
+    std::map<std::string, Callback> callbacks;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();  // не разрушается: потоки могут завершаться после main
+    return *instance;
+}
+
+struct SlotHandle {
+    Metrics::CounterSlot* slot;
+
+    SlotHandle() : slot(new Metrics::CounterSlot()) {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.slots.push_back(slot);
+    }
+
+    ~SlotHandle() {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        for (size_t i = 0; i < kCounterCount; ++i) {
+            reg.retired[i] += slot->values[i].load(std::memory_order_relaxed);
+        }
+        reg.slots.erase(std::find(reg.slots.begin(), reg.slots.end(), slot));
+        delete slot;
+    }
+};
+
+uint64_t sum_locked(Registry& reg, size_t index) {
+    uint64_t total = reg.retired[index];
+    for (const auto* slot : reg.slots) {
+        total += slot->values[index].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+} // namespace
+
+Metrics::CounterSlot& Metrics::local_slot() noexcept {
+    thread_local SlotHandle handle;
+    return *handle.slot;
+}
+
+uint64_t Metrics::value(Counter counter) {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    return sum_locked(reg, static_cast<size_t>(counter));
+}
+
+void Metrics::register_gauge(const std::string& name, const std::string& help, GaugeFn fn) {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    reg.callbacks[name] = Callback{help, std::move(fn), nullptr};
+}
+
+void Metrics::register_counter(const std::string& name, const std::string& help, CounterFn fn) {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    reg.callbacks[name] = Callback{help, nullptr, std::move(fn)};
+}
+
+void Metrics::unregister_gauge(const std::string& name) {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    reg.callbacks.erase(name);
+}
+
+std::string Metrics::render_prometheus() {
+    uint64_t totals[kCounterCount];
+    std::map<std::string, Callback> callbacks;
+    {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        for (size_t i = 0; i < kCounterCount; ++i) {
+            totals[i] = sum_locked(reg, i);
+        }
+        callbacks = reg.callbacks;
+    }
+
+    std::string out;
+    out.reserve(4096);
+
+    for (size_t i = 0; i < kCounterCount; ++i) {
+        out += "# HELP ";
+        out += kCounters[i].name;
+        out += ' ';
+        out += kCounters[i].help;
+        out += "\n# TYPE ";
+        out += kCounters[i].name;
+        out += " counter\n";
+        out += kCounters[i].name;
+        out += ' ';
+        out += std::to_string(totals[i]);
+        out += '\n';
+    }
+
+    // Функции метрик вызываются без мьютекса реестра: они сами берут блокировки компонентов
+    for (const auto& [name, callback] : callbacks) {
+        out += "# HELP " + name + " " + callback.help + "\n";
+        if (callback.counter) {
+            out += "# TYPE " + name + " counter\n";
+            out += name + " " + std::to_string(callback.counter()) + "\n";
+            continue;
+        }
+        const double value = callback.gauge();
+        out += "# TYPE " + name + " gauge\n";
+        out += name + " ";
+        if (std::isfinite(value) && value == std::floor(value) && std::fabs(value) < 1e15) {
+            out += std::to_string(static_cast<int64_t>(value));
+        } else {
+            out += std::to_string(value);
+        }
+        out += '\n';
+    }
+
+    return out;
+}
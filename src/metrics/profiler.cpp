@@ -0,0 +1,172 @@
+#include "metrics/profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <sys/time.h>
+
+namespace {
+
+struct Sample {
+    int depth;
+    void* frames[Profiler::kMaxDepth];
+};
+
+// Состояние активного профиля; обработчик сигнала видит его только через атомики
+std::atomic<bool> active{false};
+std::atomic<Sample*> samples{nullptr};
+std::atomic<size_t> capacity{0};
+std::atomic<size_t> next_sample{0};
+
+// ~34 МБ: ограничивает память профиля при любой длительности и числе ядер
+constexpr size_t kMaxSamples = 65536;
+
+// Кадры самого обработчика и трамплина сигнала
+constexpr int kSkipFrames = 2;
+
+void on_sigprof(int, siginfo_t*, void*) {
+    const int saved_errno = errno;
+    const size_t index = next_sample.fetch_add(1, std::memory_order_relaxed);
+    if (index < capacity.load(std::memory_order_acquire)) {
+        Sample& sample = samples.load(std::memory_order_relaxed)[index];
+        sample.depth = backtrace(sample.frames, static_cast<int>(Profiler::kMaxDepth));
+    }
+    errno = saved_errno;
+}
+
+std::string symbolize(void* address) {
+    Dl_info info{};
+    if (dladdr(address, &info) == 0) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%p", address);
+        return buffer;
+    }
+
+    if (info.dli_sname != nullptr) {
+        int status = 0;
+        std::unique_ptr<char, decltype(&std::free)> demangled(
+            abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status), &std::free);
+        std::string name = status == 0 ? demangled.get() : info.dli_sname;
+        // ';' - разделитель кадров в folded-формате
+        std::replace(name.begin(), name.end(), ';', ':');
+        return name;
+    }
+
+    const char* module = info.dli_fname != nullptr ? std::strrchr(info.dli_fname, '/') : nullptr;
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer), "%s+0x%zx",
+        module != nullptr ? module + 1 : "??",
+        static_cast<size_t>(static_cast<char*>(address) - static_cast<char*>(info.dli_fbase)));
+    return buffer;
+}
+
+std::string fold(const Sample* collected, size_t count) {
+    std::unordered_map<void*, std::string> names;
+    std::map<std::string, size_t> stacks;
+
+    for (size_t i = 0; i < count; ++i) {
+        const Sample& sample = collected[i];
+        std::string stack;
+        // Корень стека первым
+        for (int f = sample.depth - 1; f >= kSkipFrames; --f) {
+            auto [it, inserted] = names.try_emplace(sample.frames[f]);
+            if (inserted) it->second = symbolize(sample.frames[f]);
+            if (!stack.empty()) stack += ';';
+            stack += it->second;
+        }
+        if (!stack.empty()) ++stacks[stack];
+    }
+
+    std::string out;
+    for (const auto& [stack, hits] : stacks) {
+        out += stack;
+        out += ' ';
+        out += std::to_string(hits);
+        out += '\n';
+    }
+    return out;
+}
+
+// Снимает флаг профиля при любом выходе из profile(), в том числе по исключению
+struct ActiveReset {
+    ~ActiveReset() { active.store(false); }
+};
+
+} // namespace
+
+Profiler::Result Profiler::profile(std::chrono::seconds duration, int hz) {
+    if (active.exchange(true)) {
+        throw std::runtime_error("Profile already in progress");
+    }
+    const ActiveReset reset_active;
+
+    duration = std::clamp(duration, std::chrono::seconds(1), kMaxDuration);
+    hz = std::clamp(hz, 1, kMaxHz);
+
+    // Первый вызов backtrace подгружает libgcc - делаем его здесь, а не в обработчике
+    void* warmup[1];
+    backtrace(warmup, 1);
+
+    // Запас на случай, если несколько потоков заняты CPU одновременно
+    const auto hardware = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<Sample> buffer(std::min<size_t>(kMaxSamples, static_cast<size_t>(duration.count()) * hz * hardware));
+    samples.store(buffer.data(), std::memory_order_relaxed);
+    next_sample.store(0, std::memory_order_relaxed);
+    capacity.store(buffer.size(), std::memory_order_release);
+
+    struct sigaction action{};
+    action.sa_sigaction = on_sigprof;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    struct sigaction previous{};
+    sigaction(SIGPROF, &action, &previous);
+
+    // Период до секунды включительно: tv_usec обязан быть меньше 1000000, иначе EINVAL
+    const long period_us = 1000000L / hz;
+    itimerval timer{};
+    timer.it_interval.tv_sec = period_us / 1000000;
+    timer.it_interval.tv_usec = period_us % 1000000;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        const int error = errno;
+        sigaction(SIGPROF, &previous, nullptr);
+        capacity.store(0, std::memory_order_relaxed);
+        samples.store(nullptr, std::memory_order_relaxed);
+        throw std::system_error(error, std::generic_category(), "setitimer(ITIMER_PROF)");
+    }
+
+    std::this_thread::sleep_for(duration);
+
+    itimerval off{};
+    setitimer(ITIMER_PROF, &off, nullptr);
+    // Уже доставленные сигналы не должны застать прежний обработчик (SIG_DFL завершил бы
+    // процесс): пока они не дошли, SIGPROF игнорируется, затем обработчик восстанавливается
+    struct sigaction ignore{};
+    ignore.sa_handler = SIG_IGN;
+    sigemptyset(&ignore.sa_mask);
+    sigaction(SIGPROF, &ignore, nullptr);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    sigaction(SIGPROF, &previous, nullptr);
+
+    Result result;
+    const size_t taken = next_sample.load(std::memory_order_relaxed);
+    result.samples = std::min(taken, buffer.size());
+    result.dropped = taken - result.samples;
+
+    // Обработчик больше не вызывается: буфер можно читать и освобождать
+    capacity.store(0, std::memory_order_relaxed);
+    samples.store(nullptr, std::memory_order_relaxed);
+    result.folded = fold(buffer.data(), result.samples);
+    return result;
+}
@@ -0,0 +1,206 @@
+#include "metrics/request_trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+#include <arpa/inet.h>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+static_assert(std::is_trivially_copyable_v<RequestTrace>);
+constexpr size_t kTraceWords = (sizeof(RequestTrace) + 7) / 8;
+
+struct RingEntry {
+    // Нечётное - запись в процессе; 2 * (номер + 1) - запись с этим номером готова
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> words[kTraceWords] = {};
+};
+
+struct alignas(64) TraceRing {
+    std::atomic<uint64_t> head{0};
+    RingEntry entries[RequestTraces::kRingSize];
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<TraceRing*> rings;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();  // не разрушается: потоки могут завершаться после main
+    return *instance;
+}
+
+struct RingHandle {
+    TraceRing* ring;
+
+    RingHandle() : ring(new TraceRing()) {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.rings.push_back(ring);
+    }
+
+    ~RingHandle() {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.rings.erase(std::find(reg.rings.begin(), reg.rings.end(), ring));
+        delete ring;
+    }
+};
+
+TraceRing& local_ring() noexcept {
+    thread_local RingHandle handle;
+    return *handle.ring;
+}
+
+std::atomic<uint64_t> slow_threshold_nanos{0};
+
+struct SlowestSet {
+    std::mutex mutex;
+    std::vector<RequestTrace> heap;   // min-heap по total: в вершине самый быстрый из сохранённых
+};
+
+SlowestSet& slowest_set() {
+    static SlowestSet* instance = new SlowestSet();
+    return *instance;
+}
+
+bool slower(const RequestTrace& a, const RequestTrace& b) {
+    return a.total_nanos() > b.total_nanos();
+}
+
+void write_entry(RingEntry& entry, uint64_t number, const RequestTrace& trace) noexcept {
+    uint64_t words[kTraceWords] = {};
+    std::memcpy(words, &trace, sizeof(trace));
+
+    entry.sequence.store(2 * number + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kTraceWords; ++i) {
+        entry.words[i].store(words[i], std::memory_order_relaxed);
+    }
+    entry.sequence.store(2 * number + 2, std::memory_order_release);
+}
+
+bool read_entry(const RingEntry& entry, uint64_t number, RequestTrace& out) noexcept {
+    const uint64_t expected = 2 * number + 2;
+    if (entry.sequence.load(std::memory_order_acquire) != expected) return false;
+
+    uint64_t words[kTraceWords];
+    for (size_t i = 0; i < kTraceWords; ++i) {
+        words[i] = entry.words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (entry.sequence.load(std::memory_order_relaxed) != expected) return false;
+
+    std::memcpy(&out, words, sizeof(out));
+    return true;
+}
+
+nlohmann::json to_json(const RequestTrace& trace) {
+    char ip[INET_ADDRSTRLEN] = {};
+    in_addr addr{trace.source_ip};
+    inet_ntop(AF_INET, &addr, ip, sizeof(ip));
+
+    nlohmann::json stages = nlohmann::json::object();
+    for (size_t i = 0; i < RequestTrace::kStageCount; ++i) {
+        stages[Latency::stage_name(static_cast<Stage>(i))] = trace.stage_nanos[i] / 1000.0;
+    }
+    return {
+        {"timestamp_ms", trace.timestamp_ms},
+        {"imsi", trace.imsi.to_string()},
+        {"source", std::string(ip) + ":" + std::to_string(ntohs(trace.source_port))},
+        {"total_us", trace.total_nanos() / 1000.0},
+        {"stages_us", std::move(stages)}
+    };
+}
+
+} // namespace
+
+void RequestTraces::record(const RequestTrace& trace) noexcept {
+    TraceRing& ring = local_ring();
+    const uint64_t number = ring.head.load(std::memory_order_relaxed);
+    write_entry(ring.entries[number % kRingSize], number, trace);
+    ring.head.store(number + 1, std::memory_order_release);
+
+    const uint64_t threshold = slow_threshold_nanos.load(std::memory_order_relaxed);
+    if (threshold == 0 || trace.total_nanos() < threshold) return;
+
+    // Медленный путь: запросы выше порога редки
+    auto& set = slowest_set();
+    std::lock_guard lock(set.mutex);
+    if (set.heap.size() < kSlowestCapacity) {
+        set.heap.push_back(trace);
+        std::push_heap(set.heap.begin(), set.heap.end(), slower);
+    } else if (trace.total_nanos() > set.heap.front().total_nanos()) {
+        std::pop_heap(set.heap.begin(), set.heap.end(), slower);
+        set.heap.back() = trace;
+        std::push_heap(set.heap.begin(), set.heap.end(), slower);
+    }
+}
+
+void RequestTraces::set_slow_threshold(std::chrono::microseconds threshold) noexcept {
+    const auto micros = std::max<int64_t>(threshold.count(), 0);
+    slow_threshold_nanos.store(static_cast<uint64_t>(micros) * 1000, std::memory_order_relaxed);
+}
+
+std::chrono::microseconds RequestTraces::slow_threshold() noexcept {
+    return std::chrono::microseconds(slow_threshold_nanos.load(std::memory_order_relaxed) / 1000);
+}
+
+std::vector<RequestTrace> RequestTraces::recent(size_t limit) {
+    std::vector<RequestTrace> traces;
+    {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        for (const auto* ring : reg.rings) {
+            const uint64_t head = ring->head.load(std::memory_order_acquire);
+            const uint64_t available = std::min<uint64_t>({head, kRingSize, limit});
+            for (uint64_t n = head; n > head - available; --n) {
+                RequestTrace trace;
+                if (read_entry(ring->entries[(n - 1) % kRingSize], n - 1, trace)) {
+                    traces.push_back(trace);
+                }
+            }
+        }
+    }
+
+    std::sort(traces.begin(), traces.end(), [](const auto& a, const auto& b) {
+        return a.timestamp_ms > b.timestamp_ms;
+    });
+    if (traces.size() > limit) traces.resize(limit);
+    return traces;
+}
+
+std::vector<RequestTrace> RequestTraces::slowest() {
+    auto& set = slowest_set();
+    std::vector<RequestTrace> traces;
+    {
+        std::lock_guard lock(set.mutex);
+        traces = set.heap;
+    }
+    std::sort(traces.begin(), traces.end(), slower);
+    return traces;
+}
+
+void RequestTraces::reset_slowest() {
+    auto& set = slowest_set();
+    std::lock_guard lock(set.mutex);
+    set.heap.clear();
+}
+
+std::string RequestTraces::render_json(size_t recent_limit) {
+    nlohmann::json slow = nlohmann::json::array();
+    for (const auto& trace : slowest()) slow.push_back(to_json(trace));
+
+    nlohmann::json latest = nlohmann::json::array();
+    for (const auto& trace : recent(recent_limit)) latest.push_back(to_json(trace));
+
+    nlohmann::json body = {
+        {"threshold_us", slow_threshold().count()},
+        {"slowest", std::move(slow)},
+        {"recent", std::move(latest)}
+    };
+    return body.dump(2);
+}
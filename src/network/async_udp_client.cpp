@@ -0,0 +1,297 @@
+#include "network/async_udp_client.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "network/request_tag.h"
+#include "utils/logger.h"
+
+namespace {
+
+constexpr int kSocketBufferBytes = 4 * 1024 * 1024;
+constexpr auto kMaxLoopWait = std::chrono::milliseconds(10);
+constexpr size_t kMaxDatagram = 2048;
+
+} // namespace
+
+void RttEstimator::sample(Duration rtt) noexcept {
+    if (!has_samples_) {
+        srtt_ = rtt;
+        rttvar_ = rtt / 2;
+        has_samples_ = true;
+    } else {
+        const Duration error = srtt_ > rtt ? srtt_ - rtt : rtt - srtt_;
+        rttvar_ = (3 * rttvar_ + error) / 4;
+        srtt_ = (7 * srtt_ + rtt) / 8;
+    }
+    rto_ = std::clamp(srtt_ + 4 * rttvar_, min_rto_, max_rto_);
+}
+
+RttEstimator::Duration RttEstimator::hedge_delay() const noexcept {
+    if (!has_samples_) return rto_;
+    return std::clamp(srtt_ + 2 * rttvar_, min_rto_, rto_);
+}
+
+AsyncUdpClient::AsyncUdpClient(std::string_view server_ip, int server_port)
+    : AsyncUdpClient(server_ip, server_port, Options{}) {}
+
+AsyncUdpClient::AsyncUdpClient(std::string_view server_ip, int server_port, const Options& options)
+    : options_(options),
+      rtt_(options.initial_rto, options.min_rto, options.max_rto),
+      retry_budget_(options.retry_budget_burst) {
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(server_port);
+    if (inet_pton(AF_INET, std::string(server_ip).c_str(), &server_addr.sin_addr) <= 0) {
+        Logger::get_logger()->error("Invalid server address: {}", server_ip);
+        return;
+    }
+
+    sockfd_ = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (sockfd_ < 0) {
+        Logger::get_logger()->error("Socket creation failed: {}", strerror(errno));
+        return;
+    }
+    setsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+    setsockopt(sockfd_, SOL_SOCKET, SO_SNDBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+
+    // connect: send без адреса на каждый пакет, приём только от сервера
+    if (connect(sockfd_, reinterpret_cast<const sockaddr*>(&server_addr), sizeof(server_addr)) < 0) {
+        Logger::get_logger()->error("UDP connect failed: {}", strerror(errno));
+        close(sockfd_);
+        sockfd_ = -1;
+        return;
+    }
+
+    epoll_fd_ = epoll_create1(0);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = sockfd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, sockfd_, &event);
+    event.data.fd = wake_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+
+    running_ = true;
+    loop_thread_ = std::thread(&AsyncUdpClient::event_loop, this);
+}
+
+AsyncUdpClient::~AsyncUdpClient() {
+    if (running_.exchange(false)) {
+        const uint64_t one = 1;
+        (void)::write(wake_fd_, &one, sizeof(one));
+        loop_thread_.join();
+    }
+
+    std::unordered_map<uint32_t, Pending> abandoned;
+    {
+        std::lock_guard lock(mutex_);
+        abandoned.swap(pending_);
+    }
+    for (auto& [tag, pending] : abandoned) {
+        pending.callback(Status::Closed, {});
+    }
+
+    if (wake_fd_ != -1) close(wake_fd_);
+    if (epoll_fd_ != -1) close(epoll_fd_);
+    if (sockfd_ != -1) close(sockfd_);
+}
+
+void AsyncUdpClient::send(std::string_view payload, Callback callback, bool hedged) {
+    if (!running_ || payload.size() + RequestTag::kHeaderSize > kMaxDatagram) {
+        callback(running_ ? Status::SendFailed : Status::Closed, {});
+        return;
+    }
+
+    // Запрос регистрируется до отправки: ответ может прийти раньше, чем вернётся send
+    uint32_t tag;
+    std::string datagram(RequestTag::kHeaderSize + payload.size(), '\0');
+    {
+        std::lock_guard lock(mutex_);
+        do {
+            tag = next_tag_++;
+        } while (pending_.contains(tag));
+
+        RequestTag::write_header(tag, datagram.data());
+        std::memcpy(datagram.data() + RequestTag::kHeaderSize, payload.data(), payload.size());
+
+        const auto now = std::chrono::steady_clock::now();
+        Pending pending;
+        pending.callback = std::move(callback);
+        pending.datagram = datagram;
+        pending.first_sent = now;
+        pending.deadline = now + options_.timeout;
+        pending.retransmit_at = now + rtt_.rto();
+        // Без замеров RTT момент для дубля не определить: остаются только повторы
+        pending.hedge_at = hedged && rtt_.has_samples() ? now + rtt_.hedge_delay() : TimePoint::max();
+        schedule(tag, pending_.emplace(tag, std::move(pending)).first->second);
+
+        ++stats_.requests;
+        retry_budget_ = std::min(retry_budget_ + options_.retry_budget_ratio, options_.retry_budget_burst);
+    }
+
+    if (::send(sockfd_, datagram.data(), datagram.size(), 0) != static_cast<ssize_t>(datagram.size())) {
+        PGW_LOG_ERROR_RATE(kPacketLogPerSecond, "Send failed: {}", strerror(errno));
+        Callback failed;
+        {
+            std::lock_guard lock(mutex_);
+            auto it = pending_.find(tag);
+            if (it == pending_.end()) return;
+            failed = std::move(it->second.callback);
+            pending_.erase(it);
+        }
+        failed(Status::SendFailed, {});
+    }
+}
+
+size_t AsyncUdpClient::in_flight() const {
+    std::lock_guard lock(mutex_);
+    return pending_.size();
+}
+
+AsyncUdpClient::Stats AsyncUdpClient::stats() const {
+    std::lock_guard lock(mutex_);
+    Stats stats = stats_;
+    stats.srtt = std::chrono::duration_cast<std::chrono::microseconds>(rtt_.srtt());
+    stats.rttvar = std::chrono::duration_cast<std::chrono::microseconds>(rtt_.rttvar());
+    stats.rto = std::chrono::duration_cast<std::chrono::microseconds>(rtt_.rto());
+    return stats;
+}
+
+void AsyncUdpClient::event_loop() {
+    epoll_event events[2];
+    char buffer[kMaxDatagram];
+
+    while (running_) {
+        int wait_ms = static_cast<int>(kMaxLoopWait.count());
+        {
+            std::lock_guard lock(mutex_);
+            if (!timers_.empty()) {
+                const auto until = timers_.top().at - std::chrono::steady_clock::now();
+                const auto until_ms = std::chrono::ceil<std::chrono::milliseconds>(until).count();
+                wait_ms = static_cast<int>(std::clamp<int64_t>(until_ms, 0, wait_ms));
+            }
+        }
+
+        const int ready = epoll_wait(epoll_fd_, events, 2, wait_ms);
+        if (ready < 0 && errno != EINTR) {
+            Logger::get_logger()->error("epoll_wait error: {}", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            if (events[i].data.fd != sockfd_) continue;
+            for (;;) {
+                const ssize_t received = recv(sockfd_, buffer, sizeof(buffer), 0);
+                if (received < 0) break;   // EAGAIN или ICMP-ошибка: запрос повторится по таймеру
+                handle_datagram(std::string_view(buffer, static_cast<size_t>(received)));
+            }
+        }
+
+        process_timers(std::chrono::steady_clock::now());
+    }
+}
+
+void AsyncUdpClient::handle_datagram(std::string_view datagram) {
+    uint32_t tag = 0;
+    std::string_view body;
+    if (!RequestTag::parse(datagram, tag, body)) {
+        PGW_LOG_WARN_RATE(kPacketLogPerSecond, "Untagged response ignored ({} bytes)", datagram.size());
+        return;
+    }
+
+    Callback callback;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = pending_.find(tag);
+        if (it == pending_.end()) return;   // ответ на дубль или после срока
+        // Алгоритм Карна: по повторённым запросам RTT не замеряется - неизвестно, на какую попытку ответ
+        if (!it->second.resent) {
+            rtt_.sample(std::chrono::steady_clock::now() - it->second.first_sent);
+        }
+        ++stats_.replies;
+        callback = std::move(it->second.callback);
+        pending_.erase(it);
+    }
+    callback(Status::Ok, body);
+}
+
+void AsyncUdpClient::process_timers(TimePoint now) {
+    std::vector<Callback> expired;
+    std::vector<std::string> resend;
+    {
+        std::lock_guard lock(mutex_);
+        while (!timers_.empty() && timers_.top().at <= now) {
+            const Timer timer = timers_.top();
+            timers_.pop();
+            auto it = pending_.find(timer.tag);
+            if (it == pending_.end() || it->second.generation != timer.generation) continue;
+            Pending& pending = it->second;
+
+            if (now >= pending.deadline) {
+                ++stats_.timeouts;
+                expired.push_back(std::move(pending.callback));
+                pending_.erase(it);
+                continue;
+            }
+
+            if (now >= pending.hedge_at) {
+                pending.hedge_at = TimePoint::max();
+                if (take_budget()) {
+                    ++stats_.hedges;
+                    pending.resent = true;
+                    resend.push_back(pending.datagram);
+                }
+            } else if (now >= pending.retransmit_at) {
+                if (take_budget()) {
+                    ++stats_.retransmits;
+                    pending.resent = true;
+                    resend.push_back(pending.datagram);
+                }
+                ++pending.retries;
+                // Экспоненциальная задержка: каждая следующая попытка ждёт вдвое дольше
+                const auto backoff = rtt_.rto() * (1 << std::min(pending.retries, 10));
+                pending.retransmit_at = pending.retries < options_.max_retries
+                    ? now + std::min<RttEstimator::Duration>(backoff, options_.max_rto)
+                    : TimePoint::max();
+            }
+            schedule(timer.tag, pending);
+        }
+    }
+
+    for (const auto& datagram : resend) {
+        if (::send(sockfd_, datagram.data(), datagram.size(), 0) < 0) {
+            PGW_LOG_ERROR_RATE(kPacketLogPerSecond, "Retransmit failed: {}", strerror(errno));
+        }
+    }
+    for (auto& callback : expired) {
+        callback(Status::Timeout, {});
+    }
+}
+
+void AsyncUdpClient::schedule(uint32_t tag, Pending& pending) {
+    const TimePoint at = std::min({pending.deadline, pending.retransmit_at, pending.hedge_at});
+    timers_.push(Timer{at, tag, ++pending.generation});
+}
+
+bool AsyncUdpClient::take_budget() {
+    if (retry_budget_ < 1.0) {
+        ++stats_.budget_exhausted;
+        return false;
+    }
+    retry_budget_ -= 1.0;
+    return true;
+}
+
+const char* AsyncUdpClient::status_name(Status status) noexcept {
+    switch (status) {
+        case Status::Ok: return "ok";
+        case Status::Timeout: return "timeout";
+        case Status::SendFailed: return "send_failed";
+        case Status::Closed: return "closed";
+    }
+    return "unknown";
+}
@@ -52,7 +52,7 @@ bool UdpClient::send(std::string_view message, std::string& response) {
         Logger::get_logger()->error("Send failed: {}", strerror(errno));
         return false;
     }
-    Logger::get_logger()->info("Sent {} bytes to server", sent);
+    PGW_LOG_DEBUG("Sent {} bytes to server", sent);
     
     // Получение ответа
     char buffer[1024];
@@ -68,7 +68,7 @@ bool UdpClient::send(std::string_view message, std::string& response) {
     
     buffer[received] = '\0';
     response = buffer;
-    Logger::get_logger()->info("Received {} bytes from server: {}", received, response);
+    PGW_LOG_DEBUG("Received {} bytes from server: {}", received, response);
     
     return true;
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include <stdexcept>
 #include <system_error>
 #include "utils/logger.h"
+#include "metrics/metrics.h"
+#include "metrics/latency.h"
 
 UdpServer::UdpServer(std::string_view ip, int port, MessageHandler handler)
     : ip_(ip), port_(port), message_handler_(std::move(handler)) {
@@ -14,6 +16,22 @@ UdpServer::UdpServer(std::string_view ip, int port, MessageHandler handler)
     }
 }
 
+UdpServer::UdpServer(int sockfd, MessageHandler handler)
+    : sockfd_(sockfd), port_(0), message_handler_(std::move(handler)) {
+
+    struct sockaddr_in addr{};
+    socklen_t addr_len = sizeof(addr);
+    if (getsockname(sockfd_, (struct sockaddr*)&addr, &addr_len) == 0) {
+        ip_ = inet_ntoa(addr.sin_addr);
+        port_ = ntohs(addr.sin_port);
+    }
+    // Датаграммы, пришедшие во время передачи, уже в очереди сокета: epoll сообщит о них сразу
+    if (!setup_epoll()) {
+        throw std::runtime_error("Failed to initialize UDP server");
+    }
+    Logger::get_logger()->debug("UDP socket adopted from previous process");
+}
+
 UdpServer::~UdpServer() {
     stop();
     if (sockfd_ != -1) close(sockfd_);
@@ -62,7 +80,7 @@ void UdpServer::worker_thread() {
         for (int i = 0; i < num_events; ++i) {
             if (events[i].data.fd == sockfd_) {
                 handle_events();
-                Logger::get_logger()->info("Server recieved data");
+                PGW_LOG_TRACE("Server received data");
             }
         }
     }
@@ -97,6 +115,10 @@ bool UdpServer::setup_socket() {
 
     int recv_buf_size = 1024 * 1024; 
     setsockopt(sockfd_, SOL_SOCKET, SO_RCVBUF, &recv_buf_size, sizeof(recv_buf_size));
+
+    // Метка времени приёма от ядра: по ней считается ожидание в очереди сокета
+    int timestamps = 1;
+    setsockopt(sockfd_, SOL_SOCKET, SO_TIMESTAMPNS, &timestamps, sizeof(timestamps));
     
     Logger::get_logger()->debug("UDP socket configured successfully");
     return true;
@@ -125,31 +147,65 @@ bool UdpServer::setup_epoll() {
 }
 
 void UdpServer::handle_events() {
-    socklen_t addr_len = sizeof(client_addr_);
+    struct iovec iov{buffer_, sizeof(buffer_)};
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(struct timespec))];
 
     while (running_) {
-        ssize_t bytes_received = recvfrom(sockfd_, buffer_, sizeof(buffer_), 0,
-                                        (struct sockaddr*)&client_addr_, &addr_len);
+        struct msghdr msg{};
+        msg.msg_name = &client_addr_;
+        msg.msg_namelen = sizeof(client_addr_);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        ssize_t bytes_received = recvmsg(sockfd_, &msg, 0);
         
         if (bytes_received <= 0) {
             if (errno == EAGAIN || errno == EWOULDBLOCK) break;
-            Logger::get_logger()->error("Receive error: {}", strerror(errno));
+            PGW_LOG_ERROR_RATE(kPacketLogPerSecond, "Receive error: {}", strerror(errno));
             break;
         }
-        
+
+        Metrics::increment(Counter::UdpPacketsIn);
+        record_queue_delay(msg);
+
         try {
             std::string message(buffer_, bytes_received);
-            Logger::get_logger()->debug("Received {} bytes from {}:{}", 
+            PGW_LOG_DEBUG_SAMPLED(kPacketLogSampleRate, "Received {} bytes from {}:{}", 
                          bytes_received, 
                          inet_ntoa(client_addr_.sin_addr), 
                          ntohs(client_addr_.sin_port));
             
             message_handler_(message, client_addr_);
         } catch (const std::exception& e) {
-            Logger::get_logger()->error("Message handling error: {}", e.what());
+            PGW_LOG_ERROR_RATE(kPacketLogPerSecond, "Message handling error: {}", e.what());
         }
     }
 }
+void UdpServer::record_queue_delay(const msghdr& msg) {
+    receive_delay_ns_ = 0;
+    for (const cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(const_cast<msghdr*>(&msg), const_cast<cmsghdr*>(cmsg))) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPNS) continue;
+
+        struct timespec received;
+        memcpy(&received, CMSG_DATA(cmsg), sizeof(received));
+
+        // Метка ядра - CLOCK_REALTIME; clock_gettime через vDSO стоит десятки наносекунд
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        const int64_t delay = (now.tv_sec - received.tv_sec) * 1'000'000'000LL +
+                              (now.tv_nsec - received.tv_nsec);
+        if (delay >= 0) {
+            receive_delay_ns_ = static_cast<uint64_t>(delay);
+            Latency::record(Stage::Receive, receive_delay_ns_);
+        }
+        return;
+    }
+}
+
 void UdpServer::send(std::string_view message, const sockaddr_in& addr) {
     std::lock_guard<std::mutex> lock(send_mutex_);
 
@@ -157,9 +213,10 @@ void UdpServer::send(std::string_view message, const sockaddr_in& addr) {
                                 (struct sockaddr*)&addr, sizeof(addr));
 
     if (sent_bytes < 0) {
-        Logger::get_logger()->error("UDP send failed: {}", strerror(errno));
+        PGW_LOG_ERROR_RATE(kPacketLogPerSecond, "UDP send failed: {}", strerror(errno));
     } else {
-        Logger::get_logger()->debug("Sent {} bytes to {}:{}", sent_bytes,
+        Metrics::increment(Counter::UdpPacketsOut);
+        PGW_LOG_DEBUG_SAMPLED(kPacketLogSampleRate, "Sent {} bytes to {}:{}", sent_bytes,
                       inet_ntoa(addr.sin_addr), ntohs(addr.sin_port));
     }
 }
\ No newline at end of file
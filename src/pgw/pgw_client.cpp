@@ -1,8 +1,11 @@
+#include <algorithm>
 #include <filesystem>
+#include <latch>
+#include <semaphore>
 #include <iostream>
 #include <stdexcept>
 #include "utils/logger.h"
-#include "utils/bcd_converter.h"
+#include "utils/imsi.h"
 #include "pgw/pgw_client.h"
 
 void PgwClient::init(const std::string& config_file) {
@@ -24,9 +27,15 @@ void PgwClient::init(const std::string& config_file) {
         Logger::init(config_->get_log_file(),"client_logger", config_->get_log_level(), config_->get_console_output());
     }
 
-    udp_client_ = std::make_unique<UdpClient>(
+    AsyncUdpClient::Options options;
+    options.timeout = std::chrono::milliseconds(config_->get_request_timeout_ms());
+    options.max_retries = config_->get_max_retries();
+    options.retry_budget_ratio = config_->get_retry_budget_ratio();
+
+    udp_client_ = std::make_unique<AsyncUdpClient>(
         config_->get_server_ip(),
-        config_->get_server_port()
+        config_->get_server_port(),
+        options
     );
 
     Logger::get_logger()->info("PGW Client initialized for server {}:{}",
@@ -37,43 +46,81 @@ void PgwClient::init(const std::string& config_file) {
 
 
 std::string PgwClient::send_imsi(const std::string& imsi) {
-    auto start_f = std::chrono::high_resolution_clock::now();
-    if (!udp_client_ || !udp_client_->is_initialized()) {
+    return submit(imsi).get();
+}
+
+void PgwClient::submit(const std::string& imsi, ResponseCallback callback) {
+    if (!is_ready()) {
         Logger::get_logger()->error("UDP client not initialized");
-        return "client_error";
+        callback("client_error");
+        return;
     }
 
-    if (!BCDConverter::validate_imsi(imsi)) {
-        Logger::get_logger()->error("Invalid IMSI format: {}", imsi);
-        return "invalid_imsi";
+    const auto parsed = Imsi::parse(imsi);
+    if (!parsed) {
+        Logger::get_logger()->error("Invalid IMSI format: {} ({})", imsi, imsi_error_message(parsed.error()));
+        callback("invalid_imsi");
+        return;
     }
 
-    Logger::get_logger()->debug("Sending IMSI: {}", imsi);
-
-    std::vector<uint8_t> bcd_data;
-    try {
-        bcd_data = BCDConverter::imsi_to_bcd(imsi);
-    } catch (const std::exception& e) {
-        Logger::get_logger()->error("BCD conversion failed: {}", e.what());
-        return "bcd_error";
-    }
+    PGW_LOG_DEBUG("Sending IMSI: {}", imsi);
+
+    uint8_t bcd_data[Imsi::kMaxBcdBytes];
+    const size_t bcd_size = parsed->to_bcd(bcd_data);
+
+    udp_client_->send(std::string_view(reinterpret_cast<const char*>(bcd_data), bcd_size),
+        [callback = std::move(callback)](AsyncUdpClient::Status status, std::string_view payload) {
+            switch (status) {
+                case AsyncUdpClient::Status::Ok:
+                    PGW_LOG_DEBUG("Received server response: {}", payload);
+                    callback(std::string(payload));
+                    return;
+                case AsyncUdpClient::Status::Timeout:
+                    callback("timeout");
+                    return;
+                case AsyncUdpClient::Status::SendFailed:
+                    callback("network_error");
+                    return;
+                case AsyncUdpClient::Status::Closed:
+                    callback("client_error");
+                    return;
+            }
+        },
+        config_->get_hedge_requests());
+}
 
+std::future<std::string> PgwClient::submit(const std::string& imsi) {
+    auto promise = std::make_shared<std::promise<std::string>>();
+    auto future = promise->get_future();
+    submit(imsi, [promise](std::string response) {
+        promise->set_value(std::move(response));
+    });
+    return future;
+}
 
-    auto start_th = std::chrono::high_resolution_clock::now();
-    std::string response;
-    if (!udp_client_->send(
-            std::string(bcd_data.begin(), bcd_data.end()), 
-            response)) {
-        Logger::get_logger()->error("Failed to send/receive data");
-        return "network_error";
+std::vector<std::string> PgwClient::send_many(const std::vector<std::string>& imsis, size_t max_in_flight) {
+    std::vector<std::string> responses(imsis.size());
+    std::counting_semaphore<> slots(static_cast<std::ptrdiff_t>(std::max<size_t>(max_in_flight, 1)));
+    std::latch done(static_cast<std::ptrdiff_t>(imsis.size()));
+
+    for (size_t i = 0; i < imsis.size(); ++i) {
+        slots.acquire();
+        submit(imsis[i], [&responses, &slots, &done, i](std::string response) {
+            responses[i] = std::move(response);
+            slots.release();
+            done.count_down();
+        });
     }
+    done.wait();
+    return responses;
+}
 
-    Logger::get_logger()->info("Received server response: {}", response);
-    return response;
+AsyncUdpClient::Stats PgwClient::transport_stats() const {
+    return udp_client_ ? udp_client_->stats() : AsyncUdpClient::Stats{};
 }
 
 void PgwClient::interactive_mode() {
-    if (!udp_client_ || !udp_client_->is_initialized()) {
+    if (!is_ready()) {
         std::cerr << "Client not initialized" << std::endl;
         return;
     }
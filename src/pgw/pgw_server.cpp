@@ -1,15 +1,85 @@
+#include <algorithm>
 #include <csignal>
 #include <thread>
 #include <filesystem>
 #include <chrono>
+#include <cstring>
+#include <optional>
 #include <unistd.h>
 #include "pgw/pgw_server.h"
+#include "metrics/metrics.h"
+#include "metrics/latency.h"
+#include "metrics/request_trace.h"
+#include "utils/cycle_clock.h"
+#include "utils/bcd_batch.h"
+#include "network/request_tag.h"
+#include "session/cdr_replay.h"
 
 std::atomic<bool> shutdown_flag{false};
+std::atomic<bool> reload_flag{false};
+
+namespace {
+
+constexpr size_t kMaxBulkImsis = 100000;
+constexpr size_t kBulkChunkSize = 64 * 1024;
+
+// Разбор тела POST /check_subscribers: JSON-массив строк или IMSI по одному на строку
+std::vector<std::string> parse_imsi_list(const std::string& body, bool json) {
+    std::vector<std::string> imsis;
+    if (json) {
+        const auto list = nlohmann::json::parse(body);
+        if (!list.is_array()) {
+            throw std::invalid_argument("expected JSON array of strings");
+        }
+        for (const auto& item : list) {
+            imsis.push_back(item.get<std::string>());
+        }
+        return imsis;
+    }
+
+    size_t pos = 0;
+    while (pos < body.size()) {
+        size_t end = body.find('\n', pos);
+        if (end == std::string::npos) end = body.size();
+        std::string_view line(body.data() + pos, end - pos);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (!line.empty()) imsis.emplace_back(line);
+        pos = end + 1;
+    }
+    return imsis;
+}
+
+// Состояние потоковой выдачи ответа: живёт до последнего чанка
+struct BulkCheckResult {
+    std::vector<std::string> imsis;
+    std::vector<Imsi> parsed;       // только корректные, в порядке imsis
+    std::vector<bool> valid;
+    std::vector<bool> active;       // по одному на элемент parsed
+    size_t next_active = 0;
+    bool json;
+    size_t next = 0;
+};
+
+constexpr auto kEventBatchInterval = std::chrono::milliseconds(100);
+constexpr int kEventKeepaliveBatches = 50;   // комментарий-keepalive раз в ~5 с простоя
+
+// Передача состояния и ответ нового процесса: его init укладывается с большим запасом
+constexpr auto kHandoffTimeout = std::chrono::seconds(30);
+
+constexpr size_t kSessionPageDefault = 1000;
+constexpr size_t kSessionPageMax = 10000;
+
+int64_t expires_in_ms(const SessionInfo& session, std::chrono::steady_clock::time_point now) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(session.expires_at - now).count();
+}
+
+} // namespace
 
 void signal_handler(int signal) {
     if (signal == SIGINT || signal == SIGTERM) {
         shutdown_flag.store(true);
+    } else if (signal == SIGHUP) {
+        reload_flag.store(true);
     }
 }
 
@@ -27,60 +97,361 @@ void PgwServer::init(const std::string& config_file) {
     }
 
     config_ = std::make_unique<ServerConfig>(config_file);
+    config_file_ = config_file;
 
     if (!config_->get_log_file().empty()) {
-        Logger::init(config_->get_log_file(), "server_logger",  config_->get_log_level(), config_->get_console_output());
+        LogOptions log_options;
+        log_options.async = config_->get_log_async();
+        log_options.queue_size = static_cast<size_t>(config_->get_log_queue_size());
+        log_options.drop_on_overflow = config_->get_log_overflow() == "drop";
+        log_options.flush_level = config_->get_log_flush_level();
+        log_options.flush_interval_sec = config_->get_log_flush_interval_sec();
+        Logger::init(config_->get_log_file(), "server_logger",  config_->get_log_level(),
+                     config_->get_console_output(), log_options);
     }
     Logger::get_logger()->info("=== New process started (PID: {}) ===", ::getpid());
 
+    // Калибровка TSC до приёма трафика, чтобы не задерживать первый запрос
+    Logger::get_logger()->debug("Cycle clock: {} ns per tick", CycleClock::nanos_per_tick());
+
+    // Работающий процесс с тем же handoff_socket отдаёт таблицу сессий, не прерывая работы
+    if (!config_->get_handoff_socket().empty()) {
+        handoff_client_ = HandoffClient::connect(config_->get_handoff_socket(), kHandoffTimeout);
+        if (handoff_client_) {
+            Logger::get_logger()->info("Taking over from the running process via {}", config_->get_handoff_socket());
+        }
+    }
+
+    // При передаче работы регион создаётся под скрытым именем до переключения: выделение
+    // страниц и таблица фазы 1 не входят в паузу трафика. Читатели до publish() остаются
+    // на регионе старого процесса, который тот ведёт до самого переключения
+    std::shared_ptr<ShmSessionTable> shm_table;
+    if (!config_->get_shm_session_table().empty()) {
+        shm_table = std::make_shared<ShmSessionTable>(
+            config_->get_shm_session_table(),
+            static_cast<size_t>(config_->get_shm_session_capacity()),
+            handoff_client_ != nullptr);
+    }
+
     cdr_manager_ = std::make_shared<CdrManager>(
-        config_->get_cdr_file());
+        config_->get_cdr_file(),
+        static_cast<uint64_t>(config_->get_cdr_segment_size_mb()) * 1024 * 1024);
+
+    event_bus_ = std::make_shared<SessionEventBus>();
+
+    std::shared_ptr<SessionJournal> journal;
+    if (!config_->get_session_snapshot_dir().empty()) {
+        journal = std::make_shared<SessionJournal>(config_->get_session_snapshot_dir());
+    }
+
+    std::shared_ptr<ReplicationLog> replication_log;
+    if (!config_->get_replication_standby_ip().empty()) {
+        replication_log = std::make_shared<ReplicationLog>();
+    }
 
     session_manager_ = std::make_unique<SessionManager>(
         cdr_manager_,
         config_->get_session_timeout_sec(),
-        config_->get_blacklist());
+        config_->get_blacklist(),
+        event_bus_,
+        shm_table,
+        journal,
+        replication_log);
+
+    if (handoff_client_) {
+        // Таблица фазы 1 загружается, пока старый процесс ещё принимает трафик
+        auto sessions = handoff_client_->take_sessions();
+        const size_t count = sessions.size();
+        session_manager_->restore_sessions(std::move(sessions));
+
+        // Дальше старый процесс стоит: CDR дописаны, журнал сброшен, UDP не читается.
+        // В паузу входят только изменения фазы 2 и дописанный старым хвост CDR
+        const auto switch_started = std::chrono::steady_clock::now();
+        handoff_client_->switch_over();
+        cdr_manager_->resync();
+        session_manager_->restore_sessions(handoff_client_->take_sessions());
+        session_manager_->drop_closed_sessions(handoff_client_->cleaned_at());
+        if (shm_table) {
+            shm_table->publish();
+        }
+        Logger::get_logger()->info("Received {} sessions ({} changed during the handoff) from the previous process, {:.1f} ms after the switch",
+            count, handoff_client_->changes_received(),
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - switch_started).count());
+    } else if (journal) {
+        // Тёплый старт: сессии из снимка и журнала до приёма трафика
+        try {
+            const auto stats = SessionSnapshotter::restore(
+                config_->get_session_snapshot_dir(), *session_manager_,
+                std::max(1u, std::thread::hardware_concurrency()));
+            Logger::get_logger()->info(
+                "Restored {} sessions ({} from snapshot, {} journal records, {} expired) in {:.3f} s, {:.0f} records/s",
+                stats.restored, stats.snapshot_sessions, stats.journal_records, stats.expired,
+                stats.seconds, stats.records_per_sec());
+        } catch (const std::exception& e) {
+            Logger::get_logger()->error("Session restore failed, starting with an empty table: {}", e.what());
+        }
+    }
+    if (journal) {
+        session_snapshotter_ = std::make_unique<SessionSnapshotter>(
+            *session_manager_, journal, std::chrono::seconds(config_->get_session_snapshot_interval_sec()));
+    }
+
+    // Без снимка (или с пустым) - по последним записям CDR
+    if (!handoff_client_ && config_->get_recover_sessions_from_cdr() && session_manager_->session_count() == 0) {
+        const int timeout = config_->get_session_timeout_sec();
+        const auto files = CdrReplay::recent_files(*cdr_manager_, std::chrono::seconds(timeout));
+        const auto stats = CdrReplay::restore(files, timeout, *session_manager_,
+                                              std::max(1u, std::thread::hardware_concurrency()));
+        Logger::get_logger()->info(
+            "Recovered {} sessions from {} CDR files ({} MB, {} records, {} expired) in {:.3f} s, {:.0f} records/s",
+            stats.restored, stats.files, stats.bytes >> 20, stats.records, stats.expired,
+            stats.seconds, stats.records_per_sec());
+    }
+
+    if (replication_log) {
+        session_replicator_ = std::make_unique<SessionReplicator>(
+            *session_manager_, std::move(replication_log), config_->get_replication_standby_ip(),
+            config_->get_replication_standby_port(), std::chrono::milliseconds(config_->get_replication_batch_ms()));
+    }
+    if (config_->get_replication_port() != 0) {
+        replication_receiver_ = std::make_unique<ReplicationReceiver>(
+            *session_manager_, "0.0.0.0", config_->get_replication_port());
+    }
+
+    const HandoffSockets inherited = handoff_client_ ? handoff_client_->release_sockets() : HandoffSockets{};
+    auto udp_handler = [this](const std::string& msg, const sockaddr_in& addr) {
+        handle_udp_message(msg, addr);
+    };
+    if (inherited.udp_fd >= 0) {
+        udp_server_ = std::make_unique<UdpServer>(inherited.udp_fd, std::move(udp_handler));
+    } else {
+        udp_server_ = std::make_unique<UdpServer>(
+            config_->get_udp_ip(),
+            config_->get_udp_port(),
+            std::move(udp_handler));
+    }
 
-    udp_server_ = std::make_unique<UdpServer>(
-        config_->get_udp_ip(),
-        config_->get_udp_port(),
-        [this](const std::string& msg, const sockaddr_in& addr) {
-            handle_udp_message(msg, addr);
-        });
 
+    RequestTraces::set_slow_threshold(std::chrono::microseconds(config_->get_slow_request_threshold_us()));
 
     http_server_ = std::make_unique<HttpServer>(config_->get_http_port());
     setup_http_server();
+
+    Metrics::register_gauge("pgw_sessions_active", "Sessions currently in the session table",
+        [this]() { return static_cast<double>(session_manager_->session_count()); });
+    Metrics::register_gauge("pgw_cdr_queue_depth", "CDR records waiting to be written",
+        [this]() { return static_cast<double>(cdr_manager_->queue_depth()); });
+    Metrics::register_counter("pgw_log_messages_dropped_total", "Log messages dropped from the full async log queue",
+        []() { return Logger::dropped_messages(); });
+    if (session_replicator_) {
+        Metrics::register_gauge("pgw_replication_sender_connected", "1 while the standby receives session changes",
+            [this]() { return session_replicator_->stats().connected ? 1.0 : 0.0; });
+        Metrics::register_gauge("pgw_replication_lag_ms", "Time from a session change to its acknowledgement by the standby",
+            [this]() { return session_replicator_->stats().lag_ms; });
+        Metrics::register_counter("pgw_replication_sent_bytes_total", "Compressed replication bytes sent to the standby",
+            [this]() { return session_replicator_->stats().compressed_bytes; });
+    }
+    if (replication_receiver_) {
+        Metrics::register_gauge("pgw_replication_receiver_connected", "1 while the primary streams session changes",
+            [this]() { return replication_receiver_->stats().connected ? 1.0 : 0.0; });
+        Metrics::register_counter("pgw_replication_applied_total", "Session changes applied from the primary",
+            [this]() { return replication_receiver_->stats().records; });
+    }
+
+    if (config_->get_cdr_export_port() != 0) {
+        if (inherited.cdr_export_fd >= 0) {
+            cdr_export_server_ = std::make_unique<CdrExportServer>(inherited.cdr_export_fd, cdr_manager_);
+        } else {
+            cdr_export_server_ = std::make_unique<CdrExportServer>(
+                config_->get_cdr_export_port(), "0.0.0.0", cdr_manager_);
+        }
+    } else if (inherited.cdr_export_fd >= 0) {
+        ::close(inherited.cdr_export_fd);
+    }
 }
 
 void PgwServer::run() {
     // Регистрация обработчиков сигналов для остановки сревера 
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
+    std::signal(SIGHUP, signal_handler);
 
     udp_server_->start();
     http_server_->start();
+    if (cdr_export_server_) {
+        cdr_export_server_->start();
+    }
+
+    if (handoff_client_) {
+        // Трафик уже принимается: старый процесс может завершаться. Без подтверждения
+        // он продолжил работу, и два процесса читать один сокет не должны
+        if (!handoff_client_->ready()) {
+            throw std::runtime_error("Previous process did not accept the handoff confirmation");
+        }
+        handoff_client_.reset();
+        Logger::get_logger()->info("Handoff complete: serving traffic");
+    }
+    if (!config_->get_handoff_socket().empty()) {
+        handoff_listener_ = std::make_unique<HandoffListener>(config_->get_handoff_socket());
+    }
+    // Первый снимок пишется сразу при старте: после приёма трафика, чтобы не занимать CPU раньше
+    if (session_snapshotter_) {
+        session_snapshotter_->start();
+    }
+    if (session_replicator_) {
+        session_replicator_->start();
+    }
+    if (replication_receiver_) {
+        replication_receiver_->start();
+    }
     
     // Поток для очистки устаревших сессий
     std::thread cleanup_thread([this]() {
         while (!shutdown_flag) {
-            session_manager_->cleanup_expired_sessions();
-            std::this_thread::sleep_for(std::chrono::seconds(5));
+            {
+                std::lock_guard lock(maintenance_mutex_);
+                if (shutdown_flag) break;
+                session_manager_->cleanup_expired_sessions();
+            }
+            // Короткими шагами: остановка не ждёт конца интервала очистки
+            for (int i = 0; i < 50 && !shutdown_flag; ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
         }
     });
     
     Logger::get_logger()->info("PGW Server started successfully");
 
+    bool handed_off = false;
     while (!shutdown_flag) {
+        if (reload_flag.exchange(false)) {
+            try {
+                reload_config();
+            } catch (const std::exception& e) {
+                Logger::get_logger()->error("Config reload on SIGHUP failed: {}", e.what());
+            }
+        }
+        if (handoff_listener_ && handoff_listener_->accept_request()) {
+            handed_off = hand_off();
+        }
         std::this_thread::yield();
     }
 
     Logger::get_logger()->info("Shutting down server...");
     cleanup_thread.join();
+    if (replication_receiver_) {
+        replication_receiver_->stop();
+    }
 
-    session_manager_->graceful_shutdown(config_->get_graceful_shutdown_rate());
+    // Сессии живут дальше в новом процессе: без graceful_removal
+    if (!handed_off) {
+        session_manager_->graceful_shutdown(config_->get_graceful_shutdown_rate());
+    }
+    // Удаления graceful_shutdown уходят резервному узлу последней пачкой
+    if (session_replicator_) {
+        session_replicator_->stop();
+    }
+    if (session_snapshotter_) {
+        session_snapshotter_->stop();
+    }
+    event_bus_->close();
+    if (cdr_export_server_) {
+        cdr_export_server_->stop();
+    }
     http_server_->stop();
     udp_server_->stop();
+    Logger::shutdown();
+}
+
+bool PgwServer::hand_off() {
+    Logger::get_logger()->info("Handoff requested on {}: sending the session table", handoff_listener_->path());
+    // Новый процесс уже открыл свой журнал: снимок с ротацией журнала здесь занял бы его номер
+    if (session_snapshotter_) {
+        session_snapshotter_->stop();
+    }
+    // Фаза 1 - без остановки трафика; новый процесс тем временем строит менеджеры и загружает таблицу
+    if (!handoff_listener_->send_sessions(*session_manager_) || !handoff_listener_->wait_switch(kHandoffTimeout)) {
+        Logger::get_logger()->error("Handoff aborted by the new process");
+        handoff_listener_->reset();
+        if (session_snapshotter_) {
+            session_snapshotter_->start();
+        }
+        return false;
+    }
+
+    const auto paused = std::chrono::steady_clock::now();
+    std::lock_guard lock(maintenance_mutex_);
+
+    // Таблица заморожена: UDP и очистка стоят, CDR дописаны. Новые датаграммы
+    // копятся в очереди сокета, который уходит новому процессу. Выгрузка CDR таблицу
+    // не трогает и останавливается уже при завершении
+    udp_server_->stop();
+    const auto cleaned_at = std::chrono::steady_clock::now();
+    session_manager_->cleanup_expired_sessions(cleaned_at);
+    cdr_manager_->flush();
+    if (session_snapshotter_) {
+        session_snapshotter_->stop();   // уже остановлен: только сброс журнала
+    }
+    // Последние изменения - резервному узлу; дальше его синхронизирует новый процесс
+    if (session_replicator_) {
+        session_replicator_->stop();
+    }
+
+    const HandoffSockets sockets{udp_server_->socket_fd(),
+                                 cdr_export_server_ ? cdr_export_server_->socket_fd() : -1};
+    if (handoff_listener_->send_state(sockets, *session_manager_, cleaned_at) &&
+        handoff_listener_->wait_ready(kHandoffTimeout)) {
+        Logger::get_logger()->info("Handed off {} sessions ({} changed during the handoff) to the new process; UDP paused for {:.1f} ms",
+            handoff_listener_->sessions_sent(), handoff_listener_->changes_sent(),
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - paused).count());
+        // Под maintenance_mutex_: очистка больше не запустится
+        shutdown_flag.store(true);
+        return true;
+    }
+
+    Logger::get_logger()->error("Handoff failed, resuming traffic");
+    handoff_listener_->reset();
+    if (session_snapshotter_) {
+        session_snapshotter_->start();
+    }
+    if (session_replicator_) {
+        session_replicator_->start();
+    }
+    udp_server_->start();
+    return false;
+}
+
+std::string PgwServer::reload_config() {
+    std::lock_guard lock(reload_mutex_);
+
+    // Разбор и проверка целиком до применения: при ошибке ничего не меняется
+    ServerConfig fresh(config_file_);
+    Logger::set_level(fresh.get_log_level());
+    session_manager_->update_policy(fresh.get_session_timeout_sec(), fresh.get_blacklist());
+
+    if (fresh.get_udp_ip() != config_->get_udp_ip() || fresh.get_udp_port() != config_->get_udp_port() ||
+        fresh.get_http_port() != config_->get_http_port() || fresh.get_cdr_file() != config_->get_cdr_file() ||
+        fresh.get_cdr_segment_size_mb() != config_->get_cdr_segment_size_mb() ||
+        fresh.get_cdr_export_port() != config_->get_cdr_export_port() ||
+        fresh.get_log_file() != config_->get_log_file() ||
+        fresh.get_shm_session_table() != config_->get_shm_session_table() ||
+        fresh.get_shm_session_capacity() != config_->get_shm_session_capacity() ||
+        fresh.get_session_snapshot_dir() != config_->get_session_snapshot_dir() ||
+        fresh.get_session_snapshot_interval_sec() != config_->get_session_snapshot_interval_sec() ||
+        fresh.get_recover_sessions_from_cdr() != config_->get_recover_sessions_from_cdr() ||
+        fresh.get_handoff_socket() != config_->get_handoff_socket() ||
+        fresh.get_replication_standby_ip() != config_->get_replication_standby_ip() ||
+        fresh.get_replication_standby_port() != config_->get_replication_standby_port() ||
+        fresh.get_replication_port() != config_->get_replication_port() ||
+        fresh.get_replication_batch_ms() != config_->get_replication_batch_ms()) {
+        Logger::get_logger()->warn("Config reload: listener, CDR, log file, shared-memory, snapshot, handoff and replication settings require a restart and were ignored");
+    }
+
+    std::string summary = "Reloaded: session_timeout_sec=" + std::to_string(fresh.get_session_timeout_sec()) +
+        ", blacklist=" + std::to_string(fresh.get_blacklist().size()) +
+        ", log_level=" + fresh.get_log_level();
+    Logger::get_logger()->info("{}", summary);
+    return summary;
 }
 
 void PgwServer::setup_http_server() {
@@ -93,12 +464,265 @@ void PgwServer::setup_http_server() {
                 return;
             }
             
-            std::string imsi = req.get_param_value("imsi");
-            bool active = session_manager_->session_exists(imsi);
+            const auto imsi = Imsi::parse(req.get_param_value("imsi"));
+            if (!imsi) {
+                res.status = 400;
+                res.set_content("Invalid IMSI", "text/plain");
+                return;
+            }
+            bool active = session_manager_->session_exists(*imsi);
             res.set_content(active ? "active" : "not active", "text/plain");
         });
     
 
+    http_server_->add_post_handler("/check_subscribers",
+        [this](const httplib::Request& req, httplib::Response& res) {
+            const bool json = req.get_header_value("Content-Type").starts_with("application/json");
+
+            auto result = std::make_shared<BulkCheckResult>();
+            result->json = json;
+            try {
+                result->imsis = parse_imsi_list(req.body, json);
+            } catch (const std::exception& e) {
+                res.status = 400;
+                res.set_content(std::string("Invalid IMSI list: ") + e.what(), "text/plain");
+                return;
+            }
+            if (result->imsis.size() > kMaxBulkImsis) {
+                res.status = 413;
+                res.set_content("Too many IMSIs (max " + std::to_string(kMaxBulkImsis) + ")", "text/plain");
+                return;
+            }
+
+            // Весь список проверяется и упаковывается пакетными ядрами
+            const auto imsis = BCDBatch::parse(result->imsis);
+            result->valid.resize(imsis.size());
+            result->parsed.reserve(imsis.size());
+            for (size_t i = 0; i < imsis.size(); ++i) {
+                if (!imsis[i].empty()) {
+                    result->parsed.push_back(imsis[i]);
+                    result->valid[i] = true;
+                }
+            }
+
+            // Весь пакет - за один проход под одной разделяемой блокировкой
+            result->active = session_manager_->sessions_exist(result->parsed);
+
+            res.set_chunked_content_provider(json ? "application/json" : "text/plain",
+                [result](size_t, httplib::DataSink& sink) {
+                    std::string chunk;
+                    if (result->next == 0 && result->json) chunk += '{';
+
+                    const size_t total = result->imsis.size();
+                    while (result->next < total && chunk.size() < kBulkChunkSize) {
+                        const size_t i = result->next++;
+                        const char* status = !result->valid[i] ? "invalid"
+                            : result->active[result->next_active++] ? "active" : "not active";
+                        if (result->json) {
+                            if (i != 0) chunk += ',';
+                            chunk += nlohmann::json(result->imsis[i]).dump();
+                            chunk += ":\"";
+                            chunk += status;
+                            chunk += '"';
+                        } else {
+                            chunk += result->imsis[i];
+                            chunk += ' ';
+                            chunk += status;
+                            chunk += '\n';
+                        }
+                    }
+
+                    if (result->next == total && result->json) chunk += '}';
+                    if (!chunk.empty() && !sink.write(chunk.data(), chunk.size())) {
+                        return false;
+                    }
+                    if (result->next == total) sink.done();
+                    return true;
+                });
+        });
+
+    // С cursor - одна страница в JSON; без него - весь дамп потоком NDJSON,
+    // по странице на чанк, блокировка таблицы берётся на время одной страницы
+    http_server_->add_get_handler("/sessions",
+        [this](const httplib::Request& req, httplib::Response& res) {
+            size_t limit = kSessionPageDefault;
+            SessionCursor cursor;
+            try {
+                if (req.has_param("limit")) {
+                    limit = std::clamp<size_t>(std::stoul(req.get_param_value("limit")), 1, kSessionPageMax);
+                }
+                if (req.has_param("cursor")) {
+                    cursor = SessionCursor::parse(req.get_param_value("cursor"));
+                }
+            } catch (const std::exception&) {
+                res.status = 400;
+                res.set_content("Invalid cursor or limit", "text/plain");
+                return;
+            }
+
+            if (req.has_param("cursor")) {
+                const SessionPage page = session_manager_->list_sessions(cursor, limit);
+                const auto now = std::chrono::steady_clock::now();
+
+                nlohmann::json sessions = nlohmann::json::array();
+                for (const auto& session : page.sessions) {
+                    sessions.push_back({{"imsi", session.imsi.to_string()}, {"expires_in_ms", expires_in_ms(session, now)}});
+                }
+                nlohmann::json body = {
+                    {"sessions", std::move(sessions)},
+                    {"next_cursor", page.done ? nlohmann::json(nullptr) : nlohmann::json(page.next.to_string())},
+                    {"restarted", page.restarted}
+                };
+                res.set_content(body.dump(), "application/json");
+                return;
+            }
+
+            auto next = std::make_shared<SessionCursor>();
+            res.set_chunked_content_provider("application/x-ndjson",
+                [this, next, limit](size_t, httplib::DataSink& sink) {
+                    const SessionPage page = session_manager_->list_sessions(*next, limit);
+                    const auto now = std::chrono::steady_clock::now();
+
+                    std::string chunk;
+                    chunk.reserve(page.sessions.size() * 56 + 32);
+                    // Обход начат заново: дальше пойдут уже отданные сессии
+                    if (page.restarted) {
+                        chunk += "{\"restarted\":true}\n";
+                    }
+                    for (const auto& session : page.sessions) {
+                        chunk += "{\"imsi\":\"";
+                        chunk += session.imsi.digits().view();
+                        chunk += "\",\"expires_in_ms\":";
+                        chunk += std::to_string(expires_in_ms(session, now));
+                        chunk += "}\n";
+                    }
+                    if (!chunk.empty() && !sink.write(chunk.data(), chunk.size())) {
+                        return false;
+                    }
+
+                    *next = page.next;
+                    if (page.done) sink.done();
+                    return true;
+                });
+        });
+
+    // SSE-поток событий сессий: раз в kEventBatchInterval одна пачка событий
+    http_server_->add_get_handler("/events",
+        [this](const httplib::Request&, httplib::Response& res) {
+            auto subscription = event_bus_->subscribe();
+            if (!subscription) {
+                res.status = 503;
+                res.set_content("Too many event subscribers", "text/plain");
+                return;
+            }
+
+            res.set_header("Cache-Control", "no-cache");
+            res.set_chunked_content_provider("text/event-stream",
+                [subscription, batch = std::vector<SessionEvent>(), idle = 0](size_t, httplib::DataSink& sink) mutable {
+                    batch.clear();
+                    const uint64_t dropped = subscription->drain(batch, kEventBatchInterval);
+
+                    std::string chunk;
+                    if (dropped != 0) {
+                        chunk += "event: dropped\ndata: {\"count\":" + std::to_string(dropped) + "}\n\n";
+                    }
+                    if (!batch.empty()) {
+                        chunk += "event: sessions\ndata: [";
+                        for (size_t i = 0; i < batch.size(); ++i) {
+                            if (i != 0) chunk += ',';
+                            chunk += "{\"type\":\"";
+                            chunk += SessionEventBus::type_name(batch[i].type);
+                            chunk += "\",\"imsi\":\"";
+                            chunk += batch[i].imsi.digits().view();
+                            chunk += "\",\"ts\":";
+                            chunk += std::to_string(batch[i].timestamp_ms);
+                            chunk += '}';
+                        }
+                        chunk += "]\n\n";
+                    }
+                    if (chunk.empty() && ++idle >= kEventKeepaliveBatches) {
+                        chunk = ": keepalive\n\n";
+                    }
+                    if (!chunk.empty()) {
+                        idle = 0;
+                        if (!sink.write(chunk.data(), chunk.size())) return false;
+                    }
+
+                    if (subscription->closed()) sink.done();
+                    return true;
+                },
+                [this, subscription](bool) {
+                    event_bus_->unsubscribe(subscription);
+                });
+        });
+
+    http_server_->add_get_handler("/cdr_history",
+        [this](const httplib::Request& req, httplib::Response& res) {
+            if (config_->get_cdr_segment_size_mb() == 0) {
+                res.status = 404;
+                res.set_content("CDR history is disabled (cdr_segment_size_mb = 0)", "text/plain");
+                return;
+            }
+            if (!req.has_param("imsi")) {
+                res.status = 400;
+                res.set_content("IMSI parameter missing", "text/plain");
+                return;
+            }
+
+            const auto imsi = Imsi::parse(req.get_param_value("imsi"));
+            if (!imsi) {
+                res.status = 400;
+                res.set_content("Invalid IMSI", "text/plain");
+                return;
+            }
+
+            size_t limit = 1000;
+            if (req.has_param("limit")) {
+                try {
+                    limit = std::stoul(req.get_param_value("limit"));
+                } catch (const std::exception&) {
+                    res.status = 400;
+                    res.set_content("Invalid limit", "text/plain");
+                    return;
+                }
+            }
+
+            std::string body;
+            for (const auto& record : cdr_manager_->find_records(*imsi, limit)) {
+                body += record;
+                body += '\n';
+            }
+            res.set_content(body, "text/csv");
+        });
+
+    http_server_->add_get_handler("/cdr_segments",
+        [this](const httplib::Request&, httplib::Response& res) {
+            nlohmann::json segments = nlohmann::json::array();
+            for (const auto& segment : cdr_manager_->list_segments()) {
+                segments.push_back({
+                    {"name", segment.name},
+                    {"size", segment.size},
+                    {"export_path", "/cdr_export/" + segment.name}
+                });
+            }
+            nlohmann::json body = {
+                {"export_port", config_->get_cdr_export_port()},
+                {"segments", segments}
+            };
+            res.set_content(body.dump(), "application/json");
+        });
+
+    http_server_->add_post_handler("/reload",
+        [this](const httplib::Request&, httplib::Response& res) {
+            try {
+                res.set_content(reload_config(), "text/plain");
+            } catch (const std::exception& e) {
+                Logger::get_logger()->error("Config reload failed: {}", e.what());
+                res.status = 400;
+                res.set_content(std::string("Reload failed: ") + e.what(), "text/plain");
+            }
+        });
+
     http_server_->add_get_handler("/stop", 
         [this](const httplib::Request&, httplib::Response& res) {
             res.set_content("Shutting down server...", "text/plain");
@@ -107,29 +731,89 @@ void PgwServer::setup_http_server() {
 }
 
 void PgwServer::handle_udp_message(const std::string& message, const sockaddr_in& client_addr) {
+    const uint64_t start = CycleClock::now();
+    std::optional<uint32_t> tag;
+    RequestTrace trace;
+    trace.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    trace.source_ip = client_addr.sin_addr.s_addr;
+    trace.source_port = client_addr.sin_port;
+    trace.set_stage(Stage::Receive, udp_server_->current_receive_delay_ns());
     try {
+        uint32_t request_tag = 0;
+        std::string_view body = message;
+        if (RequestTag::parse(message, request_tag, body)) {
+            tag = request_tag;
+        }
 
-        std::string imsi = BCDConverter::bcd_to_imsi(
-            std::vector<uint8_t>(message.begin(), message.end()));
-            
-            if (!BCDConverter::validate_imsi(imsi)) {
-                Logger::get_logger()->warn("Invalid IMSI received");
-                send_udp_response("rejected", client_addr);
-                return;
+        const auto imsi = Imsi::from_bcd(std::span(
+            reinterpret_cast<const uint8_t*>(body.data()), body.size()));
+        if (!imsi) {
+            Metrics::increment(Counter::UdpDecodeFailures);
+            const uint64_t decoded = CycleClock::now();
+            if (imsi.error() == ImsiError::BadBcd) {
+                PGW_LOG_ERROR_RATE(kPacketLogPerSecond, "Message processing error: {}", imsi_error_message(imsi.error()));
+                send_udp_response("error", client_addr, tag);
+            } else {
+                PGW_LOG_WARN_RATE(kPacketLogPerSecond, "Invalid IMSI received: {}", imsi_error_message(imsi.error()));
+                send_udp_response("rejected", client_addr, tag);
             }
+            // Отклонённый запрос - в трассах с пустым IMSI: медленное декодирование тоже видно
+            const uint64_t sent = CycleClock::now();
+            trace.set_stage(Stage::Decode, CycleClock::to_nanos(decoded - start));
+            trace.set_stage(Stage::Send, CycleClock::to_nanos(sent - decoded));
+            trace.set_stage(Stage::Total, CycleClock::to_nanos(sent - start));
+            RequestTraces::record(trace);
+            return;
+        }
+
+        const uint64_t decoded = CycleClock::now();
+        const uint64_t cdr_before = CdrManager::thread_enqueue_nanos();
             
-        bool created = session_manager_->create_session(imsi);
-        std::string response = created ? "created" : "rejected";
+        bool created = session_manager_->create_session(*imsi);
+        const std::string_view response = created ? "created" : "rejected";
+
+        const uint64_t session_done = CycleClock::now();
+        const uint64_t cdr_ns = CdrManager::thread_enqueue_nanos() - cdr_before;
+
+        send_udp_response(response, client_addr, tag);
 
-        send_udp_response(response, client_addr);
+        const uint64_t sent = CycleClock::now();
+        // Запись лога не входит в стадию Send
+        PGW_LOG_DEBUG_SAMPLED(kPacketLogSampleRate, "IMSI {}: {}", imsi->digits().view(), response);
+        const uint64_t decode_ns = CycleClock::to_nanos(decoded - start);
+        const uint64_t session_ns = CycleClock::to_nanos(session_done - decoded);
+        const uint64_t send_ns = CycleClock::to_nanos(sent - session_done);
+        const uint64_t total_ns = CycleClock::to_nanos(sent - start);
+        Latency::record(Stage::Decode, decode_ns);
+        Latency::record(Stage::SessionCreate, session_ns);
+        Latency::record(Stage::Send, send_ns);
+        Latency::record(Stage::Total, total_ns);
+
+        trace.imsi = *imsi;
+        trace.set_stage(Stage::Decode, decode_ns);
+        trace.set_stage(Stage::SessionCreate, session_ns);
+        trace.set_stage(Stage::CdrEnqueue, cdr_ns);
+        trace.set_stage(Stage::Send, send_ns);
+        trace.set_stage(Stage::Total, total_ns);
+        RequestTraces::record(trace);
         
     } catch (const std::exception& e) {
-        Logger::get_logger()->error("Message processing error: {}", e.what());
-        send_udp_response("error", client_addr);
+        Metrics::increment(Counter::UdpDecodeFailures);
+        PGW_LOG_ERROR_RATE(kPacketLogPerSecond, "Message processing error: {}", e.what());
+        send_udp_response("error", client_addr, tag);
     }
 }
 
-void PgwServer::send_udp_response(const std::string& response, const sockaddr_in& addr) {
-    udp_server_->send(response, addr);
+void PgwServer::send_udp_response(std::string_view response, const sockaddr_in& addr, std::optional<uint32_t> tag) {
+    if (!tag) {
+        udp_server_->send(response, addr);
+        return;
+    }
+    char buffer[RequestTag::kHeaderSize + 32];
+    const size_t size = std::min(response.size(), sizeof(buffer) - RequestTag::kHeaderSize);
+    RequestTag::write_header(*tag, buffer);
+    std::memcpy(buffer + RequestTag::kHeaderSize, response.data(), size);
+    udp_server_->send(std::string_view(buffer, RequestTag::kHeaderSize + size), addr);
 }
 
@@ -0,0 +1,257 @@
+#include "session/cdr_replay.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include "cdr/cdr_index.h"
+#include "cdr/cdr_manager.h"
+#include "session/session_manager.h"
+#include "session/session_snapshot.h"
+#include "utils/logger.h"
+
+namespace {
+
+constexpr unsigned kOffsetBits = 40;    // позиция записи: (номер файла << 40) | смещение
+
+struct LastRecord {
+    uint64_t position;
+    int64_t time_sec;
+    bool live;
+};
+
+using Bucket = std::unordered_map<uint64_t, LastRecord>;
+
+struct MappedFile {
+    const char* data = nullptr;
+    size_t size = 0;
+};
+
+struct Chunk {
+    uint32_t file;
+    size_t begin;
+    size_t end;
+};
+
+// Время CDR "YYYY-MM-DD HH:MM:SS" в локальной зоне (так его пишет CdrManager).
+// mktime медленный, поэтому начало минуты запоминается: записи идут по времени
+class TimestampParser {
+public:
+    bool parse(std::string_view text, int64_t& time_sec) {
+        if (text.size() != 19 || text[4] != '-' || text[7] != '-' || text[10] != ' ' ||
+            text[13] != ':' || text[16] != ':') {
+            return false;
+        }
+        int seconds = 0;
+        if (!digits(text.substr(17, 2), seconds)) return false;
+
+        const std::string_view minute = text.substr(0, 16);
+        if (minute != std::string_view(cached_minute_, sizeof(cached_minute_))) {
+            int year, month, day, hour, min;
+            if (!digits(text.substr(0, 4), year) || !digits(text.substr(5, 2), month) ||
+                !digits(text.substr(8, 2), day) || !digits(text.substr(11, 2), hour) ||
+                !digits(text.substr(14, 2), min)) {
+                return false;
+            }
+            std::tm tm{};
+            tm.tm_year = year - 1900;
+            tm.tm_mon = month - 1;
+            tm.tm_mday = day;
+            tm.tm_hour = hour;
+            tm.tm_min = min;
+            tm.tm_isdst = -1;
+            const std::time_t start = std::mktime(&tm);
+            if (start == -1) return false;
+            std::memcpy(cached_minute_, minute.data(), minute.size());
+            cached_start_ = start;
+        }
+        time_sec = cached_start_ + seconds;
+        return true;
+    }
+
+private:
+    char cached_minute_[16] = {};
+    int64_t cached_start_ = 0;
+
+    static bool digits(std::string_view text, int& value) {
+        value = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') return false;
+            value = value * 10 + (c - '0');
+        }
+        return true;
+    }
+};
+
+// Разбор куска: последняя запись каждого IMSI, разложенная по корзинам хеша
+uint64_t replay_chunk(const MappedFile& file, const Chunk& chunk, std::vector<Bucket>& buckets) {
+    size_t pos = chunk.begin;
+    // Кусок начинается с первой целой строки; строку на границе разбирает предыдущий кусок
+    if (pos > 0 && file.data[pos - 1] != '\n') {
+        const void* newline = std::memchr(file.data + pos, '\n', file.size - pos);
+        if (!newline) return 0;
+        pos = static_cast<size_t>(static_cast<const char*>(newline) - file.data) + 1;
+    }
+
+    TimestampParser timestamps;
+    uint64_t records = 0;
+    while (pos < chunk.end) {
+        const void* newline = std::memchr(file.data + pos, '\n', file.size - pos);
+        const size_t line_end = newline ? static_cast<size_t>(static_cast<const char*>(newline) - file.data) : file.size;
+        const std::string_view line(file.data + pos, line_end - pos);
+        const uint64_t position = (static_cast<uint64_t>(chunk.file) << kOffsetBits) | pos;
+        pos = line_end + 1;
+        if (!newline) break;    // недописанная последняя строка
+
+        const auto first = line.find(',');
+        const auto second = first == std::string_view::npos ? first : line.find(',', first + 1);
+        if (second == std::string_view::npos) continue;
+        ++records;
+
+        const std::string_view action = line.substr(second + 1);
+        bool live;
+        if (action == "created" || action == "prolonged") {
+            live = true;
+        } else if (action == "expired" || action == "graceful_removal") {
+            live = false;
+        } else {
+            continue;
+        }
+        int64_t time_sec;
+        const uint64_t key = CdrSegmentIndex::make_key(line.substr(first + 1, second - first - 1));
+        if (key == 0 || !timestamps.parse(line.substr(0, first), time_sec)) continue;
+
+        // Младшие биты ключа - длина IMSI, поэтому ключ перемешивается перед выбором корзины
+        auto& bucket = buckets[((key * 0x9E3779B97F4A7C15ULL) >> 32) % buckets.size()];
+        auto [it, inserted] = bucket.try_emplace(key, LastRecord{position, time_sec, live});
+        if (!inserted && it->second.position < position) {
+            it->second = LastRecord{position, time_sec, live};
+        }
+    }
+    return records;
+}
+
+} // namespace
+
+std::vector<std::string> CdrReplay::recent_files(const CdrManager& cdr_manager, std::chrono::seconds window) {
+    namespace fs = std::filesystem;
+    const auto cutoff = fs::file_time_type::clock::now() - window;
+
+    std::vector<std::string> files;
+    for (const auto& segment : cdr_manager.list_segments()) {
+        std::error_code ec;
+        const auto modified = fs::last_write_time(segment.path, ec);
+        // Сегмент закрыт раньше окна - все его записи старше session_timeout_sec
+        if (!ec && modified >= cutoff) {
+            files.push_back(segment.path);
+        }
+    }
+    files.push_back(cdr_manager.active_file());
+    return files;
+}
+
+CdrReplayStats CdrReplay::restore(const std::vector<std::string>& files, int session_timeout_sec,
+                                  SessionManager& session_manager, unsigned threads, size_t chunk_bytes) {
+    const auto started = std::chrono::steady_clock::now();
+    CdrReplayStats stats;
+    threads = std::max(threads, 1u);
+    chunk_bytes = std::max<size_t>(chunk_bytes, 1);
+
+    std::vector<MappedFile> mapped(files.size());
+    std::vector<Chunk> chunks;
+    for (size_t i = 0; i < files.size(); ++i) {
+        const int fd = ::open(files[i].c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        struct stat info{};
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* data = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+                ::madvise(data, static_cast<size_t>(info.st_size), MADV_SEQUENTIAL);
+                mapped[i] = {static_cast<const char*>(data), static_cast<size_t>(info.st_size)};
+                for (size_t begin = 0; begin < mapped[i].size; begin += chunk_bytes) {
+                    chunks.push_back({static_cast<uint32_t>(i), begin, std::min(mapped[i].size, begin + chunk_bytes)});
+                }
+                stats.bytes += mapped[i].size;
+                ++stats.files;
+            }
+        }
+        ::close(fd);
+    }
+
+    // Фаза 1: куски файлов по потокам, у каждого потока свои корзины
+    std::vector<std::vector<Bucket>> worker_buckets(threads, std::vector<Bucket>(threads));
+    std::atomic<size_t> next_chunk{0};
+    std::atomic<uint64_t> records{0};
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                uint64_t parsed = 0;
+                for (size_t c = next_chunk++; c < chunks.size(); c = next_chunk++) {
+                    parsed += replay_chunk(mapped[chunks[c].file], chunks[c], worker_buckets[t]);
+                }
+                records += parsed;
+            });
+        }
+    }
+    for (const auto& file : mapped) {
+        if (file.data) {
+            ::munmap(const_cast<char*>(file.data), file.size);
+        }
+    }
+
+    // Фаза 2: корзина b всех потоков сводится в потоке b; живые сессии - по сроку
+    const int64_t now_sec = std::time(nullptr);
+    const auto steady_now = std::chrono::steady_clock::now();
+    std::vector<std::vector<SessionInfo>> parts(threads);
+    std::atomic<uint64_t> expired{0};
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned b = 0; b < threads; ++b) {
+            workers.emplace_back([&, b] {
+                Bucket merged = std::move(worker_buckets[0][b]);
+                for (unsigned t = 1; t < threads; ++t) {
+                    for (const auto& [key, record] : worker_buckets[t][b]) {
+                        auto [it, inserted] = merged.try_emplace(key, record);
+                        if (!inserted && it->second.position < record.position) {
+                            it->second = record;
+                        }
+                    }
+                    Bucket().swap(worker_buckets[t][b]);
+                }
+
+                uint64_t stale = 0;
+                auto& part = parts[b];
+                for (const auto& [key, record] : merged) {
+                    if (!record.live) continue;
+                    const int64_t expires_sec = record.time_sec + session_timeout_sec;
+                    if (expires_sec <= now_sec) {
+                        ++stale;
+                        continue;
+                    }
+                    const auto imsi = Imsi::from_key(key);
+                    if (!imsi || session_manager.is_blacklisted(*imsi)) continue;
+                    part.push_back({*imsi, steady_now + std::chrono::seconds(expires_sec - now_sec)});
+                }
+                std::sort(part.begin(), part.end(),
+                          [](const SessionInfo& a, const SessionInfo& c) { return a.expires_at < c.expires_at; });
+                expired += stale;
+            });
+        }
+    }
+
+    std::vector<SessionInfo> sessions = merge_by_expiry(std::move(parts));
+    stats.records = records;
+    stats.expired = expired;
+    stats.restored = sessions.size();
+    session_manager.restore_sessions(std::move(sessions));
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return stats;
+}
@@ -0,0 +1,133 @@
+#include "session/session_events.h"
+#include "metrics/metrics.h"
+#include <algorithm>
+
+SessionSubscription::SessionSubscription(size_t capacity)
+    : ring_(std::make_unique<Slot[]>(std::max<size_t>(capacity, 1))),
+      capacity_(std::max<size_t>(capacity, 1)) {}
+
+void SessionSubscription::push(const SessionEvent& event) noexcept {
+    const uint64_t index = head_.load(std::memory_order_relaxed);
+    Slot& slot = ring_[index % capacity_];
+
+    slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.key.store(event.imsi.key(), std::memory_order_relaxed);
+    slot.timestamp_ms.store(event.timestamp_ms, std::memory_order_relaxed);
+    slot.type.store(static_cast<uint8_t>(event.type), std::memory_order_relaxed);
+    slot.seq.store(2 * index + 2, std::memory_order_release);
+
+    head_.store(index + 1, std::memory_order_release);
+}
+
+uint64_t SessionSubscription::drain(std::vector<SessionEvent>& out, std::chrono::milliseconds timeout) {
+    {
+        // Производитель не будит потребителя: события копятся до конца интервала
+        // и уходят одной пачкой
+        std::unique_lock lock(close_mutex_);
+        cv_.wait_for(lock, timeout, [this] { return closed(); });
+    }
+
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t dropped = 0;
+    if (head - tail_ > capacity_) {
+        dropped = head - capacity_ - tail_;
+        tail_ = head - capacity_;
+    }
+
+    out.reserve(out.size() + static_cast<size_t>(head - tail_));
+    for (uint64_t index = tail_; index < head; ++index) {
+        const Slot& slot = ring_[index % capacity_];
+        const uint64_t before = slot.seq.load(std::memory_order_acquire);
+        SessionEvent event{};
+        event.type = static_cast<SessionEventType>(slot.type.load(std::memory_order_relaxed));
+        event.imsi = Imsi::from_key(slot.key.load(std::memory_order_relaxed)).value_or(Imsi{});
+        event.timestamp_ms = slot.timestamp_ms.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // Ячейку успели затереть более новым событием, пока мы её читали
+        if (before != 2 * index + 2 || slot.seq.load(std::memory_order_relaxed) != before) {
+            ++dropped;
+            continue;
+        }
+        out.push_back(event);
+    }
+    tail_ = head;
+
+    if (dropped > 0) {
+        Metrics::increment(Counter::SessionEventsDropped, dropped);
+    }
+    return dropped;
+}
+
+void SessionSubscription::close() {
+    {
+        std::lock_guard lock(close_mutex_);
+        closed_.store(true, std::memory_order_relaxed);
+    }
+    cv_.notify_all();
+}
+
+SessionEventBus::SessionEventBus(size_t max_subscribers)
+    : max_subscribers_(max_subscribers) {}
+
+SessionEventBus::~SessionEventBus() {
+    close();
+}
+
+void SessionEventBus::publish(SessionEventType type, Imsi imsi) noexcept {
+    if (active_.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+
+    SessionEvent event{};
+    event.type = type;
+    event.imsi = imsi;
+    event.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    std::lock_guard lock(mutex_);
+    for (const auto& subscriber : subscribers_) {
+        subscriber->push(event);
+    }
+}
+
+std::shared_ptr<SessionSubscription> SessionEventBus::subscribe(size_t capacity) {
+    std::lock_guard lock(mutex_);
+    if (subscribers_.size() >= max_subscribers_) {
+        return nullptr;
+    }
+    auto subscription = std::make_shared<SessionSubscription>(capacity);
+    subscribers_.push_back(subscription);
+    active_.store(subscribers_.size(), std::memory_order_relaxed);
+    return subscription;
+}
+
+void SessionEventBus::unsubscribe(const std::shared_ptr<SessionSubscription>& subscription) {
+    std::lock_guard lock(mutex_);
+    std::erase(subscribers_, subscription);
+    active_.store(subscribers_.size(), std::memory_order_relaxed);
+}
+
+void SessionEventBus::close() {
+    std::lock_guard lock(mutex_);
+    for (const auto& subscriber : subscribers_) {
+        subscriber->close();
+    }
+    subscribers_.clear();
+    active_.store(0, std::memory_order_relaxed);
+}
+
+size_t SessionEventBus::subscriber_count() const {
+    std::lock_guard lock(mutex_);
+    return subscribers_.size();
+}
+
+const char* SessionEventBus::type_name(SessionEventType type) noexcept {
+    switch (type) {
+        case SessionEventType::Created: return "created";
+        case SessionEventType::Prolonged: return "prolonged";
+        case SessionEventType::Expired: return "expired";
+        case SessionEventType::Removed: return "removed";
+    }
+    return "unknown";
+}
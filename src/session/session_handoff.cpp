@@ -0,0 +1,401 @@
+#include "session/session_handoff.h"
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include "session/session_manager.h"
+#include "utils/logger.h"
+
+namespace {
+
+constexpr char kHandoffMagic[8] = {'P', 'G', 'W', 'H', 'O', 'F', 'F', '1'};
+constexpr uint32_t kHandoffVersion = 1;
+constexpr uint32_t kUdpSocketBit = 1;
+constexpr uint32_t kCdrExportSocketBit = 2;
+constexpr char kSwitch = 'S';
+constexpr char kReady = 'R';
+constexpr size_t kRecordsPerChunk = 4096;
+
+static_assert(std::endian::native == std::endian::little, "handoff format is little-endian");
+
+struct HandoffHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t sockets;
+    uint64_t session_count;
+    int64_t cleaned_at_ns;
+};
+
+struct HandoffRecord {
+    uint64_t key;
+    int64_t expires_ns;
+};
+
+std::runtime_error handoff_error(const std::string& what) {
+    return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+sockaddr_un make_address(const std::string& path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Handoff socket path is too long: " + path);
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+bool send_all(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t sent = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool recv_all(int fd, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        const ssize_t received = ::recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+uint64_t inode_of(const std::string& path) {
+    struct stat info{};
+    return ::stat(path.c_str(), &info) == 0 ? static_cast<uint64_t>(info.st_ino) : 0;
+}
+
+int64_t steady_ns(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+// Заголовок и сессии; сокеты идут вместе с заголовком: ядро привязывает SCM_RIGHTS к первому байту
+bool send_message(int fd, const HandoffHeader& header, const int* fds, size_t fd_count,
+                  const std::vector<SessionInfo>& sessions) {
+    iovec iov{const_cast<HandoffHeader*>(&header), sizeof(header)};
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (fd_count > 0) {
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(fd_count * sizeof(int));
+        cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(fd_count * sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), fds, fd_count * sizeof(int));
+    }
+    ssize_t sent;
+    do {
+        sent = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+    if (sent < 0 || (static_cast<size_t>(sent) < sizeof(header) &&
+                     !send_all(fd, reinterpret_cast<const char*>(&header) + sent, sizeof(header) - sent))) {
+        return false;
+    }
+
+    std::vector<HandoffRecord> chunk;
+    chunk.reserve(kRecordsPerChunk);
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        chunk.push_back({sessions[i].imsi.key(), steady_ns(sessions[i].expires_at)});
+        if (chunk.size() == kRecordsPerChunk || i + 1 == sessions.size()) {
+            if (!send_all(fd, chunk.data(), chunk.size() * sizeof(HandoffRecord))) {
+                return false;
+            }
+            chunk.clear();
+        }
+    }
+    return true;
+}
+
+// Сообщение send_message; принятые сокеты - в sockets, сессии дописываются в sessions
+void receive_message(int fd, const std::string& path, HandoffHeader& header, HandoffSockets& sockets,
+                     std::vector<SessionInfo>& sessions) {
+    iovec iov{&header, sizeof(header)};
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))] = {};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t received;
+    do {
+        received = ::recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) {
+        throw handoff_error("No handoff response from " + path);
+    }
+
+    int passed[2] = {-1, -1};
+    size_t passed_count = 0;
+    for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+            passed_count = std::min<size_t>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int), 2);
+            std::memcpy(passed, CMSG_DATA(cmsg), passed_count * sizeof(int));
+        }
+    }
+    // Сокеты раздаются по маске до любых проверок: владелец sockets закроет их и при исключении
+    size_t next = 0;
+    if (header.sockets & kUdpSocketBit && next < passed_count && sockets.udp_fd < 0) {
+        sockets.udp_fd = passed[next++];
+    }
+    if (header.sockets & kCdrExportSocketBit && next < passed_count && sockets.cdr_export_fd < 0) {
+        sockets.cdr_export_fd = passed[next++];
+    }
+    while (next < passed_count) ::close(passed[next++]);
+
+    if (static_cast<size_t>(received) < sizeof(header) &&
+        !recv_all(fd, reinterpret_cast<char*>(&header) + received, sizeof(header) - received)) {
+        throw std::runtime_error("Truncated handoff response from " + path);
+    }
+    if (std::memcmp(header.magic, kHandoffMagic, sizeof(header.magic)) != 0 || header.version != kHandoffVersion) {
+        throw std::runtime_error("Unsupported handoff response from " + path);
+    }
+
+    sessions.reserve(sessions.size() + header.session_count);
+    std::vector<HandoffRecord> chunk(kRecordsPerChunk);
+    for (uint64_t left = header.session_count; left > 0;) {
+        const size_t count = std::min<uint64_t>(left, kRecordsPerChunk);
+        if (!recv_all(fd, chunk.data(), count * sizeof(HandoffRecord))) {
+            throw std::runtime_error("Handoff stream from " + path + " ended early");
+        }
+        for (size_t i = 0; i < count; ++i) {
+            if (const auto imsi = Imsi::from_key(chunk[i].key)) {
+                sessions.push_back({*imsi, std::chrono::steady_clock::time_point(
+                    std::chrono::nanoseconds(chunk[i].expires_ns))});
+            }
+        }
+        left -= count;
+    }
+}
+
+// Вход SessionManager::restore_sessions. Порядок очереди истечения нарушается,
+// только если session_timeout_sec уменьшили во время передачи
+void sort_by_expiry(std::vector<SessionInfo>& sessions) {
+    const auto earlier = [](const SessionInfo& a, const SessionInfo& b) { return a.expires_at < b.expires_at; };
+    if (!std::is_sorted(sessions.begin(), sessions.end(), earlier)) {
+        std::stable_sort(sessions.begin(), sessions.end(), earlier);
+    }
+}
+
+} // namespace
+
+HandoffListener::HandoffListener(std::string path) : path_(std::move(path)) {
+    const sockaddr_un addr = make_address(path_);
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        throw handoff_error("Cannot create handoff socket " + path_);
+    }
+
+    // Файл остался от упавшего процесса или от старого, которому только что пришла замена
+    ::unlink(path_.c_str());
+    if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd_, 1) < 0) {
+        const auto error = handoff_error("Cannot listen on handoff socket " + path_);
+        ::close(listen_fd_);
+        throw error;
+    }
+    ::chmod(path_.c_str(), 0600);
+    inode_ = inode_of(path_);
+
+    Logger::get_logger()->info("Handoff socket listening on {}", path_);
+}
+
+HandoffListener::~HandoffListener() {
+    reset();
+    ::close(listen_fd_);
+    // Путь мог уже занять новый процесс: удаляется только свой файл
+    if (inode_ != 0 && inode_of(path_) == inode_) {
+        ::unlink(path_.c_str());
+    }
+}
+
+bool HandoffListener::accept_request() {
+    if (conn_fd_ >= 0) return true;
+
+    const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0) return false;
+
+    // Запрос приходит сразу после connect; зависший клиент не должен держать сервер
+    timeval receive_timeout{1, 0};
+    timeval send_timeout{5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &receive_timeout, sizeof(receive_timeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+    char magic[sizeof(kHandoffMagic)];
+    if (!recv_all(fd, magic, sizeof(magic)) || std::memcmp(magic, kHandoffMagic, sizeof(magic)) != 0) {
+        Logger::get_logger()->warn("Ignoring malformed handoff request on {}", path_);
+        ::close(fd);
+        return false;
+    }
+    conn_fd_ = fd;
+    return true;
+}
+
+bool HandoffListener::send_sessions(const SessionManager& session_manager) {
+    if (conn_fd_ < 0) return false;
+
+    // Обход страницами: трафик не ждёт блокировки всей таблицы. Изменённое во время обхода
+    // уйдёт ещё раз в фазе 2 - позиция очереди снята до него
+    queue_mark_ = session_manager.expiry_position();
+    std::vector<SessionInfo> sessions;
+    SessionCursor cursor;
+    for (;;) {
+        SessionPage page = session_manager.list_sessions(cursor, kRecordsPerChunk);
+        if (page.restarted) {
+            sessions.clear();
+        }
+        sessions.insert(sessions.end(), page.sessions.begin(), page.sessions.end());
+        if (page.done) break;
+        cursor = page.next;
+    }
+    HandoffHeader header{};
+    std::memcpy(header.magic, kHandoffMagic, sizeof(header.magic));
+    header.version = kHandoffVersion;
+    header.session_count = sessions.size();
+    if (!send_message(conn_fd_, header, nullptr, 0, sessions)) {
+        return false;
+    }
+    sessions_sent_ = sessions.size();
+    return true;
+}
+
+bool HandoffListener::wait_switch(std::chrono::milliseconds timeout) {
+    return wait_byte(kSwitch, timeout);
+}
+
+bool HandoffListener::send_state(const HandoffSockets& sockets, const SessionManager& session_manager,
+                                 std::chrono::steady_clock::time_point cleaned_at) {
+    if (conn_fd_ < 0) return false;
+
+    const std::vector<SessionInfo> changes = session_manager.sessions_by_expiry(queue_mark_);
+    HandoffHeader header{};
+    std::memcpy(header.magic, kHandoffMagic, sizeof(header.magic));
+    header.version = kHandoffVersion;
+    header.session_count = changes.size();
+    header.cleaned_at_ns = steady_ns(cleaned_at);
+
+    int fds[2];
+    size_t fd_count = 0;
+    if (sockets.udp_fd >= 0) {
+        header.sockets |= kUdpSocketBit;
+        fds[fd_count++] = sockets.udp_fd;
+    }
+    if (sockets.cdr_export_fd >= 0) {
+        header.sockets |= kCdrExportSocketBit;
+        fds[fd_count++] = sockets.cdr_export_fd;
+    }
+    if (!send_message(conn_fd_, header, fds, fd_count, changes)) {
+        return false;
+    }
+    changes_sent_ = changes.size();
+    return true;
+}
+
+bool HandoffListener::wait_ready(std::chrono::milliseconds timeout) {
+    return wait_byte(kReady, timeout);
+}
+
+bool HandoffListener::wait_byte(char expected, std::chrono::milliseconds timeout) {
+    if (conn_fd_ < 0) return false;
+
+    pollfd pfd{conn_fd_, POLLIN, 0};
+    int ready;
+    do {
+        ready = ::poll(&pfd, 1, static_cast<int>(timeout.count()));
+    } while (ready < 0 && errno == EINTR);
+    if (ready <= 0) return false;
+
+    char reply = 0;
+    return ::recv(conn_fd_, &reply, 1, 0) == 1 && reply == expected;
+}
+
+void HandoffListener::reset() {
+    if (conn_fd_ >= 0) {
+        ::close(conn_fd_);
+        conn_fd_ = -1;
+    }
+}
+
+std::unique_ptr<HandoffClient> HandoffClient::connect(const std::string& path, std::chrono::milliseconds timeout) {
+    const sockaddr_un addr = make_address(path);
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw handoff_error("Cannot create handoff socket");
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+        // Нет файла или никто не слушает - работающего процесса нет
+        ::close(fd);
+        return nullptr;
+    }
+
+    std::unique_ptr<HandoffClient> client(new HandoffClient());
+    client->conn_fd_ = fd;
+    client->path_ = path;
+
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+    timeval tv{static_cast<time_t>(seconds.count()),
+               static_cast<suseconds_t>(std::chrono::duration_cast<std::chrono::microseconds>(timeout - seconds).count())};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    if (!send_all(fd, kHandoffMagic, sizeof(kHandoffMagic))) {
+        throw handoff_error("Cannot send handoff request to " + path);
+    }
+    HandoffHeader header{};
+    receive_message(fd, path, header, client->sockets_, client->sessions_);
+    sort_by_expiry(client->sessions_);
+    return client;
+}
+
+void HandoffClient::switch_over() {
+    if (!send_all(conn_fd_, &kSwitch, 1)) {
+        throw handoff_error("Cannot request handoff switch from " + path_);
+    }
+
+    HandoffHeader header{};
+    sessions_.clear();
+    receive_message(conn_fd_, path_, header, sockets_, sessions_);
+    changes_received_ = sessions_.size();
+
+    // Истёкшие к моменту последней очистки старый процесс уже закрыл с записью CDR
+    cleaned_at_ = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(header.cleaned_at_ns));
+    std::erase_if(sessions_, [this](const SessionInfo& session) { return session.expires_at <= cleaned_at_; });
+    sort_by_expiry(sessions_);
+}
+
+HandoffClient::~HandoffClient() {
+    if (sockets_.udp_fd >= 0) ::close(sockets_.udp_fd);
+    if (sockets_.cdr_export_fd >= 0) ::close(sockets_.cdr_export_fd);
+    if (conn_fd_ >= 0) ::close(conn_fd_);
+}
+
+HandoffSockets HandoffClient::release_sockets() {
+    return std::exchange(sockets_, HandoffSockets{});
+}
+
+std::vector<SessionInfo> HandoffClient::take_sessions() {
+    return std::move(sessions_);
+}
+
+bool HandoffClient::ready() {
+    return conn_fd_ >= 0 && send_all(conn_fd_, &kReady, 1);
+}
@@ -1,59 +1,176 @@
 #include "session/session_manager.h"
 #include <iomanip>
 #include "utils/logger.h"
+#include "metrics/metrics.h"
+#include "utils/rcu.h"
+#include "utils/bcd_batch.h"
 #include <iostream>
+#include <charconv>
+#include <stdexcept>
 
 
 SessionManager::SessionManager(std::shared_ptr<CdrManager> cdr_manager,
                                int session_timeout_sec,
-                               const std::vector<std::string>& blacklist)
+                               const std::vector<std::string>& blacklist,
+                               std::shared_ptr<SessionEventBus> event_bus,
+                               std::shared_ptr<ShmSessionTable> shm_table,
+                               std::shared_ptr<SessionJournal> journal,
+                               std::shared_ptr<ReplicationLog> replication)
     : cdr_manager_(std::move(cdr_manager)),
-      session_timeout_sec_(session_timeout_sec) {
-    
-    for (const auto& imsi : blacklist) {
-        if (validate_imsi(imsi)) {
-            blacklist_.insert(imsi);
+      event_bus_(std::move(event_bus)),
+      shm_table_(std::move(shm_table)),
+      journal_(std::move(journal)),
+      replication_(std::move(replication)),
+      policy_(make_policy(session_timeout_sec, blacklist)) {
+}
+
+SessionManager::~SessionManager() {
+    delete policy_.load(std::memory_order_acquire);
+}
+
+const SessionPolicy* SessionManager::make_policy(int session_timeout_sec,
+                                                 const std::vector<std::string>& blacklist) const {
+    auto* policy = new SessionPolicy{session_timeout_sec, {}};
+    policy->blacklist.reserve(blacklist.size());
+    // Большие списки проверяются и упаковываются пакетными ядрами
+    const auto imsis = BCDBatch::parse(blacklist);
+    for (size_t i = 0; i < imsis.size(); ++i) {
+        if (!imsis[i].empty()) {
+            policy->blacklist.insert(imsis[i]);
+        } else {
+            const auto parsed = Imsi::parse(blacklist[i]);
+            Logger::get_logger()->warn("Ignoring invalid blacklist entry {}: {}", blacklist[i],
+                                       parsed ? "invalid IMSI" : imsi_error_message(parsed.error()));
         }
     }
+    return policy;
 }
 
+void SessionManager::update_policy(int session_timeout_sec, const std::vector<std::string>& blacklist) {
+    const SessionPolicy* next = make_policy(session_timeout_sec, blacklist);
 
-bool SessionManager::create_session(std::string_view imsi) {
-    if (!validate_imsi(imsi)) return false;
-    
-    if (blacklist_.find(std::string(imsi)) != blacklist_.end()) {
-        write_cdr(imsi, "rejected_blacklist");
-        return false;
+    std::lock_guard lock(policy_update_mutex_);
+    const SessionPolicy* previous = policy_.exchange(next, std::memory_order_seq_cst);
+    Rcu::synchronize();
+    delete previous;
+}
+
+int SessionManager::session_timeout_sec() const {
+    Rcu::ReadGuard guard;
+    return policy_.load(std::memory_order_acquire)->session_timeout_sec;
+}
+
+
+bool SessionManager::create_session(Imsi imsi) {
+    int timeout_sec;
+    {
+        Rcu::ReadGuard guard;
+        const SessionPolicy* policy = policy_.load(std::memory_order_acquire);
+        if (policy->blacklist.contains(imsi)) {
+            Metrics::increment(Counter::SessionsRejected);
+            PGW_LOG_INFO_RATE(kPacketLogPerSecond, "Rejected blacklisted IMSI {}", imsi.digits().view());
+            write_cdr(imsi, "rejected_blacklist");
+            return false;
+        }
+        timeout_sec = policy->session_timeout_sec;
     }
 
     auto expires_at = std::chrono::steady_clock::now() + 
-                      std::chrono::seconds(session_timeout_sec_);
+                      std::chrono::seconds(timeout_sec);
 
-    std::unique_lock lock(sessions_mutex_);
-    
-    auto [it, inserted] = sessions_.try_emplace(std::string(imsi), Session{expires_at});
-    
-    if (inserted) {
-        write_cdr(imsi, "created");
-    } else {
-        it->second.expires_at = expires_at;
-        write_cdr(imsi, "prolonged");
+    bool inserted;
+    {
+        std::unique_lock lock(sessions_mutex_);
+
+        auto [it, emplaced] = sessions_.try_emplace(imsi, Session{expires_at});
+        inserted = emplaced;
+        if (inserted) {
+            Metrics::increment(Counter::SessionsCreated);
+            PGW_LOG_DEBUG_SAMPLED(kPacketLogSampleRate, "Session created for {}", imsi.digits().view());
+            write_cdr(imsi, "created");
+        } else {
+            it->second.expires_at = expires_at;
+            Metrics::increment(Counter::SessionsProlonged);
+            write_cdr(imsi, "prolonged");
+        }
+
+        expiry_queue_.emplace_back(expires_at, imsi);
+        ++expiry_pushed_;
+        if (shm_table_) {
+            shm_table_->upsert(imsi, expires_at);
+        }
+        if (journal_) {
+            journal_->append(SessionJournal::Op::Upsert, imsi, expires_at);
+        }
+        if (replication_) {
+            replication_->append(SessionJournal::Op::Upsert, imsi, expires_at);
+        }
     }
 
-    expiry_queue_.emplace_back(expires_at, imsi);
+    // Событие - после снятия блокировки таблицы: подписчики не задерживают UDP
+    publish_event(inserted ? SessionEventType::Created : SessionEventType::Prolonged, imsi);
     
     return true;
 }
 
 
 
-bool SessionManager::session_exists(std::string_view imsi) const {
+size_t SessionManager::session_count() const {
+    std::shared_lock lock(sessions_mutex_);
+    return sessions_.size();
+}
+
+bool SessionManager::session_exists(Imsi imsi) const {
+    std::shared_lock lock(sessions_mutex_);
+    return sessions_.contains(imsi);
+}
+
+std::vector<bool> SessionManager::sessions_exist(std::span<const Imsi> imsis) const {
+    std::vector<bool> result(imsis.size());
+
     std::shared_lock lock(sessions_mutex_);
-    return sessions_.find(std::string(imsi)) != sessions_.end();
+    for (size_t i = 0; i < imsis.size(); ++i) {
+        result[i] = sessions_.find(imsis[i]) != sessions_.end();
+    }
+    return result;
+}
+
+SessionPage SessionManager::list_sessions(SessionCursor cursor, size_t limit) const {
+    SessionPage page;
+    page.sessions.reserve(limit);
+    // Пустые корзины тоже стоят времени: ограничиваем и их число за страницу
+    const size_t bucket_budget = std::max<size_t>(limit, 1) * 4;
+
+    std::shared_lock lock(sessions_mutex_);
+    const size_t bucket_count = sessions_.bucket_count();
+    if (cursor.bucket_count != bucket_count) {
+        page.restarted = cursor.bucket_count != 0;
+        cursor = SessionCursor{bucket_count, 0};
+    }
+
+    size_t bucket = cursor.bucket;
+    const size_t bucket_end = std::min(bucket_count, bucket + bucket_budget);
+    for (; bucket < bucket_end && page.sessions.size() < limit; ++bucket) {
+        for (auto it = sessions_.begin(bucket); it != sessions_.end(bucket); ++it) {
+            page.sessions.push_back({it->first, it->second.expires_at});
+        }
+    }
+
+    page.next = SessionCursor{bucket_count, bucket};
+    page.done = bucket >= bucket_count;
+    return page;
 }
 
-void SessionManager::cleanup_expired_sessions() {
-    auto now = std::chrono::steady_clock::now();
+void SessionManager::cleanup_expired_sessions(std::chrono::steady_clock::time_point now) {
+    expire_sessions(now, replica_.load(std::memory_order_relaxed));
+}
+
+void SessionManager::drop_closed_sessions(std::chrono::steady_clock::time_point cleaned_at) {
+    expire_sessions(cleaned_at, true);
+}
+
+void SessionManager::expire_sessions(std::chrono::steady_clock::time_point now, bool replica) {
+    std::vector<Imsi> expired;
     std::unique_lock lock(sessions_mutex_);
 
     while (!expiry_queue_.empty()) {
@@ -68,13 +185,99 @@ void SessionManager::cleanup_expired_sessions() {
         auto it = sessions_.find(imsi);
         if (it != sessions_.end()) {
             if (it->second.expires_at <= now) {
-                write_cdr(imsi, "expired");
+                if (!replica) {
+                    Metrics::increment(Counter::SessionsExpired);
+                    write_cdr(imsi, "expired");
+                    if (event_bus_) {
+                        expired.push_back(imsi);
+                    }
+                }
                 sessions_.erase(it);
+                if (shm_table_) {
+                    shm_table_->erase(imsi);
+                }
+                if (journal_) {
+                    journal_->append(SessionJournal::Op::Erase, imsi);
+                }
+                if (replication_) {
+                    replication_->append(SessionJournal::Op::Erase, imsi);
+                }
+            }
+        }
+    }
+    lock.unlock();
+
+    for (const Imsi imsi : expired) {
+        publish_event(SessionEventType::Expired, imsi);
+    }
+}
+
+void SessionManager::restore_sessions(std::vector<SessionInfo> sessions) {
+    std::unique_lock lock(sessions_mutex_);
+    sessions_.reserve(sessions_.size() + sessions.size());
+    for (const SessionInfo& session : sessions) {
+        sessions_.insert_or_assign(session.imsi, Session{session.expires_at});
+        expiry_queue_.emplace_back(session.expires_at, session.imsi);
+        ++expiry_pushed_;
+        if (shm_table_) {
+            shm_table_->upsert(session.imsi, session.expires_at);
+        }
+        // Источник (CDR, прежний процесс) может не быть описан снимком: до первого
+        // нового снимка восстановленный набор держится в журнале
+        if (journal_) {
+            journal_->append(SessionJournal::Op::Upsert, session.imsi, session.expires_at);
+        }
+    }
+}
+
+void SessionManager::apply_replicated(std::span<const ReplicatedChange> changes) {
+    std::unique_lock lock(sessions_mutex_);
+    for (const ReplicatedChange& change : changes) {
+        if (change.op == SessionJournal::Op::Upsert) {
+            sessions_.insert_or_assign(change.imsi, Session{change.expires_at});
+            expiry_queue_.emplace_back(change.expires_at, change.imsi);
+            ++expiry_pushed_;
+            if (shm_table_) {
+                shm_table_->upsert(change.imsi, change.expires_at);
+            }
+        } else if (sessions_.erase(change.imsi) > 0) {
+            if (shm_table_) {
+                shm_table_->erase(change.imsi);
             }
+        } else {
+            continue;
         }
+        if (journal_) {
+            journal_->append(change.op, change.imsi, change.expires_at);
+        }
+    }
+}
+
+std::vector<SessionInfo> SessionManager::sessions_by_expiry(uint64_t since, uint64_t* next) const {
+    std::vector<SessionInfo> sessions;
+    std::shared_lock lock(sessions_mutex_);
+    // Позиция since могла уже уйти из головы очереди при очистке
+    const uint64_t front = expiry_pushed_ - expiry_queue_.size();
+    const auto begin = expiry_queue_.begin() + static_cast<std::ptrdiff_t>(std::max(since, front) - front);
+    if (next) {
+        *next = expiry_pushed_;
     }
+    sessions.reserve(since == 0 ? sessions_.size() : static_cast<size_t>(expiry_queue_.end() - begin));
+    for (auto entry = begin; entry != expiry_queue_.end(); ++entry) {
+        const auto& [expires_at, imsi] = *entry;
+        // Продлённая сессия стоит в очереди несколько раз: действует последняя запись
+        auto it = sessions_.find(imsi);
+        if (it != sessions_.end() && it->second.expires_at == expires_at) {
+            sessions.push_back({imsi, expires_at});
+        }
+    }
+    return sessions;
 }
 
+uint64_t SessionManager::expiry_position() const {
+    std::shared_lock lock(sessions_mutex_);
+    return expiry_pushed_;
+}
 
 void SessionManager::graceful_shutdown(int sessions_per_sec) {
     const auto delay = sessions_per_sec > 0 ? 
@@ -82,7 +285,7 @@ void SessionManager::graceful_shutdown(int sessions_per_sec) {
         std::chrono::milliseconds(0);
 
     while (!sessions_.empty()) {
-        std::vector<std::string> to_remove;
+        std::vector<Imsi> to_remove;
 
         {
             std::unique_lock lock(sessions_mutex_);
@@ -95,31 +298,66 @@ void SessionManager::graceful_shutdown(int sessions_per_sec) {
 
             for (const auto& imsi : to_remove) {
                 sessions_.erase(imsi);
+                if (shm_table_) {
+                    shm_table_->erase(imsi);
+                }
+                if (journal_) {
+                    journal_->append(SessionJournal::Op::Erase, imsi);
+                }
+                if (replication_) {
+                    replication_->append(SessionJournal::Op::Erase, imsi);
+                }
             }
         }
 
         for (const auto& imsi : to_remove) {
             write_cdr(imsi, "graceful_removal");
+            publish_event(SessionEventType::Removed, imsi);
         }
+        Metrics::increment(Counter::SessionsRemoved, to_remove.size());
 
         if (!to_remove.empty() && delay.count() > 0) {
             std::this_thread::sleep_for(delay);
         }
     }
 }
-bool SessionManager::is_blacklisted(const std::string& imsi) const {
-    return blacklist_.contains(imsi);
+bool SessionManager::is_blacklisted(Imsi imsi) const {
+    Rcu::ReadGuard guard;
+    return policy_.load(std::memory_order_acquire)->blacklist.contains(imsi);
 }
 
-void SessionManager::write_cdr(std::string_view imsi, std::string_view action) const{
+void SessionManager::write_cdr(Imsi imsi, std::string_view action) const{
     if (cdr_manager_) {
         cdr_manager_->add_record(imsi, action);
     } else {
-        Logger::get_logger()->warn("CDR manager is null; skipping record for {} ({})", imsi, action);
+        PGW_LOG_WARN_RATE(kPacketLogPerSecond, "CDR manager is null; skipping record for {} ({})", imsi.digits().view(), action);
     }
 }
 
-bool SessionManager::validate_imsi(std::string_view imsi) const {
-    return !imsi.empty() && imsi.size() <= 15 &&
-           std::all_of(imsi.begin(), imsi.end(), ::isdigit);
+void SessionManager::publish_event(SessionEventType type, Imsi imsi) const {
+    if (event_bus_) {
+        event_bus_->publish(type, imsi);
+    }
+}
+
+std::string SessionCursor::to_string() const {
+    return std::to_string(bucket_count) + "-" + std::to_string(bucket);
+}
+
+SessionCursor SessionCursor::parse(std::string_view text) {
+    if (text == "0") {
+        return SessionCursor{};
+    }
+
+    SessionCursor cursor;
+    const char* end = text.data() + text.size();
+    auto [sep, ec] = std::from_chars(text.data(), end, cursor.bucket_count);
+    if (ec != std::errc() || sep == end || *sep != '-') {
+        throw std::invalid_argument("Invalid session cursor");
+    }
+    auto [tail, ec2] = std::from_chars(sep + 1, end, cursor.bucket);
+    if (ec2 != std::errc() || tail != end || cursor.bucket > cursor.bucket_count) {
+        throw std::invalid_argument("Invalid session cursor");
+    }
+    return cursor;
 }
@@ -0,0 +1,559 @@
+#include "session/session_replication.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include "session/session_manager.h"
+#include "utils/logger.h"
+
+namespace {
+
+constexpr char kReplicationMagic[8] = {'P', 'G', 'W', 'R', 'E', 'P', 'L', '1'};
+constexpr uint32_t kFullSync = 1;
+constexpr uint32_t kFullSyncEnd = 2;
+constexpr size_t kRecordSize = 1 + 8 + 8;              // как запись журнала
+constexpr size_t kRecordsPerFrame = 64 * 1024;
+// Обход таблицы для полной синхронизации: страница под короткой разделяемой блокировкой
+constexpr size_t kSyncPageSize = 4096;
+constexpr auto kHeartbeatInterval = std::chrono::seconds(1);
+constexpr auto kReconnectInterval = std::chrono::seconds(1);
+constexpr auto kPrimaryTimeout = 3 * kHeartbeatInterval;   // без пачек дольше - основной узел потерян
+constexpr int kConnectTimeoutMs = 1000;
+constexpr int kPollIntervalMs = 100;
+constexpr timeval kSocketTimeout{5, 0};                 // зависший peer не держит поток дольше
+
+static_assert(std::endian::native == std::endian::little, "replication format is little-endian");
+
+struct FrameHeader {
+    uint32_t payload_bytes;
+    uint32_t records;
+    uint32_t flags;
+    uint32_t raw_bytes;
+    int64_t sent_ns;
+    int64_t oldest_ns;
+};
+
+static_assert(sizeof(FrameHeader) == 32);
+
+int64_t steady_ns(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+void encode_record(char* out, SessionJournal::Op op, uint64_t key, int64_t expires_ns) {
+    out[0] = static_cast<char>(op);
+    std::memcpy(out + 1, &key, sizeof(key));
+    std::memcpy(out + 9, &expires_ns, sizeof(expires_ns));
+}
+
+bool send_all(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        const ssize_t sent = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool recv_all(int fd, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        const ssize_t received = ::recv(fd, bytes, size, 0);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return false;
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+void set_stream_options(int fd) {
+    const int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &kSocketTimeout, sizeof(kSocketTimeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &kSocketTimeout, sizeof(kSocketTimeout));
+}
+
+} // namespace
+
+void ReplicationLog::append(SessionJournal::Op op, Imsi imsi, std::chrono::steady_clock::time_point expires_at) {
+    if (!active_.load(std::memory_order_relaxed)) return;
+    char record[kRecordSize];
+    encode_record(record, op, imsi.key(), steady_ns(expires_at));
+
+    std::lock_guard lock(mutex_);
+    if (buffer_.empty()) {
+        oldest_ = std::chrono::steady_clock::now();
+    }
+    buffer_.insert(buffer_.end(), record, record + sizeof(record));
+}
+
+void ReplicationLog::activate() {
+    std::lock_guard lock(mutex_);
+    buffer_.clear();
+    active_.store(true, std::memory_order_relaxed);
+}
+
+void ReplicationLog::deactivate() {
+    active_.store(false, std::memory_order_relaxed);
+    std::lock_guard lock(mutex_);
+    buffer_.clear();
+}
+
+bool ReplicationLog::take(std::vector<char>& out, std::chrono::steady_clock::time_point& oldest) {
+    out.clear();
+    std::lock_guard lock(mutex_);
+    if (buffer_.empty()) return false;
+    // Буфер меняется местами с out: ёмкость переходит между пачками без новых выделений
+    out.swap(buffer_);
+    oldest = oldest_;
+    return true;
+}
+
+SessionReplicator::SessionReplicator(SessionManager& session_manager, std::shared_ptr<ReplicationLog> log,
+                                     std::string standby_ip, int standby_port,
+                                     std::chrono::milliseconds batch_interval)
+    : session_manager_(session_manager),
+      log_(std::move(log)),
+      standby_ip_(std::move(standby_ip)),
+      standby_port_(standby_port),
+      batch_interval_(batch_interval) {
+}
+
+SessionReplicator::~SessionReplicator() {
+    stop();
+}
+
+void SessionReplicator::start() {
+    if (worker_.joinable()) return;
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = false;
+    }
+    worker_ = std::thread(&SessionReplicator::run, this);
+}
+
+void SessionReplicator::stop() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+ReplicationStats SessionReplicator::stats() const {
+    std::lock_guard lock(stats_mutex_);
+    return stats_;
+}
+
+bool SessionReplicator::wait(std::chrono::milliseconds timeout) {
+    std::unique_lock lock(mutex_);
+    return cv_.wait_for(lock, timeout, [this] { return stopping_; });
+}
+
+bool SessionReplicator::wait_batch(int fd, bool& ok) {
+    const auto deadline = std::chrono::steady_clock::now() + batch_interval_;
+    for (;;) {
+        {
+            std::lock_guard lock(mutex_);
+            if (stopping_) return true;
+        }
+        const auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0) return false;
+        pollfd pfd{fd, POLLIN, 0};
+        if (::poll(&pfd, 1, static_cast<int>(std::min<int64_t>(left.count(), kPollIntervalMs))) > 0 && !read_acks(fd)) {
+            ok = false;
+            return false;
+        }
+    }
+}
+
+int SessionReplicator::connect_standby() {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(standby_port_));
+    if (::inet_pton(AF_INET, standby_ip_.c_str(), &addr.sin_addr) != 1) {
+        return -1;
+    }
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    // Неблокирующий connect с таймаутом: недоступный узел не задерживает stop()
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+        pollfd pfd{fd, POLLOUT, 0};
+        int error = errno;
+        if (error == EINPROGRESS && ::poll(&pfd, 1, kConnectTimeoutMs) == 1) {
+            socklen_t len = sizeof(error);
+            ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+        } else if (error == EINPROGRESS) {
+            error = ETIMEDOUT;
+        }
+        if (error != 0) {
+            ::close(fd);
+            return -1;
+        }
+    }
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    set_stream_options(fd);
+    return fd;
+}
+
+void SessionReplicator::run() {
+    bool reported_down = false;
+    bool stopping = false;
+    std::vector<char> batch;
+    while (!stopping) {
+        const int fd = connect_standby();
+        if (fd < 0) {
+            if (!reported_down) {
+                Logger::get_logger()->warn("Standby {}:{} is not reachable, retrying every {} s",
+                                           standby_ip_, standby_port_, kReconnectInterval.count());
+                reported_down = true;
+            }
+            stopping = wait(kReconnectInterval);
+            continue;
+        }
+
+        // Изменения копятся с этого момента: полная синхронизация их уже видит, а
+        // повтор Upsert или Erase на резервном узле ничего не меняет
+        log_->activate();
+        const auto started = std::chrono::steady_clock::now();
+        bool ok = send_all(fd, kReplicationMagic, sizeof(kReplicationMagic)) && full_sync(fd);
+        if (ok) {
+            reported_down = false;
+            {
+                std::lock_guard stats_lock(stats_mutex_);
+                stats_.connected = true;
+            }
+            Logger::get_logger()->info("Replicating sessions to standby {}:{}: full sync in {:.3f} s",
+                standby_ip_, standby_port_,
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+        }
+
+        auto last_sent = std::chrono::steady_clock::now();
+        while (ok) {
+            // При остановке накопленное уходит последней пачкой
+            stopping = wait_batch(fd, ok);
+            if (!ok) break;
+            std::chrono::steady_clock::time_point oldest;
+            const auto now = std::chrono::steady_clock::now();
+            if (log_->take(batch, oldest)) {
+                const size_t count = batch.size() / kRecordSize;
+                for (size_t first = 0; ok && first < count; first += kRecordsPerFrame) {
+                    ok = send_frame(fd, batch.data() + first * kRecordSize,
+                                    std::min(kRecordsPerFrame, count - first), 0, oldest);
+                }
+                last_sent = now;
+            } else if (now - last_sent >= kHeartbeatInterval) {
+                ok = send_frame(fd, nullptr, 0, 0, now);
+                last_sent = now;
+            }
+            if (stopping) break;
+        }
+
+        log_->deactivate();
+        ::close(fd);
+        {
+            std::lock_guard stats_lock(stats_mutex_);
+            stats_.connected = false;
+        }
+        if (!stopping) {
+            Logger::get_logger()->warn("Replication to standby {}:{} lost, reconnecting", standby_ip_, standby_port_);
+            stopping = wait(kReconnectInterval);
+        }
+    }
+}
+
+bool SessionReplicator::full_sync(int fd) {
+    const auto now = std::chrono::steady_clock::now();
+    std::vector<char> records(kRecordsPerFrame * kRecordSize);
+    size_t count = 0;
+    // Страницами list_sessions: трафик не ждёт блокировки всей таблицы. После рехеширования
+    // обход начинается заново, а повтор Upsert на резервном узле ничего не меняет
+    SessionCursor cursor;
+    for (;;) {
+        const SessionPage page = session_manager_.list_sessions(cursor, kSyncPageSize);
+        for (const SessionInfo& session : page.sessions) {
+            if (count == kRecordsPerFrame) {
+                if (!send_frame(fd, records.data(), count, kFullSync, now)) {
+                    return false;
+                }
+                count = 0;
+            }
+            encode_record(records.data() + count * kRecordSize, SessionJournal::Op::Upsert,
+                          session.imsi.key(), steady_ns(session.expires_at));
+            ++count;
+        }
+        if (page.done) break;
+        cursor = page.next;
+    }
+    if (!send_frame(fd, records.data(), count, kFullSync | kFullSyncEnd, now)) {
+        return false;
+    }
+
+    std::lock_guard stats_lock(stats_mutex_);
+    ++stats_.full_syncs;
+    return true;
+}
+
+bool SessionReplicator::send_frame(int fd, const char* records, size_t count, uint32_t flags,
+                                   std::chrono::steady_clock::time_point oldest) {
+    const uLong raw_bytes = static_cast<uLong>(count * kRecordSize);
+    uLongf compressed_bytes = 0;
+    if (count > 0) {
+        compressed_.resize(::compressBound(raw_bytes));
+        compressed_bytes = static_cast<uLongf>(compressed_.size());
+        if (::compress2(compressed_.data(), &compressed_bytes, reinterpret_cast<const Bytef*>(records),
+                        raw_bytes, Z_BEST_SPEED) != Z_OK) {
+            Logger::get_logger()->error("Replication: cannot compress a batch of {} records", count);
+            return false;
+        }
+    }
+
+    const FrameHeader header{static_cast<uint32_t>(compressed_bytes), static_cast<uint32_t>(count), flags,
+                             static_cast<uint32_t>(raw_bytes), steady_ns(std::chrono::steady_clock::now()),
+                             steady_ns(oldest)};
+    if (!send_all(fd, &header, sizeof(header)) || !send_all(fd, compressed_.data(), compressed_bytes)) {
+        return false;
+    }
+
+    std::lock_guard stats_lock(stats_mutex_);
+    ++stats_.frames;
+    stats_.records += count;
+    stats_.raw_bytes += raw_bytes;
+    stats_.compressed_bytes += compressed_bytes;
+    return true;
+}
+
+bool SessionReplicator::read_acks(int fd) {
+    for (;;) {
+        int64_t oldest_ns;
+        const ssize_t peeked = ::recv(fd, &oldest_ns, sizeof(oldest_ns), MSG_PEEK | MSG_DONTWAIT);
+        if (peeked < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        if (peeked == 0) return false;
+        if (static_cast<size_t>(peeked) < sizeof(oldest_ns)) return true;    // остаток придёт позже
+        ::recv(fd, &oldest_ns, sizeof(oldest_ns), 0);
+
+        const double lag_ms = static_cast<double>(steady_ns(std::chrono::steady_clock::now()) - oldest_ns) / 1e6;
+        std::lock_guard stats_lock(stats_mutex_);
+        stats_.lag_ms = lag_ms;
+    }
+}
+
+ReplicationReceiver::ReplicationReceiver(SessionManager& session_manager, const std::string& ip, int port)
+    : session_manager_(session_manager) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    if (::inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) {
+        throw std::runtime_error("Invalid replication address: " + ip);
+    }
+
+    // SO_REUSEPORT: новый процесс при передаче работы слушает порт, пока старый не вышел
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    const int reuse = 1;
+    if (listen_fd_ < 0 ||
+        ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) < 0 ||
+        ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse)) < 0 ||
+        ::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listen_fd_, 4) < 0) {
+        const std::string error = std::strerror(errno);
+        if (listen_fd_ >= 0) ::close(listen_fd_);
+        throw std::runtime_error("Cannot listen for replication on port " + std::to_string(port) + ": " + error);
+    }
+
+    socklen_t len = sizeof(addr);
+    ::getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+}
+
+ReplicationReceiver::~ReplicationReceiver() {
+    stop();
+    ::close(listen_fd_);
+}
+
+void ReplicationReceiver::start() {
+    if (worker_.joinable()) return;
+    stopping_ = false;
+    worker_ = std::thread(&ReplicationReceiver::run, this);
+}
+
+void ReplicationReceiver::stop() {
+    stopping_ = true;
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+ReplicationStats ReplicationReceiver::stats() const {
+    std::lock_guard lock(stats_mutex_);
+    return stats_;
+}
+
+void ReplicationReceiver::set_connected(bool connected) {
+    session_manager_.set_replica(connected);
+    std::lock_guard lock(stats_mutex_);
+    stats_.connected = connected;
+}
+
+void ReplicationReceiver::run() {
+    int conn_fd = -1;
+    std::vector<ReplicatedChange> changes;
+    std::vector<uint64_t> synced;       // ключи текущей полной синхронизации
+    auto last_frame = std::chrono::steady_clock::now();
+    while (!stopping_) {
+        pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {conn_fd, POLLIN, 0}};
+        const int ready = ::poll(fds, conn_fd >= 0 ? 2 : 1, kPollIntervalMs);
+        const auto now = std::chrono::steady_clock::now();
+
+        bool lost = false;
+        if (ready > 0 && (fds[0].revents & POLLIN)) {
+            accept_primary(conn_fd);
+            synced.clear();
+            last_frame = now;
+        } else if (ready > 0 && conn_fd >= 0 && fds[1].revents != 0) {
+            lost = !receive_frame(conn_fd, changes, synced);
+            last_frame = now;
+        } else if (conn_fd >= 0 && now - last_frame > kPrimaryTimeout) {
+            lost = true;    // обрыв без FIN: основной узел упал вместе с хостом
+        }
+        if (lost) {
+            Logger::get_logger()->warn("Replication stream from the primary lost, serving as a standalone node");
+            ::close(conn_fd);
+            conn_fd = -1;
+            set_connected(false);
+        }
+    }
+    if (conn_fd >= 0) {
+        ::close(conn_fd);
+        set_connected(false);
+    }
+}
+
+void ReplicationReceiver::accept_primary(int& conn_fd) {
+    sockaddr_in peer{};
+    socklen_t len = sizeof(peer);
+    const int fd = ::accept4(listen_fd_, reinterpret_cast<sockaddr*>(&peer), &len, SOCK_CLOEXEC);
+    if (fd < 0) return;
+    set_stream_options(fd);
+
+    char magic[sizeof(kReplicationMagic)];
+    if (!recv_all(fd, magic, sizeof(magic)) || std::memcmp(magic, kReplicationMagic, sizeof(magic)) != 0) {
+        ::close(fd);
+        return;
+    }
+
+    char ip[INET_ADDRSTRLEN] = {};
+    ::inet_ntop(AF_INET, &peer.sin_addr, ip, sizeof(ip));
+    if (conn_fd >= 0) {
+        // Новый основной узел (обновлён без простоя или переподключился) заменяет старый
+        ::close(conn_fd);
+        Logger::get_logger()->info("Replication stream replaced by the primary at {}:{}", ip, ntohs(peer.sin_port));
+    } else {
+        Logger::get_logger()->info("Replication stream from the primary at {}:{}", ip, ntohs(peer.sin_port));
+    }
+    conn_fd = fd;
+    set_connected(true);
+}
+
+bool ReplicationReceiver::receive_frame(int fd, std::vector<ReplicatedChange>& changes, std::vector<uint64_t>& synced) {
+    FrameHeader header;
+    if (!recv_all(fd, &header, sizeof(header))) {
+        return false;
+    }
+    if (header.records > kRecordsPerFrame || header.raw_bytes != header.records * kRecordSize ||
+        header.payload_bytes > ::compressBound(header.raw_bytes)) {
+        Logger::get_logger()->error("Replication: malformed frame ({} records, {} bytes)",
+                                    header.records, header.payload_bytes);
+        return false;
+    }
+    payload_.resize(header.payload_bytes);
+    raw_.resize(header.raw_bytes);
+    if (!recv_all(fd, payload_.data(), payload_.size())) {
+        return false;
+    }
+    uLongf raw_bytes = static_cast<uLongf>(raw_.size());
+    if (header.records > 0 &&
+        (::uncompress(raw_.data(), &raw_bytes, payload_.data(), static_cast<uLong>(payload_.size())) != Z_OK ||
+         raw_bytes != header.raw_bytes)) {
+        Logger::get_logger()->error("Replication: cannot decompress a frame of {} records", header.records);
+        return false;
+    }
+
+    // Сроки - относительно момента отправки по часам основного узла
+    const auto now = std::chrono::steady_clock::now();
+    changes.clear();
+    for (uint32_t i = 0; i < header.records; ++i) {
+        const unsigned char* record = raw_.data() + i * kRecordSize;
+        uint64_t key;
+        int64_t expires_ns;
+        std::memcpy(&key, record + 1, sizeof(key));
+        std::memcpy(&expires_ns, record + 9, sizeof(expires_ns));
+        const auto imsi = Imsi::from_key(key);
+        if (!imsi) continue;
+        const auto op = static_cast<SessionJournal::Op>(record[0]);
+        changes.push_back({op, *imsi, now + std::chrono::nanoseconds(expires_ns - header.sent_ns)});
+        if (header.flags & kFullSync) {
+            synced.push_back(key);
+        }
+    }
+
+    session_manager_.apply_replicated(changes);
+    if (header.flags & kFullSyncEnd) {
+        drop_unsynced(changes, synced);
+        Logger::get_logger()->info("Replication: full sync of {} sessions applied", synced.size());
+        std::vector<uint64_t>().swap(synced);
+    }
+
+    if (!send_all(fd, &header.oldest_ns, sizeof(header.oldest_ns))) {
+        return false;
+    }
+    std::lock_guard lock(stats_mutex_);
+    ++stats_.frames;
+    stats_.records += header.records;
+    stats_.raw_bytes += header.raw_bytes;
+    stats_.compressed_bytes += header.payload_bytes;
+    if (header.flags & kFullSyncEnd) {
+        ++stats_.full_syncs;
+    }
+    return true;
+}
+
+void ReplicationReceiver::drop_unsynced(std::vector<ReplicatedChange>& changes, std::vector<uint64_t>& synced) {
+    // Сессии, закрытые, пока резервный узел был отключён. Удаление страницами, как обход
+    // на основном узле; после рехеширования обход повторяется, повтор Erase ничего не меняет
+    std::sort(synced.begin(), synced.end());
+    SessionCursor cursor;
+    for (;;) {
+        const SessionPage page = session_manager_.list_sessions(cursor, kSyncPageSize);
+        changes.clear();
+        for (const SessionInfo& session : page.sessions) {
+            if (!std::binary_search(synced.begin(), synced.end(), session.imsi.key())) {
+                changes.push_back({SessionJournal::Op::Erase, session.imsi, {}});
+            }
+        }
+        if (!changes.empty()) {
+            session_manager_.apply_replicated(changes);
+        }
+        if (page.done) break;
+        cursor = page.next;
+    }
+}
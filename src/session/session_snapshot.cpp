@@ -0,0 +1,505 @@
+#include "session/session_snapshot.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include "session/session_manager.h"
+#include "utils/logger.h"
+
+namespace {
+
+constexpr char kJournalMagic[8] = {'P', 'G', 'W', 'J', 'R', 'N', 'L', '1'};
+constexpr char kSnapshotMagic[8] = {'P', 'G', 'W', 'S', 'N', 'A', 'P', '1'};
+constexpr std::string_view kJournalPrefix = "journal.";
+constexpr size_t kJournalRecordSize = 1 + 8 + 8;
+constexpr size_t kPageSize = 4096;                  // сессий за один захват блокировки при снимке
+constexpr size_t kWriteChunk = 1 << 20;
+constexpr auto kFlushInterval = std::chrono::milliseconds(100);
+constexpr int64_t kErased = std::numeric_limits<int64_t>::min();
+
+static_assert(std::endian::native == std::endian::little, "snapshot format is little-endian");
+
+struct JournalHeader {
+    char magic[8];
+    uint64_t sequence;
+    int64_t wall_ns;
+    int64_t steady_ns;
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    uint64_t journal_sequence;
+    uint64_t count;
+    int64_t wall_ns;
+};
+
+struct SnapshotRecord {
+    uint64_t key;
+    int64_t expires_wall_ns;
+};
+
+static_assert(sizeof(JournalHeader) == 32 && sizeof(SnapshotHeader) == 32 && sizeof(SnapshotRecord) == 16);
+
+int64_t wall_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t steady_ns(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+std::runtime_error io_error(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+void write_all(int fd, const char* data, size_t size, const std::string& path) {
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw io_error("Cannot write", path);
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+bool read_all(int fd, char* data, size_t size, off_t offset) {
+    while (size > 0) {
+        const ssize_t got = ::pread(fd, data, size, offset);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return false;
+        data += got;
+        size -= static_cast<size_t>(got);
+        offset += got;
+    }
+    return true;
+}
+
+void fsync_dir(const std::string& dir) {
+    const int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+// Журналы в dir по возрастанию номера
+std::map<uint64_t, std::string> list_journals(const std::string& dir) {
+    std::map<uint64_t, std::string> journals;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        const std::string name = entry.path().filename().string();
+        if (!name.starts_with(kJournalPrefix)) continue;
+        uint64_t sequence = 0;
+        const char* begin = name.data() + kJournalPrefix.size();
+        const char* end = name.data() + name.size();
+        const auto [tail, parse_ec] = std::from_chars(begin, end, sequence);
+        if (parse_ec == std::errc() && tail == end) {
+            journals.emplace(sequence, entry.path().string());
+        }
+    }
+    return journals;
+}
+
+std::string journal_path(const std::string& dir, uint64_t sequence) {
+    return (std::filesystem::path(dir) / (std::string(kJournalPrefix) + std::to_string(sequence))).string();
+}
+
+// Последнее состояние IMSI из журналов: срок по system_clock или kErased. Обрезанная
+// последняя запись (падение посреди write) отбрасывается
+uint64_t replay_journal(const std::string& path, std::unordered_map<uint64_t, int64_t>& overlay) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    struct stat info{};
+    std::vector<char> data;
+    if (::fstat(fd, &info) == 0) {
+        data.resize(static_cast<size_t>(info.st_size));
+        if (!read_all(fd, data.data(), data.size(), 0)) data.clear();
+    }
+    ::close(fd);
+
+    JournalHeader header;
+    if (data.size() < sizeof(header)) return 0;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, kJournalMagic, sizeof(kJournalMagic)) != 0) {
+        Logger::get_logger()->warn("Skipping {}: not a session journal", path);
+        return 0;
+    }
+
+    uint64_t records = 0;
+    for (size_t offset = sizeof(header); offset + kJournalRecordSize <= data.size(); offset += kJournalRecordSize) {
+        const auto op = static_cast<SessionJournal::Op>(data[offset]);
+        uint64_t key;
+        int64_t expires_steady_ns;
+        std::memcpy(&key, data.data() + offset + 1, sizeof(key));
+        std::memcpy(&expires_steady_ns, data.data() + offset + 9, sizeof(expires_steady_ns));
+        if (op == SessionJournal::Op::Upsert) {
+            overlay[key] = header.wall_ns + (expires_steady_ns - header.steady_ns);
+        } else {
+            overlay[key] = kErased;
+        }
+        ++records;
+    }
+    return records;
+}
+
+} // namespace
+
+std::vector<SessionInfo> merge_by_expiry(std::vector<std::vector<SessionInfo>> parts) {
+    std::vector<SessionInfo> sessions;
+    size_t total = 0;
+    for (const auto& part : parts) total += part.size();
+    sessions.reserve(total);
+    std::vector<size_t> bounds{0};
+    for (auto& part : parts) {
+        sessions.insert(sessions.end(), part.begin(), part.end());
+        bounds.push_back(sessions.size());
+        std::vector<SessionInfo>().swap(part);
+    }
+
+    // Попарное слияние соседних частей, пары одного уровня - в отдельных потоках
+    const auto by_expiry = [](const SessionInfo& a, const SessionInfo& b) { return a.expires_at < b.expires_at; };
+    while (bounds.size() > 2) {
+        std::vector<size_t> merged{0};
+        std::vector<std::jthread> mergers;
+        for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+            if (i + 2 < bounds.size()) {
+                const auto first = sessions.begin() + static_cast<ptrdiff_t>(bounds[i]);
+                const auto middle = sessions.begin() + static_cast<ptrdiff_t>(bounds[i + 1]);
+                const auto last = sessions.begin() + static_cast<ptrdiff_t>(bounds[i + 2]);
+                mergers.emplace_back([=] { std::inplace_merge(first, middle, last, by_expiry); });
+                merged.push_back(bounds[i + 2]);
+            } else {
+                merged.push_back(bounds[i + 1]);
+            }
+        }
+        mergers.clear();
+        bounds = std::move(merged);
+    }
+    return sessions;
+}
+
+SessionJournal::SessionJournal(std::string dir) : dir_(std::move(dir)) {
+    std::filesystem::create_directories(dir_);
+    const auto journals = list_journals(dir_);
+    open_journal(journals.empty() ? 1 : journals.rbegin()->first + 1);
+}
+
+SessionJournal::~SessionJournal() {
+    flush();
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void SessionJournal::open_journal(uint64_t sequence) {
+    const std::string path = journal_path(dir_, sequence);
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw io_error("Cannot create session journal", path);
+    }
+    JournalHeader header{};
+    std::memcpy(header.magic, kJournalMagic, sizeof(kJournalMagic));
+    header.sequence = sequence;
+    header.wall_ns = wall_now_ns();
+    header.steady_ns = steady_ns(std::chrono::steady_clock::now());
+    write_all(fd, reinterpret_cast<const char*>(&header), sizeof(header), path);
+
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = fd;
+    sequence_ = sequence;
+}
+
+void SessionJournal::append(Op op, Imsi imsi, std::chrono::steady_clock::time_point expires_at) {
+    char record[kJournalRecordSize];
+    const uint64_t key = imsi.key();
+    const int64_t expires_ns = steady_ns(expires_at);
+    record[0] = static_cast<char>(op);
+    std::memcpy(record + 1, &key, sizeof(key));
+    std::memcpy(record + 9, &expires_ns, sizeof(expires_ns));
+
+    std::lock_guard lock(buffer_mutex_);
+    buffer_.insert(buffer_.end(), record, record + sizeof(record));
+}
+
+void SessionJournal::flush() {
+    std::lock_guard file_lock(file_mutex_);
+    std::vector<char> pending;
+    {
+        std::lock_guard lock(buffer_mutex_);
+        pending.swap(buffer_);
+    }
+    if (pending.empty() || fd_ < 0) return;
+    try {
+        write_all(fd_, pending.data(), pending.size(), journal_path(dir_, sequence_));
+    } catch (const std::exception& e) {
+        Logger::get_logger()->error("Session journal: {}", e.what());
+    }
+}
+
+uint64_t SessionJournal::rotate() {
+    flush();
+    std::lock_guard file_lock(file_mutex_);
+    ::fsync(fd_);
+    open_journal(sequence_ + 1);
+    return sequence_;
+}
+
+uint64_t SessionJournal::sequence() const {
+    std::lock_guard file_lock(file_mutex_);
+    return sequence_;
+}
+
+SessionSnapshotter::SessionSnapshotter(SessionManager& session_manager, std::shared_ptr<SessionJournal> journal,
+                                       std::chrono::seconds interval)
+    : session_manager_(session_manager),
+      journal_(std::move(journal)),
+      interval_(interval) {
+}
+
+SessionSnapshotter::~SessionSnapshotter() {
+    stop();
+}
+
+std::string SessionSnapshotter::snapshot_path(const std::string& dir) {
+    return (std::filesystem::path(dir) / "sessions.snap").string();
+}
+
+void SessionSnapshotter::start() {
+    if (worker_.joinable()) return;
+    {
+        // Повторный запуск после stop(): откат неудачной передачи работы
+        std::lock_guard lock(mutex_);
+        stopping_ = false;
+    }
+    worker_ = std::thread(&SessionSnapshotter::run, this);
+}
+
+void SessionSnapshotter::stop() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    journal_->flush();
+}
+
+void SessionSnapshotter::run() {
+    auto next_snapshot = std::chrono::steady_clock::now();
+    std::unique_lock lock(mutex_);
+    while (!stopping_) {
+        lock.unlock();
+        journal_->flush();
+        if (std::chrono::steady_clock::now() >= next_snapshot) {
+            try {
+                write_snapshot();
+            } catch (const std::exception& e) {
+                Logger::get_logger()->error("Session snapshot failed: {}", e.what());
+            }
+            next_snapshot = std::chrono::steady_clock::now() + interval_;
+        }
+        lock.lock();
+        cv_.wait_for(lock, kFlushInterval, [this] { return stopping_; });
+    }
+}
+
+uint64_t SessionSnapshotter::write_snapshot() {
+    const auto started = std::chrono::steady_clock::now();
+    const std::string& dir = journal_->dir();
+    const std::string path = snapshot_path(dir);
+    const std::string temp_path = path + ".tmp";
+
+    // Всё, что изменится с этого момента, попадёт в журнал journal_sequence
+    const uint64_t journal_sequence = journal_->rotate();
+
+    const int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw io_error("Cannot create session snapshot", temp_path);
+    }
+
+    uint64_t count = 0;
+    try {
+        SnapshotHeader header{};
+        std::memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+        header.journal_sequence = journal_sequence;
+        header.wall_ns = wall_now_ns();
+        write_all(fd, reinterpret_cast<const char*>(&header), sizeof(header), temp_path);
+
+        const int64_t anchor_steady_ns = steady_ns(std::chrono::steady_clock::now());
+        const int64_t anchor_wall_ns = wall_now_ns();
+        std::vector<SnapshotRecord> buffer;
+        buffer.reserve(kWriteChunk / sizeof(SnapshotRecord));
+
+        SessionCursor cursor;
+        for (;;) {
+            const SessionPage page = session_manager_.list_sessions(cursor, kPageSize);
+            if (page.restarted) {
+                // Таблица рехеширована, обход начат заново: уже записанное отбрасывается,
+                // иначе в снимке будут повторы. Изменения с начала обхода - в журнале
+                if (::ftruncate(fd, sizeof(header)) < 0 || ::lseek(fd, sizeof(header), SEEK_SET) < 0) {
+                    throw io_error("Cannot restart session snapshot", temp_path);
+                }
+                count = 0;
+                buffer.clear();
+            }
+            for (const SessionInfo& session : page.sessions) {
+                buffer.push_back({session.imsi.key(), anchor_wall_ns + (steady_ns(session.expires_at) - anchor_steady_ns)});
+            }
+            if (buffer.size() * sizeof(SnapshotRecord) >= kWriteChunk || page.done) {
+                write_all(fd, reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(SnapshotRecord), temp_path);
+                count += buffer.size();
+                buffer.clear();
+            }
+            if (page.done) break;
+            cursor = page.next;
+        }
+
+        header.count = count;
+        if (::pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) || ::fsync(fd) < 0) {
+            throw io_error("Cannot finish session snapshot", temp_path);
+        }
+    } catch (...) {
+        ::close(fd);
+        ::unlink(temp_path.c_str());
+        throw;
+    }
+    ::close(fd);
+
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        throw io_error("Cannot rename session snapshot", temp_path);
+    }
+    fsync_dir(dir);
+
+    // Старые журналы покрыты новым снимком
+    for (const auto& [sequence, journal] : list_journals(dir)) {
+        if (sequence < journal_sequence) {
+            std::filesystem::remove(journal);
+        }
+    }
+
+    const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    Logger::get_logger()->info("Session snapshot: {} sessions in {:.3f} s", count, elapsed);
+    return count;
+}
+
+SessionRestoreStats SessionSnapshotter::restore(const std::string& dir, SessionManager& session_manager,
+                                                unsigned threads) {
+    const auto started = std::chrono::steady_clock::now();
+    const int64_t wall_now = wall_now_ns();
+    const auto steady_now = std::chrono::steady_clock::now();
+    SessionRestoreStats stats;
+    threads = std::max(threads, 1u);
+
+    const std::string path = snapshot_path(dir);
+    SnapshotHeader header{};
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        struct stat info{};
+        if (::fstat(fd, &info) < 0 || !read_all(fd, reinterpret_cast<char*>(&header), sizeof(header), 0) ||
+            std::memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 ||
+            static_cast<uint64_t>(info.st_size) != sizeof(header) + header.count * sizeof(SnapshotRecord)) {
+            ::close(fd);
+            throw std::runtime_error("Corrupted session snapshot: " + path);
+        }
+        stats.snapshot_sessions = header.count;
+    }
+
+    // Журналы от номера снимка: изменения во время и после его записи
+    std::unordered_map<uint64_t, int64_t> overlay;
+    for (const auto& [sequence, journal] : list_journals(dir)) {
+        if (sequence >= header.journal_sequence) {
+            stats.journal_records += replay_journal(journal, overlay);
+        }
+    }
+
+    const auto to_steady = [&](int64_t expires_wall_ns) {
+        return steady_now + std::chrono::nanoseconds(expires_wall_ns - wall_now);
+    };
+
+    // Каждый поток читает свой диапазон записей снимка, отбрасывает истёкшие и
+    // перекрытые журналом и сортирует остаток по сроку
+    const uint64_t per_thread = (stats.snapshot_sessions + threads - 1) / threads;
+    std::vector<std::vector<SessionInfo>> parts(threads + 1);
+    std::atomic<uint64_t> expired{0};
+    std::atomic<bool> failed{false};
+    {
+        std::vector<std::jthread> workers;
+        for (unsigned t = 0; t < threads && fd >= 0; ++t) {
+            const uint64_t begin = std::min<uint64_t>(stats.snapshot_sessions, t * per_thread);
+            const uint64_t end = std::min<uint64_t>(stats.snapshot_sessions, begin + per_thread);
+            if (begin == end) break;
+            workers.emplace_back([&, t, begin, end] {
+                std::vector<SnapshotRecord> records(end - begin);
+                if (!read_all(fd, reinterpret_cast<char*>(records.data()), records.size() * sizeof(SnapshotRecord),
+                              static_cast<off_t>(sizeof(SnapshotHeader) + begin * sizeof(SnapshotRecord)))) {
+                    failed = true;
+                    return;
+                }
+                auto& part = parts[t];
+                part.reserve(records.size());
+                uint64_t stale = 0;
+                for (const SnapshotRecord& record : records) {
+                    if (overlay.contains(record.key)) continue;
+                    const auto imsi = Imsi::from_key(record.key);
+                    if (!imsi) {
+                        failed = true;
+                        return;
+                    }
+                    if (record.expires_wall_ns <= wall_now) {
+                        ++stale;
+                        continue;
+                    }
+                    part.push_back({*imsi, to_steady(record.expires_wall_ns)});
+                }
+                std::sort(part.begin(), part.end(),
+                          [](const SessionInfo& a, const SessionInfo& b) { return a.expires_at < b.expires_at; });
+                expired += stale;
+            });
+        }
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    if (failed) {
+        throw std::runtime_error("Corrupted session snapshot: " + path);
+    }
+
+    auto& journal_part = parts[threads];
+    for (const auto& [key, expires_wall_ns] : overlay) {
+        if (expires_wall_ns == kErased) continue;
+        const auto imsi = Imsi::from_key(key);
+        if (!imsi) continue;
+        if (expires_wall_ns <= wall_now) {
+            ++expired;
+            continue;
+        }
+        journal_part.push_back({*imsi, to_steady(expires_wall_ns)});
+    }
+    std::sort(journal_part.begin(), journal_part.end(),
+              [](const SessionInfo& a, const SessionInfo& b) { return a.expires_at < b.expires_at; });
+
+    std::vector<SessionInfo> sessions = merge_by_expiry(std::move(parts));
+
+    stats.expired = expired;
+    stats.restored = sessions.size();
+    session_manager.restore_sessions(std::move(sessions));
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return stats;
+}
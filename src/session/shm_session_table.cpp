@@ -0,0 +1,267 @@
+#include "session/shm_session_table.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "utils/logger.h"
+
+namespace {
+
+// Перестроение, когда занятые и удалённые слоты превышают 3/4 таблицы
+constexpr uint64_t kMaxLoadNumerator = 3;
+constexpr uint64_t kMaxLoadDenominator = 4;
+
+std::runtime_error shm_error(const std::string& what, const std::string& name) {
+    return std::runtime_error(what + " " + name + ": " + std::strerror(errno));
+}
+
+// Каталог, в котором glibc держит объекты shm_open: через него имя заменяется атомарно
+constexpr std::string_view kShmDirectory = "/dev/shm";
+
+// Прежний регион по fd: читатели увидят Closed и переоткроют новый
+void mark_closed(int fd) {
+    struct stat info{};
+    if (::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(shm_session::Header)) {
+        void* mapping = ::mmap(nullptr, sizeof(shm_session::Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (mapping != MAP_FAILED) {
+            auto* header = static_cast<shm_session::Header*>(mapping);
+            if (header->magic == shm_session::kMagic) {
+                header->state.store(static_cast<uint32_t>(shm_session::State::Closed), std::memory_order_release);
+            }
+            ::munmap(mapping, sizeof(shm_session::Header));
+        }
+    }
+}
+
+// Регион, оставшийся от упавшего сервера
+void retire_existing(const std::string& name) {
+    const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) return;
+    mark_closed(fd);
+    ::close(fd);
+    ::shm_unlink(name.c_str());
+}
+
+} // namespace
+
+ShmSessionTable::ShmSessionTable(std::string name, size_t max_sessions, bool staged)
+    : name_(std::move(name)),
+      slot_count_(std::bit_ceil(std::max<uint64_t>(max_sessions, 1) * 2)) {
+    if (staged) {
+        staged_name_ = name_ + "." + std::to_string(::getpid());
+        ::shm_unlink(staged_name_.c_str());
+    } else {
+        retire_existing(name_);
+    }
+    const std::string& created = staged ? staged_name_ : name_;
+
+    const int fd = ::shm_open(created.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) {
+        throw shm_error("Cannot create shared memory", created);
+    }
+    const size_t size = shm_session::region_size(slot_count_);
+    if (::ftruncate(fd, static_cast<off_t>(size)) < 0) {
+        const auto error = shm_error("Cannot size shared memory", created);
+        ::close(fd);
+        ::shm_unlink(created.c_str());
+        throw error;
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) == 0) {
+        inode_ = static_cast<uint64_t>(info.st_ino);
+    }
+    // MAP_POPULATE: страницы выделяются здесь, а не первыми записями из UDP-потока
+    void* mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        const auto error = shm_error("Cannot map shared memory", created);
+        ::shm_unlink(created.c_str());
+        throw error;
+    }
+
+    // ftruncate обнуляет регион: все слоты пусты, state == Initializing
+    header_ = static_cast<shm_session::Header*>(mapping);
+    slots_ = shm_session::slots(header_);
+    header_->magic = shm_session::kMagic;
+    header_->layout_version = shm_session::kLayoutVersion;
+    header_->slot_size = sizeof(shm_session::Slot);
+    header_->slot_count = slot_count_;
+    header_->writer_pid = static_cast<uint32_t>(::getpid());
+    header_->generation.store(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count()), std::memory_order_relaxed);
+    header_->state.store(static_cast<uint32_t>(shm_session::State::Ready), std::memory_order_release);
+
+    Logger::get_logger()->info("Shared-memory session table {}: {} slots, {} MB",
+                               created, slot_count_, size >> 20);
+}
+
+ShmSessionTable::~ShmSessionTable() {
+    header_->state.store(static_cast<uint32_t>(shm_session::State::Closed), std::memory_order_release);
+    ::munmap(header_, shm_session::region_size(slot_count_));
+
+    if (!staged_name_.empty()) {
+        ::shm_unlink(staged_name_.c_str());
+        return;
+    }
+    // Имя мог уже занять новый процесс (передача работы): удаляется только свой регион
+    const int fd = ::shm_open(name_.c_str(), O_RDONLY, 0);
+    if (fd >= 0) {
+        struct stat info{};
+        const bool own = ::fstat(fd, &info) == 0 && static_cast<uint64_t>(info.st_ino) == inode_;
+        ::close(fd);
+        if (own) {
+            ::shm_unlink(name_.c_str());
+        }
+    }
+}
+
+void ShmSessionTable::publish() {
+    if (staged_name_.empty()) return;
+
+    // Прежний регион открыт до замены имени: Closed ставится уже после неё, и читатель,
+    // увидевший Closed, по reopen() попадает в новый
+    const int previous = ::shm_open(name_.c_str(), O_RDWR, 0);
+    const std::string from = std::string(kShmDirectory) + staged_name_;
+    const std::string to = std::string(kShmDirectory) + name_;
+    if (std::rename(from.c_str(), to.c_str()) != 0) {
+        const auto error = shm_error("Cannot publish shared memory", name_);
+        if (previous >= 0) ::close(previous);
+        throw error;
+    }
+    if (previous >= 0) {
+        mark_closed(previous);
+        ::close(previous);
+    }
+    staged_name_.clear();
+    Logger::get_logger()->info("Shared-memory session table {} published: {} sessions", name_, live_);
+}
+
+uint64_t ShmSessionTable::size() const noexcept {
+    return header_->live_count.load(std::memory_order_relaxed);
+}
+
+bool ShmSessionTable::overflowed() const noexcept {
+    return header_->state.load(std::memory_order_relaxed) == static_cast<uint32_t>(shm_session::State::Overflow);
+}
+
+void ShmSessionTable::write_slot(shm_session::Slot& slot, uint64_t key, int64_t expires_ns) noexcept {
+    const uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    slot.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.key.store(key, std::memory_order_relaxed);
+    slot.expires_ns.store(expires_ns, std::memory_order_relaxed);
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+void ShmSessionTable::upsert(Imsi imsi, std::chrono::steady_clock::time_point expires_at) {
+    if (overflowed() || imsi.empty()) return;
+
+    const uint64_t key = imsi.key();
+    const int64_t expires_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        expires_at.time_since_epoch()).count();
+    const uint64_t mask = slot_count_ - 1;
+
+    shm_session::Slot* free_slot = nullptr;
+    uint64_t index = shm_session::hash(key) & mask;
+    for (uint64_t probe = 0; probe <= mask; ++probe, index = (index + 1) & mask) {
+        shm_session::Slot& slot = slots_[index];
+        const uint64_t slot_key = slot.key.load(std::memory_order_relaxed);
+        if (slot_key == key) {
+            write_slot(slot, key, expires_ns);
+            return;
+        }
+        if (slot_key == shm_session::kTombstoneKey) {
+            if (!free_slot) free_slot = &slot;
+            continue;
+        }
+        if (slot_key == shm_session::kEmptyKey) {
+            if (!free_slot) free_slot = &slot;
+            break;
+        }
+    }
+
+    if (!free_slot) {
+        header_->state.store(static_cast<uint32_t>(shm_session::State::Overflow), std::memory_order_release);
+        Logger::get_logger()->error("Shared-memory session table {} is full, readers fall back to HTTP", name_);
+        return;
+    }
+    if (free_slot->key.load(std::memory_order_relaxed) == shm_session::kTombstoneKey) {
+        --tombstones_;
+    }
+    write_slot(*free_slot, key, expires_ns);
+    header_->live_count.store(++live_, std::memory_order_relaxed);
+
+    if ((live_ + tombstones_) * kMaxLoadDenominator > slot_count_ * kMaxLoadNumerator) {
+        rebuild();
+    }
+}
+
+void ShmSessionTable::erase(Imsi imsi) {
+    if (overflowed() || imsi.empty()) return;
+
+    const uint64_t key = imsi.key();
+    const uint64_t mask = slot_count_ - 1;
+    uint64_t index = shm_session::hash(key) & mask;
+    for (uint64_t probe = 0; probe <= mask; ++probe, index = (index + 1) & mask) {
+        shm_session::Slot& slot = slots_[index];
+        const uint64_t slot_key = slot.key.load(std::memory_order_relaxed);
+        if (slot_key == shm_session::kEmptyKey) return;
+        if (slot_key != key) continue;
+
+        // Цепочка обрывается на следующем слоте - надгробие не нужно
+        const bool chain_ends = slots_[(index + 1) & mask].key.load(std::memory_order_relaxed) == shm_session::kEmptyKey;
+        write_slot(slot, chain_ends ? shm_session::kEmptyKey : shm_session::kTombstoneKey, 0);
+        if (!chain_ends) ++tombstones_;
+        header_->live_count.store(--live_, std::memory_order_relaxed);
+        return;
+    }
+}
+
+// Перестроение на месте: читатели видят нечётный table_seq и повторяют поиск
+void ShmSessionTable::rebuild() {
+    std::vector<std::pair<uint64_t, int64_t>> live;
+    live.reserve(live_);
+    for (uint64_t i = 0; i < slot_count_; ++i) {
+        const uint64_t key = slots_[i].key.load(std::memory_order_relaxed);
+        if (key != shm_session::kEmptyKey && key != shm_session::kTombstoneKey) {
+            live.emplace_back(key, slots_[i].expires_ns.load(std::memory_order_relaxed));
+        }
+    }
+
+    const uint64_t table_seq = header_->table_seq.load(std::memory_order_relaxed);
+    header_->table_seq.store(table_seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (uint64_t i = 0; i < slot_count_; ++i) {
+        if (slots_[i].key.load(std::memory_order_relaxed) != shm_session::kEmptyKey) {
+            write_slot(slots_[i], shm_session::kEmptyKey, 0);
+        }
+    }
+    const uint64_t mask = slot_count_ - 1;
+    for (const auto& [key, expires_ns] : live) {
+        uint64_t index = shm_session::hash(key) & mask;
+        while (slots_[index].key.load(std::memory_order_relaxed) != shm_session::kEmptyKey) {
+            index = (index + 1) & mask;
+        }
+        write_slot(slots_[index], key, expires_ns);
+    }
+    tombstones_ = 0;
+
+    header_->table_seq.store(table_seq + 2, std::memory_order_release);
+
+    // Таблица заполнена живыми сессиями сверх расчётной ёмкости
+    if (live_ * kMaxLoadDenominator > slot_count_ * kMaxLoadNumerator) {
+        header_->state.store(static_cast<uint32_t>(shm_session::State::Overflow), std::memory_order_release);
+        Logger::get_logger()->error("Shared-memory session table {} exceeded its capacity ({} sessions), "
+                                    "readers fall back to HTTP", name_, live_);
+    }
+}
@@ -0,0 +1,407 @@
+#include "utils/bcd_batch.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PGW_BCD_X86 1
+#endif
+
+namespace {
+
+constexpr size_t kSlot = ImsiBatch::kDigitSlot;
+constexpr size_t kBcd = ImsiBatch::kBcdSlot;
+constexpr unsigned kMinLength = 10;
+constexpr unsigned kMaxLength = 15;
+
+bool length_ok(unsigned length) noexcept {
+    return length >= kMinLength && length <= kMaxLength;
+}
+
+// ---------------------------------------------------------------- scalar
+
+void validate_scalar(const char* digits, const uint8_t* lengths, size_t count, uint8_t* valid) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        const char* slot = digits + i * kSlot;
+        const unsigned length = lengths[i];
+        // Без ветвлений по цифрам: слот фиксированной длины
+        unsigned bad = 0;
+        for (unsigned d = 0; d < kSlot; ++d) {
+            bad |= static_cast<unsigned>(d < length) & static_cast<unsigned>(static_cast<unsigned char>(slot[d] - '0') > 9);
+        }
+        valid[i] = length_ok(length) && bad == 0;
+    }
+}
+
+void encode_scalar(const char* digits, const uint8_t* lengths, size_t count, uint8_t* bcd) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        const char* slot = digits + i * kSlot;
+        const unsigned length = lengths[i];
+        uint8_t* out = bcd + i * kBcd;
+        for (unsigned b = 0; b < kBcd; ++b) {
+            const unsigned lo = 2 * b < length ? static_cast<unsigned>(slot[2 * b] - '0') : 0xF;
+            const unsigned hi = 2 * b + 1 < length ? static_cast<unsigned>(slot[2 * b + 1] - '0') : 0xF;
+            out[b] = static_cast<uint8_t>(lo | (hi << 4));
+        }
+    }
+}
+
+void pack_keys_scalar(const char* digits, const uint8_t* lengths, size_t count, uint64_t* keys) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        const char* slot = digits + i * kSlot;
+        const unsigned length = lengths[i];
+        uint64_t value = 0;
+        for (unsigned d = 0; d < length; ++d) {
+            value = value * 10 + static_cast<uint64_t>(slot[d] - '0');
+        }
+        keys[i] = (value << 4) | length;
+    }
+}
+
+void decode_scalar(const uint8_t* bcd, size_t count, char* digits, uint8_t* lengths) noexcept {
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* in = bcd + i * kBcd;
+        char* slot = digits + i * kSlot;
+        std::memset(slot, 0, kSlot);
+
+        unsigned length = 0;
+        bool ok = true;
+        for (unsigned n = 0; n < 2 * kBcd; ++n) {
+            const unsigned nibble = n % 2 == 0 ? in[n / 2] & 0x0F : in[n / 2] >> 4;
+            if (nibble == 0xF) break;
+            if (nibble > 9) { ok = false; break; }
+            slot[length++] = static_cast<char>('0' + nibble);
+        }
+        if (!ok || !length_ok(length)) {
+            std::memset(slot, 0, kSlot);
+            length = 0;
+        }
+        lengths[i] = static_cast<uint8_t>(length);
+    }
+}
+
+#ifdef PGW_BCD_X86
+
+// ---------------------------------------------------------------- SSE4.1
+
+__attribute__((target("sse4.1")))
+inline __m128i position_mask_sse(unsigned length) noexcept {
+    // 0xFF в байтах с индексом < length
+    const __m128i index = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    return _mm_cmplt_epi8(index, _mm_set1_epi8(static_cast<char>(length)));
+}
+
+__attribute__((target("sse4.1")))
+void validate_sse41(const char* digits, const uint8_t* lengths, size_t count, uint8_t* valid) noexcept {
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    for (size_t i = 0; i < count; ++i) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(digits + i * kSlot));
+        const __m128i value = _mm_sub_epi8(v, zero);
+        const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(value, nine), value);
+        // За пределами длины любой байт допустим
+        const __m128i ok = _mm_or_si128(is_digit, _mm_andnot_si128(position_mask_sse(lengths[i]), _mm_set1_epi8(-1)));
+        valid[i] = length_ok(lengths[i]) && _mm_test_all_ones(ok);
+    }
+}
+
+__attribute__((target("sse4.1")))
+void encode_sse41(const char* digits, const uint8_t* lengths, size_t count, uint8_t* bcd) noexcept {
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i filler = _mm_set1_epi8(0x0F);
+    const __m128i weights = _mm_set1_epi16(0x1001);   // чётная цифра * 1 + нечётная * 16
+    for (size_t i = 0; i < count; ++i) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(digits + i * kSlot));
+        const __m128i nibbles = _mm_blendv_epi8(filler, _mm_sub_epi8(v, zero), position_mask_sse(lengths[i]));
+        const __m128i pairs = _mm_maddubs_epi16(nibbles, weights);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(bcd + i * kBcd), _mm_packus_epi16(pairs, pairs));
+    }
+}
+
+__attribute__((target("sse4.1")))
+void decode_sse41(const uint8_t* bcd, size_t count, char* digits, uint8_t* lengths) noexcept {
+    const __m128i low_nibble = _mm_set1_epi8(0x0F);
+    const __m128i nine = _mm_set1_epi8(9);
+    for (size_t i = 0; i < count; ++i) {
+        const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(bcd + i * kBcd));
+        const __m128i lo = _mm_and_si128(bytes, low_nibble);
+        const __m128i hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), low_nibble);
+        const __m128i nibbles = _mm_unpacklo_epi8(lo, hi);
+
+        const unsigned terminators = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(nibbles, low_nibble)));
+        const unsigned length = static_cast<unsigned>(__builtin_ctz(terminators | 0x10000));
+        const unsigned in_number = (1u << length) - 1;
+        const unsigned bad = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpgt_epi8(nibbles, nine))) & in_number;
+
+        const bool ok = bad == 0 && length_ok(length);
+        const __m128i ascii = _mm_and_si128(_mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+                                            position_mask_sse(ok ? length : 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(digits + i * kSlot), ascii);
+        lengths[i] = static_cast<uint8_t>(ok ? length : 0);
+    }
+}
+
+// Управляющий вектор pshufb на каждую длину: цифры сдвигаются к правому краю слота,
+// старшие позиции обнуляются (0x80). Выровненные 16 цифр - число с ведущими нулями
+constexpr auto kAlignRight = [] {
+    std::array<std::array<int8_t, kSlot>, kSlot + 1> table{};
+    for (unsigned length = 0; length <= kSlot; ++length) {
+        for (unsigned j = 0; j < kSlot; ++j) {
+            const int source = static_cast<int>(j + length) - static_cast<int>(kSlot);
+            table[length][j] = static_cast<int8_t>(source < 0 ? -128 : source);
+        }
+    }
+    return table;
+}();
+
+inline const void* align_right(unsigned length) noexcept {
+    return kAlignRight[length].data();
+}
+
+// Цифры по 2 -> по 4 -> по 8: два 32-битных числа в младших элементах, старшая часть первой
+__attribute__((target("sse4.1")))
+inline __m128i eight_digit_halves_sse(__m128i aligned) noexcept {
+    const __m128i pairs = _mm_maddubs_epi16(aligned, _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1));
+    const __m128i quads = _mm_madd_epi16(pairs, _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1));
+    const __m128i packed = _mm_packus_epi32(quads, quads);
+    return _mm_madd_epi16(packed, _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1));
+}
+
+__attribute__((target("sse4.1")))
+inline uint64_t join_halves_sse(__m128i halves) noexcept {
+    const auto high = static_cast<uint32_t>(_mm_cvtsi128_si32(halves));
+    const auto low = static_cast<uint32_t>(_mm_extract_epi32(halves, 1));
+    return high * 100'000'000ULL + low;
+}
+
+__attribute__((target("sse4.1")))
+void pack_keys_sse41(const char* digits, const uint8_t* lengths, size_t count, uint64_t* keys) noexcept {
+    const __m128i zero = _mm_set1_epi8('0');
+    for (size_t i = 0; i < count; ++i) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(digits + i * kSlot));
+        const __m128i control = _mm_loadu_si128(static_cast<const __m128i*>(align_right(lengths[i])));
+        const __m128i aligned = _mm_shuffle_epi8(_mm_sub_epi8(v, zero), control);
+        keys[i] = (join_halves_sse(eight_digit_halves_sse(aligned)) << 4) | lengths[i];
+    }
+}
+
+// ---------------------------------------------------------------- AVX2
+
+__attribute__((target("avx2")))
+inline __m256i position_mask_avx2(unsigned length0, unsigned length1) noexcept {
+    const __m256i index = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+                                           0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m256i limit = _mm256_setr_m128i(_mm_set1_epi8(static_cast<char>(length0)),
+                                            _mm_set1_epi8(static_cast<char>(length1)));
+    return _mm256_cmpgt_epi8(limit, index);
+}
+
+__attribute__((target("avx2")))
+void validate_avx2(const char* digits, const uint8_t* lengths, size_t count, uint8_t* valid) noexcept {
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(digits + i * kSlot));
+        const __m256i value = _mm256_sub_epi8(v, zero);
+        const __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(value, nine), value);
+        const __m256i ok = _mm256_or_si256(is_digit,
+            _mm256_xor_si256(position_mask_avx2(lengths[i], lengths[i + 1]), _mm256_set1_epi8(-1)));
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(ok));
+        valid[i] = length_ok(lengths[i]) && (mask & 0xFFFF) == 0xFFFF;
+        valid[i + 1] = length_ok(lengths[i + 1]) && (mask >> 16) == 0xFFFF;
+    }
+    validate_sse41(digits + i * kSlot, lengths + i, count - i, valid + i);
+}
+
+__attribute__((target("avx2")))
+void encode_avx2(const char* digits, const uint8_t* lengths, size_t count, uint8_t* bcd) noexcept {
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i filler = _mm256_set1_epi8(0x0F);
+    const __m256i weights = _mm256_set1_epi16(0x1001);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(digits + i * kSlot));
+        const __m256i nibbles = _mm256_blendv_epi8(filler, _mm256_sub_epi8(v, zero),
+                                                   position_mask_avx2(lengths[i], lengths[i + 1]));
+        const __m256i pairs = _mm256_maddubs_epi16(nibbles, weights);
+        // packus работает внутри 128-битных половин: слот 0 - байты 0..7, слот 1 - 16..23
+        const __m256i packed = _mm256_packus_epi16(pairs, pairs);
+        const __m128i both = _mm_unpacklo_epi64(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(bcd + i * kBcd), both);
+    }
+    encode_sse41(digits + i * kSlot, lengths + i, count - i, bcd + i * kBcd);
+}
+
+__attribute__((target("avx2")))
+void pack_keys_avx2(const char* digits, const uint8_t* lengths, size_t count, uint64_t* keys) noexcept {
+    const __m256i zero = _mm256_set1_epi8('0');
+    const __m256i tens = _mm256_set1_epi16(0x010A);          // байты 10, 1
+    const __m256i hundreds = _mm256_set1_epi32(0x00010064);  // слова 100, 1
+    const __m256i ten_thousands = _mm256_set1_epi32(0x00012710);   // слова 10000, 1
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(digits + i * kSlot));
+        const __m256i control = _mm256_setr_m128i(
+            _mm_loadu_si128(static_cast<const __m128i*>(align_right(lengths[i]))),
+            _mm_loadu_si128(static_cast<const __m128i*>(align_right(lengths[i + 1]))));
+        // pshufb, madd и packus работают внутри 128-битных половин: по слоту на половину
+        const __m256i aligned = _mm256_shuffle_epi8(_mm256_sub_epi8(v, zero), control);
+        const __m256i pairs = _mm256_maddubs_epi16(aligned, tens);
+        const __m256i quads = _mm256_madd_epi16(pairs, hundreds);
+        const __m256i packed = _mm256_packus_epi32(quads, quads);
+        const __m256i halves = _mm256_madd_epi16(packed, ten_thousands);
+        keys[i] = (join_halves_sse(_mm256_castsi256_si128(halves)) << 4) | lengths[i];
+        keys[i + 1] = (join_halves_sse(_mm256_extracti128_si256(halves, 1)) << 4) | lengths[i + 1];
+    }
+    pack_keys_sse41(digits + i * kSlot, lengths + i, count - i, keys + i);
+}
+
+__attribute__((target("avx2")))
+void decode_avx2(const uint8_t* bcd, size_t count, char* digits, uint8_t* lengths) noexcept {
+    const __m256i low_nibble = _mm256_set1_epi16(0x0F);
+    const __m256i nibble_f = _mm256_set1_epi8(0x0F);
+    const __m256i nine = _mm256_set1_epi8(9);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        // Каждый байт BCD -> 16 бит: младший байт - младший нибл, старший - старший;
+        // в памяти это и есть порядок цифр, слот 0 в младшей половине, слот 1 - в старшей
+        const __m256i words = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bcd + i * kBcd)));
+        const __m256i nibbles = _mm256_or_si256(_mm256_and_si256(words, low_nibble),
+                                                _mm256_slli_epi16(_mm256_srli_epi16(words, 4), 8));
+
+        const unsigned terminators = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(nibbles, nibble_f)));
+        const unsigned over_nine = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(nibbles, nine)));
+
+        unsigned length[2];
+        for (unsigned s = 0; s < 2; ++s) {
+            const unsigned term = (terminators >> (16 * s)) & 0xFFFF;
+            const unsigned len = static_cast<unsigned>(__builtin_ctz(term | 0x10000));
+            const unsigned bad = (over_nine >> (16 * s)) & ((1u << len) - 1);
+            length[s] = bad == 0 && length_ok(len) ? len : 0;
+        }
+
+        const __m256i ascii = _mm256_and_si256(_mm256_add_epi8(nibbles, _mm256_set1_epi8('0')),
+                                               position_mask_avx2(length[0], length[1]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(digits + i * kSlot), ascii);
+        lengths[i] = static_cast<uint8_t>(length[0]);
+        lengths[i + 1] = static_cast<uint8_t>(length[1]);
+    }
+    decode_sse41(bcd + i * kBcd, count - i, digits + i * kSlot, lengths + i);
+}
+
+#endif // PGW_BCD_X86
+
+BCDBatch::Isa supported(BCDBatch::Isa requested) noexcept {
+    return std::min(requested, BCDBatch::best_isa());
+}
+
+} // namespace
+
+void ImsiBatch::resize(size_t count) {
+    digits.resize(count * kDigitSlot);
+    lengths.resize(count);
+}
+
+void ImsiBatch::push_back(std::string_view imsi) {
+    const size_t copied = std::min(imsi.size(), kDigitSlot);
+    const size_t offset = digits.size();
+    digits.resize(offset + kDigitSlot, 0);
+    std::memcpy(digits.data() + offset, imsi.data(), copied);
+    lengths.push_back(static_cast<uint8_t>(copied));
+}
+
+BCDBatch::Isa BCDBatch::best_isa() noexcept {
+#ifdef PGW_BCD_X86
+    static const Isa isa = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return Isa::Avx2;
+        if (__builtin_cpu_supports("sse4.1")) return Isa::Sse41;
+        return Isa::Scalar;
+    }();
+    return isa;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+const char* BCDBatch::isa_name(Isa isa) noexcept {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::Sse41: return "sse4.1";
+        case Isa::Avx2: return "avx2";
+    }
+    return "unknown";
+}
+
+void BCDBatch::validate(const ImsiBatch& batch, uint8_t* valid, Isa isa) noexcept {
+    switch (supported(isa)) {
+#ifdef PGW_BCD_X86
+        case Isa::Avx2: return validate_avx2(batch.digits.data(), batch.lengths.data(), batch.size(), valid);
+        case Isa::Sse41: return validate_sse41(batch.digits.data(), batch.lengths.data(), batch.size(), valid);
+#endif
+        default: return validate_scalar(batch.digits.data(), batch.lengths.data(), batch.size(), valid);
+    }
+}
+
+void BCDBatch::encode(const ImsiBatch& batch, uint8_t* bcd, Isa isa) noexcept {
+    switch (supported(isa)) {
+#ifdef PGW_BCD_X86
+        case Isa::Avx2: return encode_avx2(batch.digits.data(), batch.lengths.data(), batch.size(), bcd);
+        case Isa::Sse41: return encode_sse41(batch.digits.data(), batch.lengths.data(), batch.size(), bcd);
+#endif
+        default: return encode_scalar(batch.digits.data(), batch.lengths.data(), batch.size(), bcd);
+    }
+}
+
+void BCDBatch::pack_keys(const ImsiBatch& batch, uint64_t* keys, Isa isa) noexcept {
+    switch (supported(isa)) {
+#ifdef PGW_BCD_X86
+        case Isa::Avx2: return pack_keys_avx2(batch.digits.data(), batch.lengths.data(), batch.size(), keys);
+        case Isa::Sse41: return pack_keys_sse41(batch.digits.data(), batch.lengths.data(), batch.size(), keys);
+#endif
+        default: return pack_keys_scalar(batch.digits.data(), batch.lengths.data(), batch.size(), keys);
+    }
+}
+
+std::vector<Imsi> BCDBatch::parse(std::span<const std::string> texts, Isa isa) {
+    // Слоты размечаются одним resize (хвосты нулевые), как в push_back
+    ImsiBatch batch;
+    batch.resize(texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        const size_t copied = std::min(texts[i].size(), ImsiBatch::kDigitSlot);
+        std::memcpy(batch.digits.data() + i * ImsiBatch::kDigitSlot, texts[i].data(), copied);
+        batch.lengths[i] = static_cast<uint8_t>(copied);
+    }
+
+    std::vector<uint8_t> valid(batch.size());
+    validate(batch, valid.data(), isa);
+    std::vector<uint64_t> keys(batch.size());
+    pack_keys(batch, keys.data(), isa);
+
+    // Цифры и длина уже проверены: from_key не разбирает строку второй раз
+    std::vector<Imsi> imsis(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (valid[i]) {
+            imsis[i] = Imsi::from_key(keys[i]).value_or(Imsi{});
+        }
+    }
+    return imsis;
+}
+
+void BCDBatch::decode(const uint8_t* bcd, size_t count, ImsiBatch& out, Isa isa) {
+    out.resize(count);
+    switch (supported(isa)) {
+#ifdef PGW_BCD_X86
+        case Isa::Avx2: return decode_avx2(bcd, count, out.digits.data(), out.lengths.data());
+        case Isa::Sse41: return decode_sse41(bcd, count, out.digits.data(), out.lengths.data());
+#endif
+        default: return decode_scalar(bcd, count, out.digits.data(), out.lengths.data());
+    }
+}
+
+void BCDBatch::to_bcd_slot(const uint8_t* data, size_t size, uint8_t* slot) noexcept {
+    const size_t copied = std::min(size, ImsiBatch::kBcdSlot);
+    std::memcpy(slot, data, copied);
+    std::memset(slot + copied, 0xFF, ImsiBatch::kBcdSlot - copied);
+}
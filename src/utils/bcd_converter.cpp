@@ -1,4 +1,5 @@
 #include "utils/bcd_converter.h"
+#include "utils/imsi.h"
 #include <stdexcept>
 #include <algorithm>
 
@@ -55,8 +56,7 @@ std::string BCDConverter::bcd_to_imsi(const std::vector<uint8_t>& bcd_data) {
 }
 
 bool BCDConverter::validate_imsi(std::string_view imsi) noexcept {
-    return imsi.length() >= 10 && imsi.length() <= 15 &&
-        std::all_of(imsi.begin(), imsi.end(), ::isdigit);
+    return Imsi::parse(imsi).has_value();
 }
 
 
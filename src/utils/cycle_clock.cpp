@@ -0,0 +1,29 @@
+#include "utils/cycle_clock.h"
+#include <thread>
+
+namespace {
+
+double calibrate() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    const auto wall_start = std::chrono::steady_clock::now();
+    const uint64_t ticks_start = CycleClock::now();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    const auto wall_end = std::chrono::steady_clock::now();
+    const uint64_t ticks_end = CycleClock::now();
+
+    const double nanos = std::chrono::duration<double, std::nano>(wall_end - wall_start).count();
+    const double ticks = static_cast<double>(ticks_end - ticks_start);
+    return ticks > 0 ? nanos / ticks : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
+} // namespace
+
+double CycleClock::nanos_per_tick() noexcept {
+    static const double ratio = calibrate();
+    return ratio;
+}
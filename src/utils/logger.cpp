@@ -2,12 +2,14 @@
 #include <stdexcept>
 
 std::shared_ptr<spdlog::logger> Logger::logger_;
+std::shared_ptr<spdlog::details::thread_pool> Logger::thread_pool_;
 
 void Logger::init(
     const std::string& log_file,
     const std::string& logger_name,
     const std::string& log_level,
-    bool console_output
+    bool console_output,
+    const LogOptions& options
 ) {
     try {
         std::vector<spdlog::sink_ptr> sinks;
@@ -28,18 +30,43 @@ void Logger::init(
             throw std::runtime_error("No log sinks configured");
         }
 
-        logger_ = std::make_shared<spdlog::logger>(logger_name, sinks.begin(), sinks.end());
+        if (options.async) {
+            if (options.queue_size == 0) {
+                throw std::invalid_argument("Log queue size must be positive");
+            }
+            // Один поток-писатель: порядок сообщений сохраняется
+            thread_pool_ = std::make_shared<spdlog::details::thread_pool>(options.queue_size, 1);
+            logger_ = std::make_shared<spdlog::async_logger>(logger_name, sinks.begin(), sinks.end(), thread_pool_,
+                options.drop_on_overflow ? spdlog::async_overflow_policy::overrun_oldest
+                                         : spdlog::async_overflow_policy::block);
+        } else {
+            logger_ = std::make_shared<spdlog::logger>(logger_name, sinks.begin(), sinks.end());
+        }
 
         logger_->set_level(parse_level(log_level));
-        logger_->flush_on(spdlog::level::trace);
+        logger_->flush_on(parse_level(options.flush_level));
 
         spdlog::register_logger(logger_);
+        spdlog::flush_every(std::chrono::seconds(options.flush_interval_sec));
         
     } catch (const spdlog::spdlog_ex& ex) {
         throw std::runtime_error(std::string("Logger initialization failed: ") + ex.what());
     }
 }
 
+void Logger::shutdown() {
+    if (!logger_) return;
+    logger_->flush();
+    spdlog::drop(logger_->name());
+    logger_.reset();
+    // Деструктор пула дожидается записи всей очереди
+    thread_pool_.reset();
+}
+
+uint64_t Logger::dropped_messages() {
+    return thread_pool_ ? thread_pool_->overrun_counter() : 0;
+}
+
 spdlog::level::level_enum Logger::parse_level(const std::string& level) {
     if (level == "TRACE") return spdlog::level::trace; 
     if (level == "DEBUG") return spdlog::level::debug;
@@ -0,0 +1,57 @@
+#include "utils/rcu.h"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<Rcu::ReaderSlot*> slots;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();  // не разрушается: потоки могут завершаться после main
+    return *instance;
+}
+
+struct SlotHandle {
+    Rcu::ReaderSlot* slot;
+
+    SlotHandle() : slot(new Rcu::ReaderSlot()) {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.slots.push_back(slot);
+    }
+
+    ~SlotHandle() {
+        auto& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.slots.erase(std::find(reg.slots.begin(), reg.slots.end(), slot));
+        delete slot;
+    }
+};
+
+} // namespace
+
+Rcu::ReaderSlot& Rcu::local_slot() noexcept {
+    thread_local SlotHandle handle;
+    return *handle.slot;
+}
+
+void Rcu::synchronize() {
+    // Обмен указателя у вызывающего уже произошёл (seq_cst): читатель, чей слот
+    // здесь ещё 0, прочитает указатель позже и увидит новый объект
+    const uint64_t target = global_epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+
+    auto& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    for (const auto* slot : reg.slots) {
+        for (;;) {
+            const uint64_t epoch = slot->epoch.load(std::memory_order_seq_cst);
+            if (epoch == 0 || epoch >= target) break;
+            std::this_thread::yield();
+        }
+    }
+}
@@ -16,11 +16,14 @@ build/bin/pgw_server "configs/load_test_server_config.json" &
 SERVER_PID=$!
 sleep 2
 
-build/bin/mass_test "configs/load_test_client_config.json" 100 0
+build/bin/load_generator "configs/load_test_client_config.json" 1000 5
 
 
 echo "Stopping server..."
 kill -TERM "$SERVER_PID" || kill -9 "$SERVER_PID"
 wait "$SERVER_PID" 2>/dev/null
 
-exit 0
\ No newline at end of file
+# Регрессия производительности относительно базового уровня - ненулевой код выхода
+build/bin/perf_harness build/bin/pgw_server "configs/perf_server_config.json" \
+    "tests/load/perf_baseline.json" "$BUILD_DIR/perf_results.json"
+exit $?
\ No newline at end of file
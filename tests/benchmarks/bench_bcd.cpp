@@ -0,0 +1,103 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "bench_common.h"
+#include "utils/bcd_converter.h"
+
+namespace {
+
+// Набор меньше L1: меряется код преобразования, а не промахи кэша
+constexpr size_t kPoolSize = 1024;
+
+const std::vector<std::string>& imsi_pool() {
+    static const std::vector<std::string> pool = [] {
+        std::vector<std::string> imsis;
+        for (size_t i = 0; i < kPoolSize; ++i) {
+            imsis.push_back(bench::imsi_string(i * 7919));
+        }
+        return imsis;
+    }();
+    return pool;
+}
+
+const std::vector<std::vector<uint8_t>>& bcd_pool() {
+    static const std::vector<std::vector<uint8_t>> pool = [] {
+        std::vector<std::vector<uint8_t>> bcds;
+        for (const auto& imsi : imsi_pool()) {
+            bcds.push_back(BCDConverter::imsi_to_bcd(imsi));
+        }
+        return bcds;
+    }();
+    return pool;
+}
+
+void BM_BcdEncode(benchmark::State& state) {
+    const auto& imsis = imsi_pool();
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(BCDConverter::imsi_to_bcd(imsis[i++ % kPoolSize]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BcdEncode);
+
+void BM_BcdDecode(benchmark::State& state) {
+    const auto& bcds = bcd_pool();
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(BCDConverter::bcd_to_imsi(bcds[i++ % kPoolSize]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BcdDecode);
+
+// Аргумент 1 - каждый второй IMSI с нецифровым символом
+void BM_BcdValidate(benchmark::State& state) {
+    std::vector<std::string> imsis = imsi_pool();
+    if (state.range(0) != 0) {
+        for (size_t i = 0; i < imsis.size(); i += 2) {
+            imsis[i][imsis[i].size() / 2] = 'x';
+        }
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(BCDConverter::validate_imsi(imsis[i++ % kPoolSize]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BcdValidate)->ArgName("invalid")->Arg(0)->Arg(1);
+
+// Тип Imsi для сравнения: разбор и BCD без выделения памяти
+void BM_ImsiParse(benchmark::State& state) {
+    const auto& imsis = imsi_pool();
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Imsi::parse(imsis[i++ % kPoolSize]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ImsiParse);
+
+void BM_ImsiToBcd(benchmark::State& state) {
+    const auto imsis = bench::make_imsis(0, kPoolSize);
+    uint8_t out[Imsi::kMaxBcdBytes];
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(imsis[i++ % kPoolSize].to_bcd(out));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ImsiToBcd);
+
+void BM_ImsiFromBcd(benchmark::State& state) {
+    const auto& bcds = bcd_pool();
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Imsi::from_bcd(bcds[i++ % kPoolSize]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ImsiFromBcd);
+
+} // namespace
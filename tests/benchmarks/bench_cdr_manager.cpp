@@ -0,0 +1,32 @@
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include "bench_common.h"
+#include "cdr/cdr_manager.h"
+
+namespace {
+
+std::unique_ptr<CdrManager> shared_cdr;
+std::filesystem::path cdr_path;
+
+// Постановка записи в очередь (форматирование + мьютекс) параллельно с потоком записи
+void BM_CdrAddRecord(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        cdr_path = std::filesystem::temp_directory_path() / "pgw_benchmarks_cdr.log";
+        std::filesystem::remove(cdr_path);
+        shared_cdr = std::make_unique<CdrManager>(cdr_path.string());
+    }
+    bench::ImsiSequence imsis(static_cast<uint64_t>(state.thread_index()) * 100'000'000);
+    for (auto _ : state) {
+        shared_cdr->add_record(imsis.next(), "created");
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        shared_cdr.reset();
+        std::filesystem::remove(cdr_path);
+    }
+}
+BENCHMARK(BM_CdrAddRecord)->ThreadRange(1, bench::max_threads())->UseRealTime();
+
+} // namespace
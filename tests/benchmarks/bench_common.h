@@ -0,0 +1,65 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "cdr/cdr_manager.h"
+#include "test_imsi.h"
+
+// Общие помощники микробенчмарков pgw_benchmarks
+
+namespace bench {
+
+// Потоков в многопоточных вариантах: 1, 2, 4, ... до числа ядер (не меньше 2)
+inline int max_threads() {
+    return static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+}
+
+using ::imsi_string;
+using ::make_imsi;
+
+inline std::vector<Imsi> make_imsis(uint64_t first, size_t count) {
+    std::vector<Imsi> imsis;
+    imsis.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        imsis.push_back(make_imsi(first + i));
+    }
+    return imsis;
+}
+
+// Последовательные IMSI без форматирования на каждый шаг: для циклов, где каждый
+// IMSI должен быть новым, а заранее подготовленного массива может не хватить
+class ImsiSequence {
+public:
+    explicit ImsiSequence(uint64_t first) {
+        const std::string text = imsi_string(first);
+        std::copy(text.begin(), text.end(), digits_);
+    }
+
+    Imsi next() noexcept {
+        const Imsi imsi = *Imsi::parse(std::string_view(digits_, Imsi::kMaxLength));
+        for (size_t i = Imsi::kMaxLength; i-- > 5;) {
+            if (digits_[i] != '9') {
+                ++digits_[i];
+                break;
+            }
+            digits_[i] = '0';
+        }
+        return imsi;
+    }
+
+private:
+    char digits_[Imsi::kMaxLength];
+};
+
+// CDR без записи: бенчмарки таблицы сессий не должны мерить очередь CDR
+class NullCdrManager : public CdrManager {
+public:
+    NullCdrManager() : CdrManager("/dev/null") {}
+    void add_record(Imsi, std::string_view) override {}
+    void flush() override {}
+};
+
+} // namespace bench
@@ -0,0 +1,148 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "bench_common.h"
+#include <unistd.h>
+#include "session/session_manager.h"
+#include "session/shm_session_reader.h"
+#include "session/shm_session_table.h"
+
+namespace {
+
+constexpr int kTimeoutSec = 300;
+constexpr uint64_t kThreadStride = 100'000'000;   // свой диапазон номеров у каждого потока
+constexpr size_t kLookupTableSize = 100'000;
+
+std::unique_ptr<SessionManager> make_manager(int timeout_sec, const std::vector<std::string>& blacklist = {}) {
+    return std::make_unique<SessionManager>(std::make_shared<bench::NullCdrManager>(), timeout_sec, blacklist);
+}
+
+// Общая таблица многопоточных вариантов: создаёт и удаляет поток 0, остальные потоки
+// обращаются к ней только внутри цикла (до и после цикла у потоков барьер)
+std::unique_ptr<SessionManager> shared_manager;
+std::vector<Imsi> shared_imsis;
+
+// Только новые сессии: вставка в таблицу под эксклюзивной блокировкой
+void BM_CreateSession(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        shared_manager = make_manager(kTimeoutSec);
+    }
+    bench::ImsiSequence imsis(static_cast<uint64_t>(state.thread_index()) * kThreadStride);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(shared_manager->create_session(imsis.next()));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        shared_manager.reset();
+    }
+}
+BENCHMARK(BM_CreateSession)->ThreadRange(1, bench::max_threads())->UseRealTime();
+
+// Повторный attach существующих абонентов: продление и рост очереди истечения
+void BM_ProlongSession(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        shared_manager = make_manager(kTimeoutSec);
+        shared_imsis = bench::make_imsis(0, kLookupTableSize);
+        for (const Imsi imsi : shared_imsis) {
+            shared_manager->create_session(imsi);
+        }
+    }
+    size_t i = static_cast<size_t>(state.thread_index()) * 7919;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(shared_manager->create_session(shared_imsis[i++ % kLookupTableSize]));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        shared_manager.reset();
+    }
+}
+BENCHMARK(BM_ProlongSession)->ThreadRange(1, bench::max_threads())->UseRealTime();
+
+// Половина запросов - существующие сессии, половина - неизвестные IMSI
+void BM_SessionExists(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        shared_manager = make_manager(kTimeoutSec);
+        shared_imsis = bench::make_imsis(0, 2 * kLookupTableSize);
+        for (size_t i = 0; i < kLookupTableSize; ++i) {
+            shared_manager->create_session(shared_imsis[2 * i]);
+        }
+    }
+    size_t i = static_cast<size_t>(state.thread_index()) * 7919;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(shared_manager->session_exists(shared_imsis[i++ % shared_imsis.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        shared_manager.reset();
+    }
+}
+BENCHMARK(BM_SessionExists)->ThreadRange(1, bench::max_threads())->UseRealTime();
+
+// То же через ShmSessionReader: поиск локального процесса в зеркале таблицы без блокировок
+std::unique_ptr<ShmSessionReader> shared_reader;
+
+void BM_ShmSessionLookup(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        const std::string name = "/pgw_bench_sessions_" + std::to_string(::getpid());
+        shared_manager = std::make_unique<SessionManager>(
+            std::make_shared<bench::NullCdrManager>(), kTimeoutSec, std::vector<std::string>{}, nullptr,
+            std::make_shared<ShmSessionTable>(name, kLookupTableSize));
+        shared_imsis = bench::make_imsis(0, 2 * kLookupTableSize);
+        for (size_t i = 0; i < kLookupTableSize; ++i) {
+            shared_manager->create_session(shared_imsis[2 * i]);
+        }
+        shared_reader = std::make_unique<ShmSessionReader>(name);
+    }
+    size_t i = static_cast<size_t>(state.thread_index()) * 7919;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(shared_reader->lookup(shared_imsis[i++ % shared_imsis.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        shared_reader.reset();
+        shared_manager.reset();
+    }
+}
+BENCHMARK(BM_ShmSessionLookup)->ThreadRange(1, bench::max_threads())->UseRealTime();
+
+// Один проход очистки по очереди из range(0) истёкших сессий (таймаут 0: сессия
+// истекает сразу). Таблица заполняется вне замера
+void BM_CleanupExpiredSessions(benchmark::State& state) {
+    const auto backlog = static_cast<size_t>(state.range(0));
+    const auto imsis = bench::make_imsis(0, backlog);
+    auto manager = make_manager(0);
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (const Imsi imsi : imsis) {
+            manager->create_session(imsi);
+        }
+        state.ResumeTiming();
+        manager->cleanup_expired_sessions();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(backlog));
+}
+BENCHMARK(BM_CleanupExpiredSessions)
+    ->Arg(10'000)->Arg(100'000)->Arg(1'000'000)
+    ->Iterations(5)->Unit(benchmark::kMillisecond);
+
+// Проверка чёрного списка при range(0) записях; половина запросов попадает в список
+void BM_BlacklistLookup(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    std::vector<std::string> blacklist;
+    blacklist.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        blacklist.push_back(bench::imsi_string(2 * i));
+    }
+    const auto manager = make_manager(kTimeoutSec, blacklist);
+    const auto probes = bench::make_imsis(0, std::min<size_t>(2 * size, 2 * kLookupTableSize));
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(manager->is_blacklisted(probes[i++ % probes.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BlacklistLookup)->Arg(1'000)->Arg(1'000'000);
+
+} // namespace
@@ -1,5 +1,13 @@
 #include "network/udp_server.h"
 #include "network/udp_client.h"
+#include "network/async_udp_client.h"
+#include "network/request_tag.h"
+#include <atomic>
+#include <latch>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include <future>
 #include <gtest/gtest.h>
 #include <thread>
 #include <chrono>
@@ -46,4 +54,117 @@ TEST_F(ServerClientIntegrationTest, LargeMessage) {
     
     EXPECT_TRUE(client.send(large_msg, response));
     EXPECT_EQ(response, large_msg);
-}
\ No newline at end of file
+}
+
+TEST_F(ServerClientIntegrationTest, AsyncClientCorrelatesPipelinedReplies) {
+    // Эхо-сервер возвращает тег вместе с телом, как и PGW-сервер
+    AsyncUdpClient client("127.0.0.1", 5060);
+    ASSERT_TRUE(client.is_initialized());
+
+    constexpr int kRequests = 2000;
+    std::vector<std::string> responses(kRequests);
+    std::atomic<int> failures{0};
+    std::latch done(kRequests);
+
+    for (int i = 0; i < kRequests; ++i) {
+        client.send("request " + std::to_string(i),
+            [&, i](AsyncUdpClient::Status status, std::string_view payload) {
+                if (status == AsyncUdpClient::Status::Ok) {
+                    responses[i] = std::string(payload);
+                } else {
+                    failures++;
+                }
+                done.count_down();
+            });
+    }
+    done.wait();
+
+    EXPECT_EQ(failures, 0);
+    for (int i = 0; i < kRequests; ++i) {
+        EXPECT_EQ(responses[i], "request " + std::to_string(i));
+    }
+    EXPECT_EQ(client.in_flight(), 0u);
+}
+
+TEST(AsyncUdpClientTest, TimesOutWithoutServer) {
+    AsyncUdpClient::Options options;
+    options.timeout = std::chrono::milliseconds(50);
+    AsyncUdpClient client("127.0.0.1", 5061, options);
+    std::promise<AsyncUdpClient::Status> result;
+    client.send("ping", [&](AsyncUdpClient::Status status, std::string_view) { result.set_value(status); });
+
+    const auto status = result.get_future().get();
+    EXPECT_TRUE(status == AsyncUdpClient::Status::Timeout);
+}
+
+TEST(AsyncUdpClientTest, RetransmitsLostRequests) {
+    // Сервер теряет первую копию каждого запроса: ответ приходит только на повтор
+    std::mutex mutex;
+    std::unordered_set<uint32_t> seen;
+    std::unique_ptr<UdpServer> server;
+    server = std::make_unique<UdpServer>("127.0.0.1", 5062,
+        [&](const std::string& msg, const sockaddr_in& addr) {
+            uint32_t tag = 0;
+            std::string_view body;
+            if (!RequestTag::parse(msg, tag, body)) return;
+            {
+                std::lock_guard lock(mutex);
+                if (seen.insert(tag).second) return;
+            }
+            server->send(msg, addr);
+        });
+    std::thread server_thread([&] { server->start(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    AsyncUdpClient::Options options;
+    options.initial_rto = std::chrono::milliseconds(20);
+    options.retry_budget_ratio = 1.0;
+    options.retry_budget_burst = 100;
+    AsyncUdpClient client("127.0.0.1", 5062, options);
+
+    constexpr int kRequests = 50;
+    std::atomic<int> ok{0};
+    std::latch done(kRequests);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRequests; ++i) {
+        client.send("request", [&](AsyncUdpClient::Status status, std::string_view) {
+            if (status == AsyncUdpClient::Status::Ok) ok++;
+            done.count_down();
+        });
+    }
+    done.wait();
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ(ok, kRequests);
+    const auto stats = client.stats();
+    EXPECT_GE(stats.retransmits, static_cast<uint64_t>(kRequests));
+    EXPECT_EQ(stats.timeouts, 0u);
+    // Повтор по RTO, а не по общему сроку запроса
+    EXPECT_LT(elapsed, options.timeout / 2);
+
+    server->stop();
+    server_thread.join();
+}
+
+TEST(RttEstimatorTest, FollowsJacobsonKarels) {
+    using namespace std::chrono_literals;
+    RttEstimator rtt(200ms, 5ms, 1000ms);
+    EXPECT_FALSE(rtt.has_samples());
+    EXPECT_EQ(rtt.rto(), 200ms);
+
+    // Первый замер: SRTT = R, RTTVAR = R/2, RTO = SRTT + 4*RTTVAR
+    rtt.sample(10ms);
+    EXPECT_EQ(rtt.srtt(), 10ms);
+    EXPECT_EQ(rtt.rttvar(), 5ms);
+    EXPECT_EQ(rtt.rto(), 30ms);
+
+    // Стабильный RTT: разброс затухает, RTO прижимается к нижней границе
+    for (int i = 0; i < 100; ++i) rtt.sample(10ms);
+    EXPECT_EQ(rtt.srtt(), 10ms);
+    EXPECT_GE(rtt.rto(), 10ms);
+    EXPECT_LT(rtt.rto(), 11ms);
+    EXPECT_LE(rtt.hedge_delay(), rtt.rto());
+
+    rtt.sample(5s);
+    EXPECT_EQ(rtt.rto(), 1000ms);
+}
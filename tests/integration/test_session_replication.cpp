@@ -0,0 +1,75 @@
+#include "session/session_manager.h"
+#include "session/session_replication.h"
+#include "test_util.h"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+namespace {
+
+// Основной узел в отдельном процессе: сессии, затем часть из них истекает
+[[noreturn]] void run_primary(int standby_port) {
+    auto log = std::make_shared<ReplicationLog>();
+    SessionManager primary(nullptr, 300, {}, nullptr, nullptr, nullptr, log);
+    for (uint64_t i = 0; i < 20000; ++i) {
+        primary.create_session(make_imsi(i));
+    }
+
+    SessionReplicator replicator(primary, log, "127.0.0.1", standby_port, std::chrono::milliseconds(10));
+    replicator.start();
+    for (uint64_t i = 20000; i < 50000; ++i) {
+        primary.create_session(make_imsi(i));
+        if (i % 1000 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    // Первые 20000 продлены с большим таймаутом, остальные истекают
+    primary.update_policy(600, {});
+    for (uint64_t i = 0; i < 20000; ++i) {
+        primary.create_session(make_imsi(i));
+    }
+    primary.cleanup_expired_sessions(std::chrono::steady_clock::now() + std::chrono::seconds(400));
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (replicator.stats().frames == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    replicator.stop();
+    ::_exit(replicator.stats().full_syncs == 1 ? 0 : 1);
+}
+
+} // namespace
+
+TEST(SessionReplicationIntegrationTest, StandbyProcessMirrorsPrimaryProcess) {
+    SessionManager standby(nullptr, 300, {}, nullptr);
+    ReplicationReceiver receiver(standby, "127.0.0.1", 0);
+
+    // Поток приёма запускается после fork: в дочернем процессе нет чужих блокировок
+    const pid_t primary = ::fork();
+    ASSERT_GE(primary, 0);
+    if (primary == 0) {
+        run_primary(receiver.port());
+    }
+    receiver.start();
+
+    int status = 0;
+    ASSERT_EQ(::waitpid(primary, &status, 0), primary);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+
+    // Последняя пачка уходит при остановке основного узла
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (receiver.stats().connected && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    receiver.stop();
+
+    EXPECT_EQ(standby.session_count(), 20000u);
+    EXPECT_TRUE(standby.session_exists(make_imsi(0)));
+    EXPECT_TRUE(standby.session_exists(make_imsi(19999)));
+    EXPECT_FALSE(standby.session_exists(make_imsi(20000)));
+    EXPECT_FALSE(standby.session_exists(make_imsi(49999)));
+}
@@ -0,0 +1,108 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "utils/bcd_batch.h"
+#include "utils/bcd_converter.h"
+
+namespace {
+
+volatile uint64_t sink;
+
+// Время на один IMSI
+template<typename F>
+void measure(const std::string& name, size_t count, int rounds, F&& body) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        body();
+    }
+    const double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << nanos / (static_cast<double>(count) * rounds) << " ns/imsi\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = 100'000;
+    if (argc > 1) {
+        try {
+            count = std::stoull(argv[1]);
+        } catch (const std::exception& e) {
+            std::cerr << "Usage: " << argv[0] << " [imsi_count]\n";
+            return 1;
+        }
+    }
+    const int rounds = 20;
+
+    std::mt19937_64 rng(1);
+    std::vector<std::string> imsis;
+    std::vector<std::vector<uint8_t>> wire;
+    ImsiBatch batch;
+    for (size_t i = 0; i < count; ++i) {
+        std::string imsi = std::to_string(100000000000000ULL + rng() % 900000000000000ULL);
+        wire.push_back(BCDConverter::imsi_to_bcd(imsi));
+        batch.push_back(imsi);
+        imsis.push_back(std::move(imsi));
+    }
+
+    std::vector<uint8_t> bcd(count * ImsiBatch::kBcdSlot);
+    for (size_t i = 0; i < count; ++i) {
+        BCDBatch::to_bcd_slot(wire[i].data(), wire[i].size(), bcd.data() + i * ImsiBatch::kBcdSlot);
+    }
+
+    std::cout << "IMSIs: " << count << ", best ISA: " << BCDBatch::isa_name(BCDBatch::best_isa()) << "\n\n";
+
+    measure("BCDConverter::validate_imsi", count, rounds, [&] {
+        uint64_t ok = 0;
+        for (const auto& imsi : imsis) ok += BCDConverter::validate_imsi(imsi);
+        sink = ok;
+    });
+    measure("BCDConverter::imsi_to_bcd", count, rounds, [&] {
+        uint64_t total = 0;
+        for (const auto& imsi : imsis) total += BCDConverter::imsi_to_bcd(imsi).size();
+        sink = total;
+    });
+    measure("Imsi::parse", count, rounds, [&] {
+        uint64_t total = 0;
+        for (const auto& imsi : imsis) total += Imsi::parse(imsi)->key();
+        sink = total;
+    });
+    measure("BCDConverter::bcd_to_imsi", count, rounds, [&] {
+        uint64_t total = 0;
+        for (const auto& data : wire) total += BCDConverter::bcd_to_imsi(data).size();
+        sink = total;
+    });
+
+    std::vector<uint8_t> valid(count);
+    std::vector<uint64_t> keys(count);
+    ImsiBatch decoded;
+    for (const auto isa : {BCDBatch::Isa::Scalar, BCDBatch::Isa::Sse41, BCDBatch::Isa::Avx2}) {
+        if (isa > BCDBatch::best_isa()) continue;
+        const std::string name = BCDBatch::isa_name(isa);
+
+        std::cout << '\n';
+        measure("BCDBatch::validate [" + name + "]", count, rounds, [&] {
+            BCDBatch::validate(batch, valid.data(), isa);
+            sink = valid[count / 2];
+        });
+        measure("BCDBatch::encode [" + name + "]", count, rounds, [&] {
+            BCDBatch::encode(batch, bcd.data(), isa);
+            sink = bcd[count / 2];
+        });
+        measure("BCDBatch::decode [" + name + "]", count, rounds, [&] {
+            BCDBatch::decode(bcd.data(), count, decoded, isa);
+            sink = decoded.lengths[count / 2];
+        });
+        measure("BCDBatch::pack_keys [" + name + "]", count, rounds, [&] {
+            BCDBatch::pack_keys(batch, keys.data(), isa);
+            sink = keys[count / 2];
+        });
+        measure("BCDBatch::parse [" + name + "]", count, rounds, [&] {
+            sink = BCDBatch::parse(imsis, isa)[count / 2].key();
+        });
+    }
+
+    return 0;
+}
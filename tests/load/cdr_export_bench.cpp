@@ -0,0 +1,118 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+struct DownloadResult {
+    bool ok = false;
+    int status = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+};
+
+DownloadResult download(const std::string& ip, int port, const std::string& segment, uint64_t offset) {
+    DownloadResult result;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return result;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) <= 0 ||
+        connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::cerr << "Connect failed: " << strerror(errno) << "\n";
+        close(fd);
+        return result;
+    }
+
+    std::string request = "GET /cdr_export/" + segment + " HTTP/1.1\r\nHost: " + ip + "\r\n";
+    if (offset > 0) {
+        request += "Range: bytes=" + std::to_string(offset) + "-\r\n";
+    }
+    request += "\r\n";
+
+    auto start = std::chrono::steady_clock::now();
+    send(fd, request.data(), request.size(), 0);
+
+    std::vector<char> buffer(1024 * 1024);
+    std::string header;
+    bool header_done = false;
+    while (true) {
+        ssize_t n = recv(fd, buffer.data(), buffer.size(), 0);
+        if (n <= 0) break;
+
+        if (header_done) {
+            result.bytes += static_cast<uint64_t>(n);
+            continue;
+        }
+
+        header.append(buffer.data(), static_cast<size_t>(n));
+        if (auto end = header.find("\r\n\r\n"); end != std::string::npos) {
+            header_done = true;
+            result.bytes += header.size() - end - 4;
+            result.status = std::stoi(header.substr(9, 3));
+        }
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.ok = header_done && (result.status == 200 || result.status == 206);
+
+    close(fd);
+    return result;
+}
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " <server_ip> <export_port> <segment> [repeat] [offset]\n"
+              << "Arguments:\n"
+              << "  server_ip      Address of pgw_server\n"
+              << "  export_port    Value of cdr_export_port in the server config\n"
+              << "  segment        Closed segment name, see GET /cdr_segments\n"
+              << "  repeat         Number of downloads (default: 5)\n"
+              << "  offset         Resume offset in bytes (default: 0)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 4 || argc > 6) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    int port = 0;
+    int repeat = 5;
+    uint64_t offset = 0;
+    try {
+        port = std::stoi(argv[2]);
+        if (argc > 4) repeat = std::stoi(argv[4]);
+        if (argc > 5) offset = std::stoull(argv[5]);
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    uint64_t total_bytes = 0;
+    double total_seconds = 0;
+    for (int i = 0; i < repeat; ++i) {
+        DownloadResult result = download(argv[1], port, argv[3], offset);
+        if (!result.ok) {
+            std::cerr << "Download failed (HTTP " << result.status << ")\n";
+            return 1;
+        }
+        total_bytes += result.bytes;
+        total_seconds += result.seconds;
+        std::cout << "Run " << i + 1 << ": " << result.bytes << " bytes in " << result.seconds * 1000 << " ms ("
+                  << result.bytes / result.seconds / (1024 * 1024) << " MB/s)\n";
+    }
+
+    std::cout << "\nAverage throughput: " << total_bytes / total_seconds / (1024 * 1024) << " MB/s\n";
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "cdr/cdr_manager.h"
+#include "test_imsi.h"
+
+namespace {
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " <data_dir> [records] [subscribers] [lookups] [segment_mb]\n"
+              << "Arguments:\n"
+              << "  data_dir       Directory for the synthetic CDR dataset (reused if it already exists)\n"
+              << "  records        Number of CDR records to generate (default: 100000000)\n"
+              << "  subscribers    Number of distinct IMSIs (default: 10000000)\n"
+              << "  lookups        Number of random /cdr_history lookups (default: 1000)\n"
+              << "  segment_mb     CDR segment size in MB (default: 64)\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 6) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const std::filesystem::path data_dir = argv[1];
+    uint64_t records = 100'000'000;
+    uint64_t subscribers = 10'000'000;
+    size_t lookups = 1000;
+    uint64_t segment_mb = 64;
+    try {
+        if (argc > 2) records = std::stoull(argv[2]);
+        if (argc > 3) subscribers = std::stoull(argv[3]);
+        if (argc > 4) lookups = std::stoul(argv[4]);
+        if (argc > 5) segment_mb = std::stoull(argv[5]);
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (subscribers == 0 || subscribers >= 10'000'000'000ULL) {
+        std::cerr << "Subscribers must be in [1, 10^10)\n";
+        return 1;
+    }
+
+    const std::string cdr_file = (data_dir / "cdr.log").string();
+    const uint64_t segment_bytes = segment_mb * 1024 * 1024;
+    std::filesystem::create_directories(data_dir);
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<uint64_t> pick(0, subscribers - 1);
+
+    if (!std::filesystem::exists(cdr_file + ".000001")) {
+        std::cout << "Generating " << records << " records for " << subscribers << " subscribers...\n";
+        auto start = std::chrono::steady_clock::now();
+        {
+            CdrManager cdr(cdr_file, segment_bytes);
+            for (uint64_t i = 0; i < records; ++i) {
+                cdr.add_record(make_imsi(pick(rng)), (i % 7 == 0) ? "created" : "prolonged");
+                if (i % 10'000'000 == 0 && i > 0) {
+                    std::cout << "  " << i << " records\n";
+                }
+            }
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Generated in " << elapsed << " s (" << records / elapsed << " records/s)\n";
+    } else {
+        std::cout << "Reusing dataset in " << data_dir << "\n";
+    }
+
+    auto open_start = std::chrono::steady_clock::now();
+    CdrManager cdr(cdr_file, segment_bytes);
+    auto open_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - open_start).count();
+
+    std::vector<double> latencies_us;
+    latencies_us.reserve(lookups);
+    size_t found = 0;
+    for (size_t i = 0; i < lookups; ++i) {
+        const Imsi imsi = make_imsi(pick(rng));
+        auto start = std::chrono::steady_clock::now();
+        found += cdr.find_records(imsi, 1000).size();
+        latencies_us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    std::sort(latencies_us.begin(), latencies_us.end());
+    auto percentile = [&](double p) {
+        return latencies_us.empty() ? 0.0 : latencies_us[std::min(latencies_us.size() - 1, static_cast<size_t>(p * latencies_us.size()))];
+    };
+
+    std::cout << "\nIndex load time: " << open_ms << " ms\n";
+    std::cout << "Lookups: " << lookups << ", records found: " << found << "\n";
+    std::cout << "Lookup latency p50: " << percentile(0.50) << " us\n";
+    std::cout << "Lookup latency p99: " << percentile(0.99) << " us\n";
+    std::cout << "Lookup latency max: " << (latencies_us.empty() ? 0.0 : latencies_us.back()) << " us\n";
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include "metrics/latency.h"
+#include "metrics/metrics.h"
+#include "utils/cycle_clock.h"
+
+namespace {
+
+volatile uint64_t sink;
+
+template<typename F>
+void measure(const std::string& name, uint64_t iterations, F&& body) {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i) {
+        body(i);
+    }
+    const double nanos = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ": " << nanos / iterations << " ns/op\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t iterations = 10'000'000;
+    if (argc > 1) {
+        try {
+            iterations = std::stoull(argv[1]);
+        } catch (const std::exception& e) {
+            std::cerr << "Usage: " << argv[0] << " [iterations]\n";
+            return 1;
+        }
+    }
+
+    std::cout << "Cycle clock: " << CycleClock::nanos_per_tick() << " ns per tick\n\n";
+
+    measure("steady_clock::now", iterations, [](uint64_t) {
+        sink = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    });
+    measure("CycleClock::now", iterations, [](uint64_t) {
+        sink = CycleClock::now();
+    });
+
+    LatencyHistogram histogram;
+    measure("LatencyHistogram::record", iterations, [&](uint64_t i) {
+        histogram.record(i & 0xFFFFF);
+    });
+    measure("Latency::record (thread-local)", iterations, [](uint64_t i) {
+        Latency::record(Stage::Decode, i & 0xFFFFF);
+    });
+    measure("Metrics::increment", iterations, [](uint64_t) {
+        Metrics::increment(Counter::UdpPacketsIn);
+    });
+
+    // Полный замер одного этапа, как в handle_udp_message
+    measure("stage boundary (now + to_nanos + record)", iterations, [](uint64_t) {
+        const uint64_t start = CycleClock::now();
+        Latency::record(Stage::Send, CycleClock::to_nanos(CycleClock::now() - start));
+    });
+
+    return 0;
+}
@@ -0,0 +1,370 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include "config/client_config.h"
+#include "metrics/latency.h"
+#include "network/request_tag.h"
+#include "utils/imsi.h"
+#include "test_imsi.h"
+
+// Генератор нагрузки с открытым циклом: запросы уходят по расписанию с заданной частотой
+// независимо от ответов, задержка считается от запланированного момента отправки (без
+// coordinated omission). Несколько потоков, у каждого свой epoll и постоянные сокеты.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto kResponseTimeout = std::chrono::seconds(1);
+constexpr auto kExpiryCheckInterval = std::chrono::milliseconds(10);
+constexpr auto kMaxWait = std::chrono::milliseconds(1);
+constexpr int kMaxEvents = 64;
+constexpr int kSocketBufferBytes = 4 * 1024 * 1024;
+
+struct Options {
+    std::string config_path;
+    double rate = 10000;            // запросов в секунду суммарно
+    double duration_sec = 10;
+    unsigned threads = 2;
+    unsigned sockets_per_thread = 16;
+    uint64_t subscribers = 100000;
+    bool json = false;
+};
+
+// IMSI в BCD с местом под тег, готовый к отправке
+struct WireImsi {
+    char bytes[RequestTag::kHeaderSize + Imsi::kMaxBcdBytes];
+    uint8_t size;
+};
+
+// Запрос в полёте. Ответ находится по тегу, а не по порядку на сокете: потерянная
+// датаграмма не сдвигает задержки следующих ответов
+struct InFlight {
+    Clock::time_point scheduled;
+    bool answered = false;
+};
+
+struct ThreadStats {
+    LatencyHistogram latency;       // наносекунды
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    uint64_t lost = 0;
+    uint64_t send_errors = 0;
+    uint64_t unexpected = 0;        // ответ без тега или на неизвестный тег (пришёл после таймаута)
+    uint64_t created = 0;
+    uint64_t rejected = 0;
+    uint64_t errors = 0;
+    Clock::time_point last_send;
+};
+
+int open_socket(const sockaddr_in& server) {
+    int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+    }
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+    // connect для UDP: send без адреса, приём только от сервера
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&server), sizeof(server)) < 0) {
+        const int error = errno;
+        ::close(fd);
+        throw std::runtime_error(std::string("connect: ") + std::strerror(error));
+    }
+    return fd;
+}
+
+void classify(ThreadStats& stats, std::string_view response) {
+    if (response == "created") {
+        ++stats.created;
+    } else if (response == "rejected") {
+        ++stats.rejected;
+    } else {
+        ++stats.errors;
+    }
+}
+
+void run_worker(unsigned index, const Options& options, const std::vector<WireImsi>& imsis,
+                const sockaddr_in& server, Clock::time_point start, ThreadStats& stats) {
+    // Точные пробуждения epoll_pwait2 вместо слака таймеров по умолчанию (50 мкс)
+    ::prctl(PR_SET_TIMERSLACK, 1000UL);
+
+    std::vector<int> sockets(options.sockets_per_thread);
+    const int epoll_fd = ::epoll_create1(0);
+    for (int& fd : sockets) {
+        fd = open_socket(server);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    // Окно запросов потока по порядку тегов: window[i] - запрос с тегом first_tag + i.
+    // Теги свои у каждого потока (сокеты у потоков разные)
+    std::deque<InFlight> window;
+    uint32_t first_tag = 0;
+
+    const auto interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.threads / options.rate));
+    const auto send_end = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(options.duration_sec));
+    const auto deadline = send_end + kResponseTimeout;
+
+    // Потоки сдвинуты на долю интервала, чтобы суммарный поток был равномерным
+    auto next_send = start + interval * index / options.threads;
+    auto next_expiry_check = start + kExpiryCheckInterval;
+    uint64_t sequence = index;
+    size_t next_socket = 0;
+    size_t in_flight = 0;
+    epoll_event events[kMaxEvents];
+    char buffer[256];
+
+    for (;;) {
+        auto now = Clock::now();
+
+        // Открытый цикл: отправить всё, что уже должно было уйти, даже с опозданием
+        while (next_send <= now && next_send < send_end) {
+            const int fd = sockets[next_socket];
+            next_socket = (next_socket + 1) % sockets.size();
+            const WireImsi& imsi = imsis[sequence % imsis.size()];
+            sequence += options.threads;
+
+            char datagram[sizeof(imsi.bytes)];
+            const auto tag = static_cast<uint32_t>(first_tag + window.size());
+            RequestTag::write_header(tag, datagram);
+            std::memcpy(datagram + RequestTag::kHeaderSize, imsi.bytes + RequestTag::kHeaderSize,
+                        imsi.size - RequestTag::kHeaderSize);
+
+            // Неотправленный запрос тоже занимает тег: окно остаётся непрерывным
+            window.push_back(InFlight{next_send, true});
+            if (::send(fd, datagram, imsi.size, 0) == imsi.size) {
+                window.back().answered = false;
+                ++in_flight;
+                ++stats.sent;
+            } else {
+                ++stats.send_errors;
+            }
+            stats.last_send = next_send;
+            next_send += interval;
+        }
+
+        if (now >= next_expiry_check) {
+            // Голова окна: отвеченные и просроченные запросы
+            while (!window.empty() && (window.front().answered || now - window.front().scheduled > kResponseTimeout)) {
+                if (!window.front().answered) {
+                    --in_flight;
+                    ++stats.lost;
+                }
+                window.pop_front();
+                ++first_tag;
+            }
+            next_expiry_check = now + kExpiryCheckInterval;
+        }
+
+        if (now >= deadline || (next_send >= send_end && in_flight == 0)) {
+            break;
+        }
+
+        auto wait = std::min(next_send >= send_end ? kMaxWait : next_send - now, Clock::duration(kMaxWait));
+        if (wait < Clock::duration::zero()) wait = Clock::duration::zero();
+        const timespec timeout{0, static_cast<long>(std::chrono::nanoseconds(wait).count())};
+        const int ready = ::epoll_pwait2(epoll_fd, events, kMaxEvents, &timeout, nullptr);
+        if (ready <= 0) continue;
+
+        now = Clock::now();
+        for (int i = 0; i < ready; ++i) {
+            for (;;) {
+                const ssize_t received = ::recv(events[i].data.fd, buffer, sizeof(buffer), 0);
+                if (received < 0) break;   // EAGAIN или ICMP-ошибка: запрос досчитается по таймауту
+                uint32_t tag = 0;
+                std::string_view body;
+                if (!RequestTag::parse(std::string_view(buffer, static_cast<size_t>(received)), tag, body)) {
+                    ++stats.unexpected;
+                    continue;
+                }
+                // Беззнаковая разность: тег до начала окна даёт большое смещение
+                const uint32_t offset = tag - first_tag;
+                if (offset >= window.size() || window[offset].answered) {
+                    ++stats.unexpected;
+                    continue;
+                }
+                window[offset].answered = true;
+                --in_flight;
+                ++stats.received;
+                stats.latency.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - window[offset].scheduled).count()));
+                classify(stats, body);
+            }
+        }
+    }
+
+    stats.lost += in_flight;
+    for (int fd : sockets) {
+        ::close(fd);
+    }
+    ::close(epoll_fd);
+}
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " <config_path> [rate] [duration_sec] [threads] [sockets] [subscribers] [json]\n"
+              << "Arguments:\n"
+              << "  config_path    Path to client config file (server_ip, server_port)\n"
+              << "  rate           Target request rate, requests per second (default: 10000)\n"
+              << "  duration_sec   Sending duration in seconds (default: 10)\n"
+              << "  threads        Event-loop threads (default: 2)\n"
+              << "  sockets        UDP sockets per thread (default: 16)\n"
+              << "  subscribers    Number of distinct IMSIs sent round-robin (default: 100000)\n"
+              << "  json           Print the report as JSON (0/1, default: 0)\n\n"
+              << "Example:\n"
+              << "  " << program_name << " config.json 50000 30 4 32 1000000 1\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2 || argc > 8) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    Options options;
+    options.config_path = argv[1];
+    try {
+        if (argc > 2) options.rate = std::stod(argv[2]);
+        if (argc > 3) options.duration_sec = std::stod(argv[3]);
+        if (argc > 4) options.threads = static_cast<unsigned>(std::stoul(argv[4]));
+        if (argc > 5) options.sockets_per_thread = static_cast<unsigned>(std::stoul(argv[5]));
+        if (argc > 6) options.subscribers = std::stoull(argv[6]);
+        if (argc > 7) options.json = std::stoi(argv[7]) != 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (options.rate <= 0 || options.duration_sec <= 0 || options.threads == 0 ||
+        options.sockets_per_thread == 0 || options.subscribers == 0 || options.subscribers >= 10'000'000'000ULL) {
+        std::cerr << "rate, duration, threads and sockets must be positive; subscribers in [1, 10^10)\n";
+        return 1;
+    }
+
+    sockaddr_in server{};
+    try {
+        ClientConfig config(options.config_path);
+        server.sin_family = AF_INET;
+        server.sin_port = htons(static_cast<uint16_t>(config.get_server_port()));
+        if (::inet_pton(AF_INET, config.get_server_ip().c_str(), &server.sin_addr) != 1) {
+            throw std::runtime_error("Invalid server_ip: " + config.get_server_ip());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load config: " << e.what() << "\n";
+        return 1;
+    }
+
+    // Все IMSI кодируются заранее: на пути отправки только тег, memcpy и send
+    std::vector<WireImsi> imsis(options.subscribers);
+    std::mt19937_64 rng(42);
+    for (uint64_t i = 0; i < options.subscribers; ++i) {
+        uint8_t bcd[Imsi::kMaxBcdBytes];
+        const size_t size = make_imsi(i).to_bcd(bcd);
+        std::memcpy(imsis[i].bytes + RequestTag::kHeaderSize, bcd, size);
+        imsis[i].size = static_cast<uint8_t>(RequestTag::kHeaderSize + size);
+    }
+    std::shuffle(imsis.begin(), imsis.end(), rng);
+
+    std::vector<std::unique_ptr<ThreadStats>> stats;
+    for (unsigned i = 0; i < options.threads; ++i) {
+        stats.push_back(std::make_unique<ThreadStats>());
+    }
+
+    if (!options.json) {
+        std::cout << "Sending " << options.rate << " req/s for " << options.duration_sec << " s from "
+                  << options.threads << " threads x " << options.sockets_per_thread << " sockets\n";
+    }
+
+    // Общий старт с запасом на создание сокетов
+    const auto start = Clock::now() + std::chrono::milliseconds(50);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < options.threads; ++i) {
+        workers.emplace_back([&, i] {
+            try {
+                run_worker(i, options, imsis, server, start, *stats[i]);
+            } catch (const std::exception& e) {
+                std::cerr << "Worker " << i << " failed: " << e.what() << "\n";
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    LatencyHistogram latency;
+    ThreadStats total;
+    for (const auto& s : stats) {
+        latency.merge(s->latency);
+        total.sent += s->sent;
+        total.received += s->received;
+        total.lost += s->lost;
+        total.send_errors += s->send_errors;
+        total.unexpected += s->unexpected;
+        total.created += s->created;
+        total.rejected += s->rejected;
+        total.errors += s->errors;
+        total.last_send = std::max(total.last_send, s->last_send);
+    }
+
+    const double send_seconds = std::max(std::chrono::duration<double>(total.last_send - start).count(), 1e-9);
+    const double achieved_rate = static_cast<double>(total.sent) / send_seconds;
+    const double goodput = static_cast<double>(total.received) / send_seconds;
+    auto micros = [](uint64_t nanos) { return static_cast<double>(nanos) / 1000.0; };
+
+    nlohmann::json report = {
+        {"target_rate", options.rate},
+        {"achieved_rate", achieved_rate},
+        {"goodput", goodput},
+        {"duration_sec", send_seconds},
+        {"sent", total.sent},
+        {"received", total.received},
+        {"lost", total.lost},
+        {"send_errors", total.send_errors},
+        {"unexpected", total.unexpected},
+        {"responses", {{"created", total.created}, {"rejected", total.rejected}, {"other", total.errors}}},
+        {"latency_us", {
+            {"p50", micros(latency.value_at_percentile(50.0))},
+            {"p99", micros(latency.value_at_percentile(99.0))},
+            {"p99.9", micros(latency.value_at_percentile(99.9))},
+            {"max", micros(latency.max())},
+            {"mean", latency.mean() / 1000.0}
+        }}
+    };
+
+    if (options.json) {
+        std::cout << report.dump(2) << "\n";
+        return 0;
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "\nTarget rate:   " << options.rate << " req/s\n"
+              << "Achieved rate: " << achieved_rate << " req/s (responses " << goodput << "/s)\n"
+              << "Sent: " << total.sent << ", received: " << total.received << ", lost: " << total.lost
+              << ", send errors: " << total.send_errors << "\n"
+              << "Responses: created " << total.created << ", rejected " << total.rejected
+              << ", other " << total.errors << "\n"
+              << "Latency p50:   " << micros(latency.value_at_percentile(50.0)) << " us\n"
+              << "Latency p99:   " << micros(latency.value_at_percentile(99.0)) << " us\n"
+              << "Latency p99.9: " << micros(latency.value_at_percentile(99.9)) << " us\n"
+              << "Latency max:   " << micros(latency.max()) << " us\n";
+    return 0;
+}
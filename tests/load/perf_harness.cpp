@@ -0,0 +1,670 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <semaphore>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "metrics/latency.h"
+#include "network/async_udp_client.h"
+#include "utils/imsi.h"
+#include "test_imsi.h"
+
+// Регрессионный прогон производительности: поднимает pgw_server на loopback с
+// конфигурацией configs/perf_server_config.json (свежий процесс на каждый сценарий),
+// гоняет сценарии, пишет результаты в JSON и сравнивает их с сохранённым базовым
+// уровнем. Выход за допуск хотя бы одной метрики - код возврата 1.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+namespace fs = std::filesystem;
+
+constexpr size_t kUdpWindow = 512;          // запросов в полёте у UDP-драйвера
+constexpr size_t kProbeSubscribers = 100;   // фоновые абоненты сценария mass_expiry
+constexpr auto kStartTimeout = std::chrono::seconds(10);
+constexpr auto kStopTimeout = std::chrono::seconds(60);
+constexpr auto kExpiryTimeout = std::chrono::seconds(20);
+constexpr auto kPollInterval = std::chrono::milliseconds(10);
+
+// Направление и допуск метрики для новых записей базового уровня
+struct MetricSpec {
+    const char* name;
+    bool higher_is_better;
+    double tolerance;       // относительный
+};
+
+constexpr MetricSpec kMetricSpecs[] = {
+    {"throughput_rps", true, 0.30},
+    {"p50_us", false, 0.50},
+    {"p99_us", false, 0.50},
+    {"errors", false, 0.0},
+    {"http_rps", true, 0.30},
+    {"http_p99_us", false, 0.50},
+    {"udp_throughput_rps", true, 0.30},
+    {"expiry_pass_ms", false, 0.50},
+    {"probe_p99_us", false, 1.00},
+    {"shutdown_ms", false, 0.25},
+};
+
+const MetricSpec& metric_spec(const std::string& name) {
+    for (const auto& spec : kMetricSpecs) {
+        if (name == spec.name) return spec;
+    }
+    static constexpr MetricSpec kUnknown{"", false, 0.25};
+    return kUnknown;
+}
+
+// BCD-датаграммы абонентов [first, first + count)
+std::vector<std::string> make_payloads(uint64_t first, size_t count) {
+    std::vector<std::string> payloads;
+    payloads.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t bcd[Imsi::kMaxBcdBytes];
+        const size_t size = make_imsi(first + i).to_bcd(bcd);
+        payloads.emplace_back(reinterpret_cast<const char*>(bcd), size);
+    }
+    return payloads;
+}
+
+double micros(uint64_t nanos) {
+    return static_cast<double>(nanos) / 1000.0;
+}
+
+uint64_t nanos_since(Clock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+// ---------------------------------------------------------------------------
+// Сервер
+// ---------------------------------------------------------------------------
+
+class ServerProcess {
+public:
+    ServerProcess(const std::string& binary, const fs::path& config_path) {
+        pid_ = ::fork();
+        if (pid_ < 0) {
+            throw std::runtime_error(std::string("fork: ") + std::strerror(errno));
+        }
+        if (pid_ == 0) {
+            const int null_fd = ::open("/dev/null", O_RDWR);
+            ::dup2(null_fd, STDOUT_FILENO);
+            ::dup2(null_fd, STDERR_FILENO);
+            ::execl(binary.c_str(), binary.c_str(), config_path.c_str(), static_cast<char*>(nullptr));
+            ::_exit(127);
+        }
+    }
+
+    ~ServerProcess() {
+        if (pid_ > 0) {
+            ::kill(pid_, SIGKILL);
+            ::waitpid(pid_, nullptr, 0);
+        }
+    }
+
+    ServerProcess(const ServerProcess&) = delete;
+    ServerProcess& operator=(const ServerProcess&) = delete;
+
+    bool running() {
+        if (pid_ > 0 && ::waitpid(pid_, nullptr, WNOHANG) == pid_) {
+            pid_ = -1;
+        }
+        return pid_ > 0;
+    }
+
+    // SIGTERM (как в start_tests.sh) и ожидание выхода; время до завершения процесса
+    std::chrono::nanoseconds stop() {
+        const auto start = Clock::now();
+        ::kill(pid_, SIGTERM);
+        while (running()) {
+            if (Clock::now() - start > kStopTimeout) {
+                throw std::runtime_error("server did not exit after SIGTERM");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return Clock::now() - start;
+    }
+
+private:
+    pid_t pid_ = -1;
+};
+
+struct HttpResponse {
+    int status = 0;
+    std::string body;
+};
+
+// Минимальный HTTP/1.1 GET с Connection: close; status 0 - сервер недоступен
+HttpResponse http_get(int port, const std::string& path) {
+    HttpResponse response;
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return response;
+
+    const timeval timeout{5, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return response;
+    }
+
+    const std::string request = "GET " + path + " HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: close\r\n\r\n";
+    if (::send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())) {
+        ::close(fd);
+        return response;
+    }
+
+    std::string raw;
+    char buffer[16384];
+    for (ssize_t received; (received = ::recv(fd, buffer, sizeof(buffer), 0)) > 0;) {
+        raw.append(buffer, static_cast<size_t>(received));
+    }
+    ::close(fd);
+
+    // "HTTP/1.1 200 OK\r\n...\r\n\r\n<body>"
+    if (raw.size() > 12 && raw.starts_with("HTTP/1.")) {
+        response.status = std::atoi(raw.c_str() + 9);
+        const size_t body = raw.find("\r\n\r\n");
+        if (body != std::string::npos) response.body = raw.substr(body + 4);
+    }
+    return response;
+}
+
+// Значение метрики из текстового формата Prometheus
+std::optional<double> prometheus_value(const std::string& text, std::string_view name) {
+    std::istringstream lines(text);
+    for (std::string line; std::getline(lines, line);) {
+        if (line.size() > name.size() && line.starts_with(name) && line[name.size()] == ' ') {
+            return std::stod(line.substr(name.size() + 1));
+        }
+    }
+    return std::nullopt;
+}
+
+// ---------------------------------------------------------------------------
+// UDP-драйвер
+// ---------------------------------------------------------------------------
+
+struct UdpRun {
+    LatencyHistogram latency;   // наносекунды, только успешные ответы
+    uint64_t requests = 0;
+    uint64_t created = 0;
+    uint64_t rejected = 0;
+    uint64_t failed = 0;        // таймаут или ошибка отправки
+    double seconds = 0;
+
+    double throughput() const { return seconds > 0 ? static_cast<double>(requests) / seconds : 0; }
+};
+
+// Закрытый цикл с окном: не больше window запросов в полёте; останавливается по
+// числу запросов или по stop. Колбэки вызываются из одного потока клиента, поэтому
+// счётчики run пишутся без синхронизации, а читаются после возврата всех слотов.
+void drive_udp(AsyncUdpClient& client, const std::vector<std::string>& payloads, uint64_t requests,
+               UdpRun& run, const std::atomic<bool>* stop = nullptr, size_t window = kUdpWindow) {
+    std::counting_semaphore<> slots(static_cast<std::ptrdiff_t>(window));
+    const auto start = Clock::now();
+
+    uint64_t sent = 0;
+    for (; sent < requests && !(stop && stop->load(std::memory_order_relaxed)); ++sent) {
+        slots.acquire();
+        const auto sent_at = Clock::now();
+        client.send(payloads[sent % payloads.size()],
+            [&run, &slots, sent_at](AsyncUdpClient::Status status, std::string_view payload) {
+                if (status != AsyncUdpClient::Status::Ok) {
+                    ++run.failed;
+                } else {
+                    run.latency.record(nanos_since(sent_at));
+                    if (payload == "created") {
+                        ++run.created;
+                    } else {
+                        ++run.rejected;
+                    }
+                }
+                slots.release();
+            });
+    }
+    for (size_t i = 0; i < window; ++i) {
+        slots.acquire();
+    }
+
+    run.requests = sent;
+    run.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+AsyncUdpClient::Options measurement_options() {
+    // Без повторов: потеря видна как ошибка, а не как растянутая задержка
+    AsyncUdpClient::Options options;
+    options.max_retries = 0;
+    return options;
+}
+
+// ---------------------------------------------------------------------------
+// Сценарии
+// ---------------------------------------------------------------------------
+
+class Harness {
+public:
+    Harness(std::string server_binary, nlohmann::json base_config, fs::path work_dir)
+        : server_binary_(std::move(server_binary)), base_config_(std::move(base_config)),
+          work_dir_(std::move(work_dir)) {}
+
+    int udp_port() const { return base_config_.value("udp_port", 0); }
+    int http_port() const { return base_config_.value("http_port", 0); }
+
+    // Свежий сервер с базовой конфигурацией и переопределениями сценария
+    std::unique_ptr<ServerProcess> start_server(const std::string& scenario, const nlohmann::json& overrides,
+                                                bool wait_http) const {
+        nlohmann::json config = base_config_;
+        config["cdr_file"] = (work_dir_ / (scenario + "_cdr.log")).string();
+        if (overrides.is_object()) {
+            config.update(overrides);
+        }
+        const fs::path config_path = work_dir_ / (scenario + ".json");
+        std::ofstream(config_path) << config.dump(2);
+
+        auto server = std::make_unique<ServerProcess>(server_binary_, config_path);
+        wait_ready(*server, wait_http);
+        return server;
+    }
+
+    std::unique_ptr<AsyncUdpClient> make_client(const AsyncUdpClient::Options& options = measurement_options()) const {
+        auto client = std::make_unique<AsyncUdpClient>("127.0.0.1", udp_port(), options);
+        if (!client->is_initialized()) {
+            throw std::runtime_error("UDP client initialization failed");
+        }
+        return client;
+    }
+
+private:
+    // UDP отвечает раньше HTTP: HTTP-сценарии дополнительно ждут /health
+    void wait_ready(ServerProcess& server, bool wait_http) const {
+        AsyncUdpClient::Options options;
+        options.timeout = std::chrono::milliseconds(100);
+        options.max_retries = 0;
+        AsyncUdpClient client("127.0.0.1", udp_port(), options);
+        const auto ping = make_payloads(0, 1);
+
+        const auto deadline = Clock::now() + kStartTimeout;
+        bool udp_ready = false;
+        while (!udp_ready || (wait_http && http_get(http_port(), "/health").status != 200)) {
+            if (!server.running()) {
+                throw std::runtime_error("server exited during startup");
+            }
+            if (Clock::now() > deadline) {
+                throw std::runtime_error(udp_ready ? "HTTP server not ready" : "UDP server not ready");
+            }
+            if (!udp_ready) {
+                std::promise<bool> reply;
+                client.send(ping.front(), [&reply](AsyncUdpClient::Status status, std::string_view) {
+                    reply.set_value(status == AsyncUdpClient::Status::Ok);
+                });
+                udp_ready = reply.get_future().get();
+            } else {
+                std::this_thread::sleep_for(kPollInterval);
+            }
+        }
+    }
+
+    std::string server_binary_;
+    nlohmann::json base_config_;
+    fs::path work_dir_;
+};
+
+nlohmann::json udp_metrics(const UdpRun& run, uint64_t unexpected_responses) {
+    return {
+        {"throughput_rps", run.throughput()},
+        {"p50_us", micros(run.latency.value_at_percentile(50.0))},
+        {"p99_us", micros(run.latency.value_at_percentile(99.0))},
+        {"errors", run.failed + unexpected_responses}
+    };
+}
+
+// Поток новых абонентов: создание сессий, CDR "created"
+nlohmann::json attach_storm(const Harness& harness) {
+    constexpr size_t kSubscribers = 200000;
+    auto server = harness.start_server("attach_storm", {}, false);
+    auto client = harness.make_client();
+
+    const auto payloads = make_payloads(1, kSubscribers);
+    UdpRun run;
+    drive_udp(*client, payloads, payloads.size(), run);
+    server->stop();
+    return udp_metrics(run, run.rejected);
+}
+
+// Повторные attach небольшой группы абонентов: продление сессий
+nlohmann::json reattach_heavy(const Harness& harness) {
+    constexpr size_t kSubscribers = 1000;
+    constexpr uint64_t kRequests = 200000;
+    auto server = harness.start_server("reattach_heavy", {}, false);
+    auto client = harness.make_client();
+
+    const auto payloads = make_payloads(1, kSubscribers);
+    UdpRun warmup;
+    drive_udp(*client, payloads, payloads.size(), warmup);
+
+    UdpRun run;
+    drive_udp(*client, payloads, kRequests, run);
+    server->stop();
+    return udp_metrics(run, run.rejected + warmup.failed);
+}
+
+// HTTP-чтение (/check_subscriber, /sessions, /metrics) на фоне UDP-продлений
+nlohmann::json http_read_mix(const Harness& harness) {
+    constexpr size_t kSubscribers = 20000;
+    constexpr unsigned kHttpThreads = 4;
+    constexpr size_t kRequestsPerThread = 500;
+    auto server = harness.start_server("http_read_mix", {}, true);
+    auto client = harness.make_client();
+
+    const auto payloads = make_payloads(1, kSubscribers);
+    UdpRun preload;
+    drive_udp(*client, payloads, payloads.size(), preload);
+
+    std::atomic<bool> stop_udp{false};
+    UdpRun background;
+    std::thread udp_thread([&] {
+        drive_udp(*client, payloads, UINT64_MAX, background, &stop_udp);
+    });
+
+    std::vector<std::unique_ptr<LatencyHistogram>> latencies;
+    std::atomic<uint64_t> http_errors{0};
+    std::vector<std::thread> readers;
+    const auto start = Clock::now();
+    for (unsigned t = 0; t < kHttpThreads; ++t) {
+        latencies.push_back(std::make_unique<LatencyHistogram>());
+        readers.emplace_back([&, t, latency = latencies.back().get()] {
+            for (size_t i = 0; i < kRequestsPerThread; ++i) {
+                // 80% проверок абонента (половина - неизвестные), 10% страниц дампа, 10% метрик
+                const size_t n = t * kRequestsPerThread + i;
+                std::string path;
+                if (n % 10 == 0) {
+                    path = "/metrics";
+                } else if (n % 10 == 1) {
+                    path = "/sessions?cursor=0&limit=100";
+                } else {
+                    const uint64_t subscriber = n % 2 == 0 ? 1 + n % kSubscribers : 1 + kSubscribers + n;
+                    path = "/check_subscriber?imsi=" + make_imsi(subscriber).to_string();
+                }
+                const auto sent_at = Clock::now();
+                if (http_get(harness.http_port(), path).status != 200) {
+                    ++http_errors;
+                }
+                latency->record(nanos_since(sent_at));
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    const double http_seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    stop_udp = true;
+    udp_thread.join();
+    server->stop();
+
+    LatencyHistogram http_latency;
+    for (const auto& latency : latencies) {
+        http_latency.merge(*latency);
+    }
+    return {
+        {"http_rps", static_cast<double>(http_latency.count()) / http_seconds},
+        {"http_p99_us", micros(http_latency.value_at_percentile(99.0))},
+        {"udp_throughput_rps", background.throughput()},
+        {"errors", http_errors + preload.failed + background.failed}
+    };
+}
+
+// Массовое истечение сессий: длительность прохода очистки и задержка фоновых attach.
+// Сессии создаются быстрее таймаута и истекают за один проход очистки (раз в 5 с).
+nlohmann::json mass_expiry(const Harness& harness) {
+    constexpr size_t kSubscribers = 100000;
+    auto server = harness.start_server("mass_expiry", {{"session_timeout_sec", 1}}, true);
+    auto client = harness.make_client();
+
+    const auto payloads = make_payloads(1, kSubscribers);
+    UdpRun preload;
+    drive_udp(*client, payloads, payloads.size(), preload);
+
+    // Фоновые абоненты продлеваются постоянно и не истекают
+    const auto probe_payloads = make_payloads(kSubscribers + 1, kProbeSubscribers);
+    std::atomic<bool> stop_probe{false};
+    UdpRun probe;
+    std::thread probe_thread([&] {
+        drive_udp(*client, probe_payloads, UINT64_MAX, probe, &stop_probe, 4);
+    });
+
+    // Опрос блокируется на время прохода (gauge берёт разделяемую блокировку таблицы),
+    // поэтому промежуток между последним "полным" и первым "пустым" ответом - длительность прохода
+    const double remaining = static_cast<double>(kProbeSubscribers + 1);
+    std::optional<Clock::time_point> last_full;
+    std::optional<Clock::time_point> first_empty;
+    const auto deadline = Clock::now() + kExpiryTimeout;
+    while (!first_empty && Clock::now() < deadline) {
+        const auto response = http_get(harness.http_port(), "/metrics");
+        const auto active = prometheus_value(response.body, "pgw_sessions_active");
+        const auto now = Clock::now();
+        if (active && *active > remaining) {
+            last_full = now;
+        } else if (active && last_full) {
+            first_empty = now;
+        }
+        std::this_thread::sleep_for(kPollInterval);
+    }
+    stop_probe = true;
+    probe_thread.join();
+    server->stop();
+
+    if (!first_empty) {
+        throw std::runtime_error("sessions did not expire in time");
+    }
+    return {
+        {"expiry_pass_ms", std::chrono::duration<double, std::milli>(*first_empty - *last_full).count()},
+        {"probe_p99_us", micros(probe.latency.value_at_percentile(99.0))},
+        {"errors", preload.failed + probe.failed}
+    };
+}
+
+// Остановка с активными сессиями: SIGTERM -> graceful_shutdown -> выход процесса
+nlohmann::json shutdown_drain(const Harness& harness) {
+    constexpr size_t kSubscribers = 100000;
+    auto server = harness.start_server("shutdown_drain", {}, false);
+    auto client = harness.make_client();
+
+    const auto payloads = make_payloads(1, kSubscribers);
+    UdpRun preload;
+    drive_udp(*client, payloads, payloads.size(), preload);
+    client.reset();
+
+    const auto elapsed = server->stop();
+    return {
+        {"shutdown_ms", std::chrono::duration<double, std::milli>(elapsed).count()},
+        {"errors", preload.failed}
+    };
+}
+
+struct Scenario {
+    const char* name;
+    nlohmann::json (*run)(const Harness&);
+};
+
+constexpr Scenario kScenarios[] = {
+    {"attach_storm", attach_storm},
+    {"reattach_heavy", reattach_heavy},
+    {"http_read_mix", http_read_mix},
+    {"mass_expiry", mass_expiry},
+    {"shutdown_drain", shutdown_drain},
+};
+
+// ---------------------------------------------------------------------------
+// Базовый уровень
+// ---------------------------------------------------------------------------
+
+const nlohmann::json* baseline_entry(const nlohmann::json& baseline, const std::string& scenario,
+                                     const std::string& metric) {
+    const auto scenarios = baseline.find("scenarios");
+    if (scenarios == baseline.end() || !scenarios->contains(scenario)) return nullptr;
+    const auto& metrics = (*scenarios)[scenario];
+    const auto entry = metrics.find(metric);
+    return entry != metrics.end() && entry->is_object() ? &*entry : nullptr;
+}
+
+// Формат: {"scenarios": {"<сценарий>": {"<метрика>": {"value", "better", "tolerance"}}}}
+// Регрессия: для "higher" значение ниже value * (1 - tolerance), для "lower" - выше value * (1 + tolerance)
+size_t compare(const nlohmann::json& results, const nlohmann::json& baseline, nlohmann::json& report) {
+    size_t regressions = 0;
+    std::cout << std::left << std::setw(16) << "scenario" << std::setw(20) << "metric"
+              << std::right << std::setw(14) << "value" << std::setw(14) << "baseline"
+              << std::setw(10) << "delta" << "  status\n";
+
+    for (const auto& [scenario, metrics] : results.items()) {
+        if (metrics.contains("error")) {
+            std::cout << std::left << std::setw(16) << scenario << "FAILED: "
+                      << metrics["error"].get<std::string>() << "\n";
+            continue;
+        }
+        for (const auto& [metric, value] : metrics.items()) {
+            const double current = value.get<double>();
+            std::cout << std::left << std::setw(16) << scenario << std::setw(20) << metric
+                      << std::right << std::fixed << std::setprecision(1) << std::setw(14) << current;
+
+            const nlohmann::json* reference = baseline_entry(baseline, scenario, metric);
+            if (!reference) {
+                std::cout << std::setw(14) << "-" << std::setw(10) << "-" << "  new\n";
+                continue;
+            }
+            const double expected = reference->value("value", 0.0);
+            const double tolerance = reference->value("tolerance", 0.25);
+            const bool higher = reference->value("better", "lower") == "higher";
+            const bool regressed = higher ? current < expected * (1.0 - tolerance)
+                                          : current > expected * (1.0 + tolerance);
+            const double delta = expected != 0 ? (current - expected) / expected * 100.0 : 0.0;
+
+            std::cout << std::setw(14) << expected << std::setw(9) << delta << "%"
+                      << (regressed ? "  REGRESSION" : "  ok") << "\n";
+            if (regressed) {
+                ++regressions;
+                report["regressions"].push_back({
+                    {"scenario", scenario}, {"metric", metric}, {"value", current},
+                    {"baseline", expected}, {"tolerance", tolerance}
+                });
+            }
+        }
+    }
+    return regressions;
+}
+
+// Новые значения; направление и допуск сохраняются из старого базового уровня
+nlohmann::json make_baseline(const nlohmann::json& results, const nlohmann::json& previous) {
+    nlohmann::json baseline = previous.is_object() ? previous : nlohmann::json::object();
+    for (const auto& [scenario, metrics] : results.items()) {
+        if (metrics.contains("error")) continue;
+        for (const auto& [metric, value] : metrics.items()) {
+            const MetricSpec& spec = metric_spec(metric);
+            auto& entry = baseline["scenarios"][scenario][metric];
+            if (!entry.is_object()) {
+                entry = {{"better", spec.higher_is_better ? "higher" : "lower"}, {"tolerance", spec.tolerance}};
+            }
+            entry["value"] = std::round(value.get<double>() * 10.0) / 10.0;
+        }
+    }
+    return baseline;
+}
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name
+              << " <pgw_server> <perf_config> <baseline> [results] [update_baseline] [scenarios]\n"
+              << "Arguments:\n"
+              << "  pgw_server       Path to the server binary\n"
+              << "  perf_config      Base server config (configs/perf_server_config.json)\n"
+              << "  baseline         Baseline JSON (tests/load/perf_baseline.json)\n"
+              << "  results          Where to write results JSON (default: perf_results.json)\n"
+              << "  update_baseline  Overwrite the baseline with this run (0/1, default: 0)\n"
+              << "  scenarios        Comma-separated subset (default: all)\n\n"
+              << "Scenarios: attach_storm, reattach_heavy, http_read_mix, mass_expiry, shutdown_drain\n"
+              << "Exit code: 0 - within tolerance, 1 - regression, 2 - scenario or setup failure\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 4 || argc > 7) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    const std::string server_binary = argv[1];
+    const fs::path baseline_path = argv[3];
+    const fs::path results_path = argc > 4 ? argv[4] : "perf_results.json";
+    const bool update_baseline = argc > 5 && std::string(argv[5]) != "0";
+    const std::string selected = argc > 6 ? argv[6] : "";
+
+    nlohmann::json base_config;
+    nlohmann::json baseline;
+    try {
+        std::ifstream(argv[2]) >> base_config;
+        if (fs::exists(baseline_path)) {
+            std::ifstream(baseline_path) >> baseline;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load config or baseline: " << e.what() << "\n";
+        return 2;
+    }
+
+    char work_template[] = "/tmp/pgw_perf_XXXXXX";
+    if (!::mkdtemp(work_template)) {
+        std::cerr << "mkdtemp: " << std::strerror(errno) << "\n";
+        return 2;
+    }
+    const fs::path work_dir = work_template;
+    const Harness harness(server_binary, base_config, work_dir);
+
+    nlohmann::json results = nlohmann::json::object();
+    bool failed = false;
+    for (const auto& scenario : kScenarios) {
+        if (!selected.empty() && ("," + selected + ",").find(std::string(",") + scenario.name + ",") == std::string::npos) {
+            continue;
+        }
+        std::cerr << "Running " << scenario.name << "..." << std::endl;
+        try {
+            results[scenario.name] = scenario.run(harness);
+        } catch (const std::exception& e) {
+            results[scenario.name] = {{"error", e.what()}};
+            failed = true;
+        }
+    }
+    fs::remove_all(work_dir);
+
+    nlohmann::json report = {{"scenarios", results}, {"regressions", nlohmann::json::array()}};
+    const size_t regressions = compare(results, baseline, report);
+    std::ofstream(results_path) << report.dump(2) << "\n";
+
+    if (update_baseline) {
+        std::ofstream(baseline_path) << make_baseline(results, baseline).dump(2) << "\n";
+        std::cout << "Baseline updated: " << baseline_path.string() << "\n";
+        return failed ? 2 : 0;
+    }
+
+    std::cout << "\n" << regressions << " regression(s), results in " << results_path.string() << "\n";
+    if (failed) return 2;
+    return regressions > 0 ? 1 : 0;
+}
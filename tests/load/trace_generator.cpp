@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "traffic_trace.h"
+#include "utils/imsi.h"
+
+// Генератор трасс трафика для trace_replay. Профиль (JSON) задаёт смесь PLMN,
+// распределение Ципфа для повторных attach, всплески потока и долю запросов
+// абонентов из чёрного списка. Рядом с трассой пишется <trace>.blacklist.json -
+// массив IMSI для поля "blacklist" конфигурации сервера.
+
+namespace {
+
+struct Plmn {
+    std::string prefix;     // MCC + MNC, 5-6 цифр
+    double weight;
+};
+
+struct Profile {
+    uint64_t seed = 42;
+    double duration_sec = 60;
+    double mean_rate = 5000;            // средняя частота с учётом всплесков, запросов/с
+    uint32_t subscribers = 1'000'000;
+    double zipf_exponent = 1.0;         // 0 - равномерно, больше - тяжелее хвост повторов
+    std::vector<Plmn> plmns;
+    double burst_period_sec = 0;        // 0 - без всплесков
+    double burst_duration_sec = 0;
+    double burst_multiplier = 1;
+    uint32_t blacklist_size = 1000;
+    double blacklist_ratio = 0.01;      // доля запросов от абонентов из чёрного списка
+
+    // Частота вне всплеска: средняя по периоду равна mean_rate
+    double base_rate() const {
+        if (burst_period_sec <= 0) return mean_rate;
+        const double burst_share = burst_duration_sec / burst_period_sec;
+        return mean_rate / (1.0 + (burst_multiplier - 1.0) * burst_share);
+    }
+
+    bool in_burst(double t) const {
+        return burst_period_sec > 0 && std::fmod(t, burst_period_sec) < burst_duration_sec;
+    }
+};
+
+Profile load_profile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open profile: " + path);
+    }
+    nlohmann::json spec;
+    file >> spec;
+
+    Profile profile;
+    profile.seed = spec.value("seed", profile.seed);
+    profile.duration_sec = spec.value("duration_sec", profile.duration_sec);
+    profile.mean_rate = spec.value("mean_rate", profile.mean_rate);
+    profile.subscribers = spec.value("subscribers", profile.subscribers);
+    profile.zipf_exponent = spec.value("zipf_exponent", profile.zipf_exponent);
+    profile.blacklist_size = spec.value("blacklist_size", profile.blacklist_size);
+    profile.blacklist_ratio = spec.value("blacklist_ratio", profile.blacklist_ratio);
+    if (spec.contains("burst")) {
+        const auto& burst = spec["burst"];
+        profile.burst_period_sec = burst.value("period_sec", 0.0);
+        profile.burst_duration_sec = burst.value("duration_sec", 0.0);
+        profile.burst_multiplier = burst.value("multiplier", 1.0);
+    }
+    for (const auto& plmn : spec.value("plmn_mix", nlohmann::json::array())) {
+        profile.plmns.push_back({plmn.at("plmn").get<std::string>(), plmn.value("weight", 1.0)});
+    }
+    if (profile.plmns.empty()) {
+        profile.plmns.push_back({"25001", 1.0});
+    }
+
+    if (profile.duration_sec <= 0 || profile.mean_rate <= 0 || profile.subscribers == 0) {
+        throw std::runtime_error("duration_sec, mean_rate and subscribers must be positive");
+    }
+    if (profile.zipf_exponent < 0) {
+        throw std::runtime_error("zipf_exponent cannot be negative");
+    }
+    if (profile.blacklist_ratio < 0 || profile.blacklist_ratio > 1 ||
+        (profile.blacklist_ratio > 0 && profile.blacklist_size == 0)) {
+        throw std::runtime_error("blacklist_ratio must be in [0, 1] with a non-empty blacklist");
+    }
+    if (profile.burst_period_sec < 0 || profile.burst_duration_sec < 0 ||
+        profile.burst_duration_sec > profile.burst_period_sec || profile.burst_multiplier < 1) {
+        throw std::runtime_error("burst: 0 <= duration_sec <= period_sec, multiplier >= 1");
+    }
+    for (const auto& plmn : profile.plmns) {
+        if (plmn.prefix.size() < 5 || plmn.prefix.size() > 6 ||
+            !std::all_of(plmn.prefix.begin(), plmn.prefix.end(), ::isdigit) || plmn.weight < 0) {
+            throw std::runtime_error("Invalid PLMN in plmn_mix: " + plmn.prefix);
+        }
+    }
+    profile.plmns.erase(std::remove_if(profile.plmns.begin(), profile.plmns.end(),
+                                       [](const Plmn& plmn) { return plmn.weight == 0; }),
+                        profile.plmns.end());
+    if (profile.plmns.empty()) {
+        throw std::runtime_error("plmn_mix weights sum to zero");
+    }
+    if (profile.duration_sec * profile.mean_rate > UINT32_MAX) {
+        throw std::runtime_error("trace too long: at most 2^32 requests");
+    }
+    return profile;
+}
+
+// Уникальные 15-значные IMSI: PLMN по весам смеси, MSIN случайный
+class ImsiFactory {
+public:
+    ImsiFactory(const Profile& profile, std::mt19937_64& rng)
+        : profile_(profile), rng_(rng) {
+        std::vector<double> weights;
+        for (const auto& plmn : profile.plmns) {
+            weights.push_back(plmn.weight);
+        }
+        plmn_choice_ = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+    }
+
+    uint64_t make() {
+        for (;;) {
+            std::string digits = profile_.plmns[plmn_choice_(rng_)].prefix;
+            while (digits.size() < Imsi::kMaxLength) {
+                digits.push_back(static_cast<char>('0' + rng_() % 10));
+            }
+            const uint64_t key = Imsi::parse(digits)->key();
+            if (used_.insert(key).second) return key;
+        }
+    }
+
+private:
+    const Profile& profile_;
+    std::mt19937_64& rng_;
+    std::discrete_distribution<size_t> plmn_choice_;
+    std::unordered_set<uint64_t> used_;
+};
+
+// Ранг абонента по закону Ципфа: P(k) ~ 1 / (k + 1)^s, выбор по таблице CDF
+class ZipfDistribution {
+public:
+    ZipfDistribution(uint32_t n, double exponent) : cdf_(n) {
+        double sum = 0;
+        for (uint32_t k = 0; k < n; ++k) {
+            sum += 1.0 / std::pow(static_cast<double>(k) + 1.0, exponent);
+            cdf_[k] = sum;
+        }
+        for (double& value : cdf_) {
+            value /= sum;
+        }
+    }
+
+    uint32_t operator()(std::mt19937_64& rng) const {
+        const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        const auto it = std::lower_bound(cdf_.begin(), cdf_.end(), u);
+        return static_cast<uint32_t>(std::min<size_t>(it - cdf_.begin(), cdf_.size() - 1));
+    }
+
+private:
+    std::vector<double> cdf_;
+};
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " <profile.json> <output.trace>\n"
+              << "Profile keys (all optional):\n"
+              << "  seed, duration_sec, mean_rate, subscribers, zipf_exponent,\n"
+              << "  plmn_mix [{\"plmn\": \"25001\", \"weight\": 0.6}, ...],\n"
+              << "  burst {\"period_sec\", \"duration_sec\", \"multiplier\"},\n"
+              << "  blacklist_size, blacklist_ratio\n"
+              << "Example:\n"
+              << "  " << program_name << " configs/trace_profile.json traffic.trace\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const std::string output_path = argv[2];
+
+    Profile profile;
+    std::string spec;
+    try {
+        profile = load_profile(argv[1]);
+        std::ifstream file(argv[1]);
+        spec = nlohmann::json::parse(file).dump();
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid profile: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::mt19937_64 rng(profile.seed);
+    ImsiFactory factory(profile, rng);
+    std::vector<uint64_t> identities(profile.subscribers + profile.blacklist_size);
+    for (auto& identity : identities) {
+        identity = factory.make();
+    }
+    // Чёрный список - последние blacklist_size личностей
+    for (uint32_t i = 0; i < profile.blacklist_size; ++i) {
+        identities[profile.subscribers + i] |= traffic_trace::kBlacklistedBit;
+    }
+
+    const ZipfDistribution zipf(profile.subscribers, profile.zipf_exponent);
+    std::uniform_int_distribution<uint32_t> blacklisted(0, std::max<uint32_t>(profile.blacklist_size, 1) - 1);
+    std::bernoulli_distribution blacklist_hit(profile.blacklist_ratio);
+
+    // Неоднородный пуассоновский поток методом прореживания: кандидаты с пиковой
+    // частотой, принимается доля rate(t) / peak
+    const double base_rate = profile.base_rate();
+    const double peak_rate = base_rate * profile.burst_multiplier;
+    std::exponential_distribution<double> gap(peak_rate);
+    std::uniform_real_distribution<double> accept(0.0, peak_rate);
+
+    traffic_trace::Trace trace;
+    trace.spec = spec;
+    std::vector<int64_t> dictionary_index(identities.size(), -1);
+    trace.records.reserve(static_cast<size_t>(profile.duration_sec * profile.mean_rate * 4));
+    uint64_t blacklist_requests = 0;
+    uint64_t last_ns = 0;
+
+    for (double t = gap(rng); t < profile.duration_sec; t += gap(rng)) {
+        const double rate = profile.in_burst(t) ? peak_rate : base_rate;
+        if (accept(rng) >= rate) continue;
+
+        uint32_t identity;
+        if (blacklist_hit(rng)) {
+            identity = profile.subscribers + blacklisted(rng);
+            ++blacklist_requests;
+        } else {
+            identity = zipf(rng);
+        }
+        if (dictionary_index[identity] < 0) {
+            dictionary_index[identity] = static_cast<int64_t>(trace.dictionary.size());
+            trace.dictionary.push_back(identities[identity]);
+        }
+
+        const auto now_ns = static_cast<uint64_t>(t * 1e9);
+        traffic_trace::put_varint(trace.records, now_ns - last_ns);
+        traffic_trace::put_varint(trace.records, static_cast<uint64_t>(dictionary_index[identity]));
+        last_ns = now_ns;
+        ++trace.record_count;
+    }
+    trace.duration_ns = last_ns;
+
+    nlohmann::json blacklist = nlohmann::json::array();
+    for (uint32_t i = 0; i < profile.blacklist_size; ++i) {
+        const uint64_t entry = identities[profile.subscribers + i];
+        blacklist.push_back(traffic_trace::Trace::imsi(entry).to_string());
+    }
+
+    try {
+        traffic_trace::save(output_path, trace);
+        std::ofstream(output_path + ".blacklist.json") << blacklist.dump(2) << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    const auto file_size = std::filesystem::file_size(output_path);
+    std::cout << std::fixed << std::setprecision(2)
+              << "Records:        " << trace.record_count << " over " << profile.duration_sec << " s\n"
+              << "Subscribers:    " << trace.dictionary.size() << " distinct of " << profile.subscribers << "\n"
+              << "Blacklisted:    " << blacklist_requests << " requests ("
+              << 100.0 * static_cast<double>(blacklist_requests) / static_cast<double>(std::max<uint64_t>(trace.record_count, 1))
+              << "%)\n"
+              << "Rate:           " << base_rate << " req/s, bursts " << peak_rate << " req/s\n"
+              << "File:           " << output_path << " (" << file_size << " bytes, "
+              << static_cast<double>(file_size) / static_cast<double>(std::max<uint64_t>(trace.record_count, 1))
+              << " bytes/request)\n"
+              << "Blacklist:      " << output_path << ".blacklist.json\n";
+    return 0;
+}
@@ -0,0 +1,373 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include "config/client_config.h"
+#include "metrics/latency.h"
+#include "network/request_tag.h"
+#include "traffic_trace.h"
+
+// Воспроизведение трассы trace_generator с ускорением 1x..Nx. Открытый цикл: каждый
+// запрос уходит в момент из трассы (делённый на speed) независимо от ответов. Точность
+// расписания видна в отчёте как отставание отправки от плана. Запросы тегированы
+// номером записи, ответы сопоставляются по тегу.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr auto kResponseTimeout = std::chrono::seconds(1);
+constexpr auto kMaxWait = std::chrono::milliseconds(1);
+constexpr int kMaxEvents = 64;
+constexpr int kSocketBufferBytes = 4 * 1024 * 1024;
+constexpr size_t kInFlightSlots = 1 << 18;     // на поток; перезаписанный слот - ответ не засчитан
+
+struct Options {
+    std::string config_path;
+    std::string trace_path;
+    double speed = 1.0;
+    unsigned threads = 2;
+    unsigned sockets_per_thread = 16;
+    bool json = false;
+};
+
+// Датаграмма с местом под тег
+struct WireImsi {
+    char bytes[RequestTag::kHeaderSize + Imsi::kMaxBcdBytes];
+    uint8_t size;
+    bool blacklisted;
+};
+
+struct InFlight {
+    uint32_t tag = 0;
+    bool active = false;
+    Clock::time_point scheduled;
+};
+
+struct ThreadStats {
+    LatencyHistogram latency;           // наносекунды от момента по расписанию
+    LatencyHistogram schedule_lag;      // наносекунды: фактическая отправка - расписание
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    uint64_t send_errors = 0;
+    uint64_t unexpected = 0;            // ответ на неизвестный или перезаписанный тег
+    uint64_t expected_rejects = 0;      // отправлено IMSI из чёрного списка
+    uint64_t created = 0;
+    uint64_t rejected = 0;
+    uint64_t errors = 0;
+};
+
+int open_socket(const sockaddr_in& server) {
+    int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+    }
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &kSocketBufferBytes, sizeof(kSocketBufferBytes));
+    if (::connect(fd, reinterpret_cast<const sockaddr*>(&server), sizeof(server)) < 0) {
+        const int error = errno;
+        ::close(fd);
+        throw std::runtime_error(std::string("connect: ") + std::strerror(error));
+    }
+    return fd;
+}
+
+void classify(ThreadStats& stats, std::string_view response) {
+    if (response == "created") {
+        ++stats.created;
+    } else if (response == "rejected") {
+        ++stats.rejected;
+    } else {
+        ++stats.errors;
+    }
+}
+
+// Записи трассы делятся между потоками по номеру: запись i - потоку i % threads.
+// Каждый поток читает трассу целиком своим курсором и пропускает чужие записи.
+void run_worker(unsigned index, const Options& options, const traffic_trace::Trace& trace,
+                const std::vector<WireImsi>& imsis, const sockaddr_in& server,
+                Clock::time_point start, ThreadStats& stats) {
+    ::prctl(PR_SET_TIMERSLACK, 1000UL);
+
+    std::vector<int> sockets(options.sockets_per_thread);
+    const int epoll_fd = ::epoll_create1(0);
+    for (int& fd : sockets) {
+        fd = open_socket(server);
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    std::vector<InFlight> in_flight(kInFlightSlots);
+    auto slot_of = [&](uint32_t tag) -> InFlight& {
+        return in_flight[(tag / options.threads) % kInFlightSlots];
+    };
+
+    traffic_trace::Cursor cursor(trace);
+    traffic_trace::Record record{};
+    uint64_t record_index = 0;
+    uint64_t trace_ns = 0;
+    bool have_next = false;
+    Clock::time_point next_send;
+
+    // Следующая своя запись и её момент по расписанию
+    auto advance = [&] {
+        have_next = false;
+        while (cursor.next(record)) {
+            trace_ns += record.delta_ns;
+            const uint64_t current = record_index++;
+            if (current % options.threads != index) continue;
+            next_send = start + std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::nano>(static_cast<double>(trace_ns) / options.speed));
+            have_next = true;
+            return current;
+        }
+        return uint64_t{0};
+    };
+    uint64_t next_index = advance();
+
+    size_t next_socket = 0;
+    Clock::time_point drain_deadline = Clock::time_point::max();
+    epoll_event events[kMaxEvents];
+    char buffer[256];
+
+    for (;;) {
+        auto now = Clock::now();
+
+        while (have_next && next_send <= now) {
+            const WireImsi& imsi = imsis[record.subscriber];
+            char datagram[sizeof(imsi.bytes)];
+            const auto tag = static_cast<uint32_t>(next_index);
+            RequestTag::write_header(tag, datagram);
+            std::memcpy(datagram + RequestTag::kHeaderSize, imsi.bytes + RequestTag::kHeaderSize,
+                        imsi.size - RequestTag::kHeaderSize);
+
+            const int fd = sockets[next_socket];
+            next_socket = (next_socket + 1) % sockets.size();
+            const auto sent_at = Clock::now();
+            if (::send(fd, datagram, imsi.size, 0) == imsi.size) {
+                InFlight& slot = slot_of(tag);
+                slot = InFlight{tag, true, next_send};
+                ++stats.sent;
+                if (imsi.blacklisted) ++stats.expected_rejects;
+            } else {
+                ++stats.send_errors;
+            }
+            stats.schedule_lag.record(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(sent_at - next_send).count()));
+            next_index = advance();
+        }
+
+        if (!have_next && drain_deadline == Clock::time_point::max()) {
+            drain_deadline = now + kResponseTimeout;
+        }
+        if (now >= drain_deadline || (!have_next && stats.received + stats.unexpected >= stats.sent)) {
+            break;
+        }
+
+        auto wait = have_next ? std::min<Clock::duration>(next_send - now, kMaxWait) : Clock::duration(kMaxWait);
+        if (wait < Clock::duration::zero()) wait = Clock::duration::zero();
+        const timespec timeout{0, static_cast<long>(std::chrono::nanoseconds(wait).count())};
+        const int ready = ::epoll_pwait2(epoll_fd, events, kMaxEvents, &timeout, nullptr);
+        if (ready <= 0) continue;
+
+        now = Clock::now();
+        for (int i = 0; i < ready; ++i) {
+            for (;;) {
+                const ssize_t received = ::recv(events[i].data.fd, buffer, sizeof(buffer), 0);
+                if (received < 0) break;
+                uint32_t tag = 0;
+                std::string_view body;
+                if (!RequestTag::parse(std::string_view(buffer, static_cast<size_t>(received)), tag, body)) {
+                    ++stats.unexpected;
+                    continue;
+                }
+                InFlight& slot = slot_of(tag);
+                if (!slot.active || slot.tag != tag) {
+                    ++stats.unexpected;
+                    continue;
+                }
+                slot.active = false;
+                ++stats.received;
+                stats.latency.record(static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(now - slot.scheduled).count()));
+                classify(stats, body);
+            }
+        }
+    }
+
+    for (int fd : sockets) {
+        ::close(fd);
+    }
+    ::close(epoll_fd);
+}
+
+void print_usage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " <config_path> <trace> [speed] [threads] [sockets] [json]\n"
+              << "Arguments:\n"
+              << "  config_path  Path to client config file (server_ip, server_port)\n"
+              << "  trace        Trace written by trace_generator\n"
+              << "  speed        Replay speed multiplier (default: 1)\n"
+              << "  threads      Event-loop threads (default: 2)\n"
+              << "  sockets      UDP sockets per thread (default: 16)\n"
+              << "  json         Print the report as JSON (0/1, default: 0)\n\n"
+              << "Example:\n"
+              << "  " << program_name << " config.json traffic.trace 4 4 32\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 3 || argc > 7) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    Options options;
+    options.config_path = argv[1];
+    options.trace_path = argv[2];
+    try {
+        if (argc > 3) options.speed = std::stod(argv[3]);
+        if (argc > 4) options.threads = static_cast<unsigned>(std::stoul(argv[4]));
+        if (argc > 5) options.sockets_per_thread = static_cast<unsigned>(std::stoul(argv[5]));
+        if (argc > 6) options.json = std::stoi(argv[6]) != 0;
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (options.speed <= 0 || options.threads == 0 || options.sockets_per_thread == 0) {
+        std::cerr << "speed, threads and sockets must be positive\n";
+        return 1;
+    }
+
+    sockaddr_in server{};
+    traffic_trace::Trace trace;
+    std::vector<WireImsi> imsis;
+    try {
+        ClientConfig config(options.config_path);
+        server.sin_family = AF_INET;
+        server.sin_port = htons(static_cast<uint16_t>(config.get_server_port()));
+        if (::inet_pton(AF_INET, config.get_server_ip().c_str(), &server.sin_addr) != 1) {
+            throw std::runtime_error("Invalid server_ip: " + config.get_server_ip());
+        }
+
+        trace = traffic_trace::load(options.trace_path);
+        // Словарь кодируется заранее: на пути отправки только тег и memcpy
+        imsis.resize(trace.dictionary.size());
+        for (size_t i = 0; i < trace.dictionary.size(); ++i) {
+            uint8_t bcd[Imsi::kMaxBcdBytes];
+            const size_t size = traffic_trace::Trace::imsi(trace.dictionary[i]).to_bcd(bcd);
+            std::memcpy(imsis[i].bytes + RequestTag::kHeaderSize, bcd, size);
+            imsis[i].size = static_cast<uint8_t>(RequestTag::kHeaderSize + size);
+            imsis[i].blacklisted = traffic_trace::Trace::blacklisted(trace.dictionary[i]);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load config or trace: " << e.what() << "\n";
+        return 1;
+    }
+
+    const double replay_seconds = static_cast<double>(trace.duration_ns) / 1e9 / options.speed;
+    if (!options.json) {
+        std::cout << "Replaying " << trace.record_count << " requests (" << trace.dictionary.size()
+                  << " subscribers) at " << options.speed << "x: " << replay_seconds << " s from "
+                  << options.threads << " threads x " << options.sockets_per_thread << " sockets\n";
+    }
+
+    std::vector<std::unique_ptr<ThreadStats>> stats;
+    for (unsigned i = 0; i < options.threads; ++i) {
+        stats.push_back(std::make_unique<ThreadStats>());
+    }
+
+    const auto start = Clock::now() + std::chrono::milliseconds(50);
+    std::vector<std::thread> workers;
+    for (unsigned i = 0; i < options.threads; ++i) {
+        workers.emplace_back([&, i] {
+            try {
+                run_worker(i, options, trace, imsis, server, start, *stats[i]);
+            } catch (const std::exception& e) {
+                std::cerr << "Worker " << i << " failed: " << e.what() << "\n";
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    LatencyHistogram latency;
+    LatencyHistogram schedule_lag;
+    ThreadStats total;
+    for (const auto& s : stats) {
+        latency.merge(s->latency);
+        schedule_lag.merge(s->schedule_lag);
+        total.sent += s->sent;
+        total.received += s->received;
+        total.send_errors += s->send_errors;
+        total.unexpected += s->unexpected;
+        total.expected_rejects += s->expected_rejects;
+        total.created += s->created;
+        total.rejected += s->rejected;
+        total.errors += s->errors;
+    }
+
+    const uint64_t lost = total.sent - std::min(total.sent, total.received);
+    const double target_rate = replay_seconds > 0 ? static_cast<double>(trace.record_count) / replay_seconds : 0;
+    auto micros = [](uint64_t nanos) { return static_cast<double>(nanos) / 1000.0; };
+
+    nlohmann::json report = {
+        {"speed", options.speed},
+        {"replay_sec", replay_seconds},
+        {"target_rate", target_rate},
+        {"records", trace.record_count},
+        {"subscribers", trace.dictionary.size()},
+        {"sent", total.sent},
+        {"received", total.received},
+        {"lost", lost},
+        {"send_errors", total.send_errors},
+        {"unexpected", total.unexpected},
+        {"responses", {{"created", total.created}, {"rejected", total.rejected},
+                       {"expected_rejected", total.expected_rejects}, {"other", total.errors}}},
+        {"schedule_lag_us", {
+            {"p50", micros(schedule_lag.value_at_percentile(50.0))},
+            {"p99", micros(schedule_lag.value_at_percentile(99.0))},
+            {"max", micros(schedule_lag.max())}
+        }},
+        {"latency_us", {
+            {"p50", micros(latency.value_at_percentile(50.0))},
+            {"p99", micros(latency.value_at_percentile(99.0))},
+            {"p99.9", micros(latency.value_at_percentile(99.9))},
+            {"max", micros(latency.max())}
+        }}
+    };
+
+    if (options.json) {
+        std::cout << report.dump(2) << "\n";
+        return 0;
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "\nTarget rate:    " << target_rate << " req/s average\n"
+              << "Sent: " << total.sent << ", received: " << total.received << ", lost: " << lost
+              << ", send errors: " << total.send_errors << ", unexpected: " << total.unexpected << "\n"
+              << "Responses: created " << total.created << ", rejected " << total.rejected
+              << " (blacklisted in trace " << total.expected_rejects << "), other " << total.errors << "\n"
+              << "Schedule lag p50/p99/max: " << micros(schedule_lag.value_at_percentile(50.0)) << " / "
+              << micros(schedule_lag.value_at_percentile(99.0)) << " / " << micros(schedule_lag.max()) << " us\n"
+              << "Latency p50:    " << micros(latency.value_at_percentile(50.0)) << " us\n"
+              << "Latency p99:    " << micros(latency.value_at_percentile(99.0)) << " us\n"
+              << "Latency p99.9:  " << micros(latency.value_at_percentile(99.9)) << " us\n"
+              << "Latency max:    " << micros(latency.max()) << " us\n";
+    return 0;
+}
@@ -0,0 +1,172 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "utils/imsi.h"
+
+// Бинарная трасса трафика (trace_generator -> trace_replay). Little-endian:
+//
+//   magic "PGWTRACE", u32 version, u32 spec_size, spec (JSON параметров генератора),
+//   u64 record_count, u64 duration_ns, u32 dictionary_size,
+//   dictionary: u64 на абонента - Imsi::key(), старший бит - IMSI в чёрном списке,
+//   records: varint(пауза после предыдущего запроса, нс), varint(индекс в dictionary)
+//
+// Словарь упорядочен по первому появлению: частые абоненты получают малые индексы,
+// и типичная запись занимает 4-6 байт.
+namespace traffic_trace {
+
+static_assert(std::endian::native == std::endian::little, "trace format is little-endian");
+
+inline constexpr char kMagic[8] = {'P', 'G', 'W', 'T', 'R', 'A', 'C', 'E'};
+inline constexpr uint32_t kVersion = 1;
+inline constexpr uint64_t kBlacklistedBit = uint64_t{1} << 63;
+
+struct Record {
+    uint64_t delta_ns;      // от предыдущего запроса
+    uint32_t subscriber;    // индекс в dictionary
+};
+
+struct Trace {
+    std::string spec;
+    uint64_t record_count = 0;
+    uint64_t duration_ns = 0;
+    std::vector<uint64_t> dictionary;
+    std::vector<uint8_t> records;   // закодированные записи
+
+    static bool blacklisted(uint64_t entry) noexcept { return (entry & kBlacklistedBit) != 0; }
+
+    static Imsi imsi(uint64_t entry) {
+        const auto imsi = Imsi::from_key(entry & ~kBlacklistedBit);
+        if (!imsi) {
+            throw std::runtime_error("corrupted trace dictionary entry");
+        }
+        return *imsi;
+    }
+};
+
+inline void put_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Последовательное чтение записей; каждый поток воспроизведения идёт своим курсором
+class Cursor {
+public:
+    explicit Cursor(const Trace& trace) noexcept
+        : data_(trace.records.data()), end_(trace.records.data() + trace.records.size()) {}
+
+    bool next(Record& record) noexcept {
+        uint64_t delta = 0;
+        uint64_t subscriber = 0;
+        if (!get_varint(delta) || !get_varint(subscriber) || subscriber > UINT32_MAX) return false;
+        record.delta_ns = delta;
+        record.subscriber = static_cast<uint32_t>(subscriber);
+        return true;
+    }
+
+private:
+    bool get_varint(uint64_t& value) noexcept {
+        value = 0;
+        for (unsigned shift = 0; data_ < end_ && shift < 64; shift += 7) {
+            const uint8_t byte = *data_++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+
+    const uint8_t* data_;
+    const uint8_t* end_;
+};
+
+namespace detail {
+
+template<typename T>
+void write_pod(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<typename T>
+T read_pod(std::ifstream& in) {
+    T value{};
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(value))) {
+        throw std::runtime_error("truncated trace header");
+    }
+    return value;
+}
+
+} // namespace detail
+
+inline void save(const std::string& path, const Trace& trace) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot create trace file: " + path);
+    }
+    out.write(kMagic, sizeof(kMagic));
+    detail::write_pod(out, kVersion);
+    detail::write_pod(out, static_cast<uint32_t>(trace.spec.size()));
+    out.write(trace.spec.data(), static_cast<std::streamsize>(trace.spec.size()));
+    detail::write_pod(out, trace.record_count);
+    detail::write_pod(out, trace.duration_ns);
+    detail::write_pod(out, static_cast<uint32_t>(trace.dictionary.size()));
+    out.write(reinterpret_cast<const char*>(trace.dictionary.data()),
+              static_cast<std::streamsize>(trace.dictionary.size() * sizeof(uint64_t)));
+    out.write(reinterpret_cast<const char*>(trace.records.data()),
+              static_cast<std::streamsize>(trace.records.size()));
+    if (!out) {
+        throw std::runtime_error("Failed to write trace file: " + path);
+    }
+}
+
+inline Trace load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open trace file: " + path);
+    }
+    char magic[sizeof(kMagic)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Not a PGW trace file: " + path);
+    }
+    if (detail::read_pod<uint32_t>(in) != kVersion) {
+        throw std::runtime_error("Unsupported trace version: " + path);
+    }
+
+    Trace trace;
+    trace.spec.resize(detail::read_pod<uint32_t>(in));
+    in.read(trace.spec.data(), static_cast<std::streamsize>(trace.spec.size()));
+    trace.record_count = detail::read_pod<uint64_t>(in);
+    trace.duration_ns = detail::read_pod<uint64_t>(in);
+    trace.dictionary.resize(detail::read_pod<uint32_t>(in));
+    if (!in.read(reinterpret_cast<char*>(trace.dictionary.data()),
+                 static_cast<std::streamsize>(trace.dictionary.size() * sizeof(uint64_t)))) {
+        throw std::runtime_error("truncated trace dictionary");
+    }
+    trace.records.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    // Индексы проверяются один раз здесь: воспроизведение берёт dictionary[subscriber] без проверки
+    Cursor cursor(trace);
+    Record record{};
+    uint64_t count = 0;
+    while (cursor.next(record)) {
+        if (record.subscriber >= trace.dictionary.size()) {
+            throw std::runtime_error("trace record " + std::to_string(count) + " references subscriber " +
+                                     std::to_string(record.subscriber) + " outside the dictionary");
+        }
+        ++count;
+    }
+    if (count != trace.record_count) {
+        throw std::runtime_error("truncated trace records");
+    }
+    return trace;
+}
+
+} // namespace traffic_trace
@@ -0,0 +1,18 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include "utils/imsi.h"
+
+// IMSI тестов, бенчмарков и нагрузочных утилит: n-й абонент, разные n дают разные IMSI
+
+// 15-значный IMSI: MCC/MNC 250-01 и 10-значный номер абонента
+inline std::string imsi_string(uint64_t n) {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "25001%010llu", static_cast<unsigned long long>(n % 10'000'000'000ULL));
+    return buffer;
+}
+
+inline Imsi make_imsi(uint64_t n) {
+    return *Imsi::parse(imsi_string(n));
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <filesystem>
+#include <string>
+#include "test_imsi.h"
+
+// Пустой каталог во временной папке на время теста; имя уникально для процесса
+class TempDirTest : public ::testing::Test {
+protected:
+    std::string dir;
+
+    explicit TempDirTest(std::string prefix) : prefix_(std::move(prefix)) {}
+
+    void SetUp() override {
+        dir = (std::filesystem::temp_directory_path() / (prefix_ + std::to_string(::getpid()))).string();
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+private:
+    std::string prefix_;
+};
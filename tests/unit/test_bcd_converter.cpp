@@ -1,5 +1,9 @@
 
 #include "utils/bcd_converter.h"
+#include "utils/bcd_batch.h"
+#include "utils/imsi.h"
+#include <algorithm>
+#include <random>
 #include <gtest/gtest.h>
 
 TEST(BCDConverterTest, ValidateIMSI) {
@@ -55,4 +59,98 @@ TEST(BCDConverterTest, RoundConversion) {
     auto converted = BCDConverter::bcd_to_imsi(bcd);
 
     EXPECT_EQ(original, converted);
-}
\ No newline at end of file
+}
+
+TEST(ImsiTest, ParseAndBcdRoundTrip) {
+    using namespace imsi_literals;
+
+    for (const std::string text : {"001010123456789", "1234567890", "00000000000000"}) {
+        const auto imsi = Imsi::parse(text);
+        ASSERT_TRUE(imsi.has_value()) << text;
+        EXPECT_EQ(imsi->to_string(), text);
+
+        uint8_t bcd[Imsi::kMaxBcdBytes];
+        const size_t size = imsi->to_bcd(bcd);
+        EXPECT_EQ(std::vector<uint8_t>(bcd, bcd + size), BCDConverter::imsi_to_bcd(text));
+        EXPECT_EQ(Imsi::from_bcd(std::span<const uint8_t>(bcd, size)), imsi);
+    }
+
+    // Ведущие нули значимы
+    EXPECT_NE("0123456789"_imsi, "00123456789"_imsi);
+
+    EXPECT_EQ(Imsi::parse("12345").error(), ImsiError::BadLength);
+    EXPECT_EQ(Imsi::parse("1234567890123456").error(), ImsiError::BadLength);
+    EXPECT_EQ(Imsi::parse("12345a678901234").error(), ImsiError::NonDigit);
+    const uint8_t bad[] = {0x21, 0x43, 0x65, 0x87, 0xA9};
+    EXPECT_EQ(Imsi::from_bcd(bad).error(), ImsiError::BadBcd);
+}
+
+TEST(BCDBatchTest, KernelsMatchScalarConverter) {
+    ImsiBatch batch;
+    std::mt19937 rng(42);
+    for (int i = 0; i < 1001; ++i) {
+        std::string imsi;
+        const size_t length = 8 + rng() % 10;   // 8..17: часть вне допустимой длины
+        for (size_t d = 0; d < length; ++d) imsi += static_cast<char>('0' + rng() % 10);
+        if (i % 7 == 0) imsi[rng() % length] = "a/:x"[rng() % 4];
+        batch.push_back(imsi);
+    }
+
+    const BCDBatch::Isa isas[] = {BCDBatch::Isa::Scalar, BCDBatch::Isa::Sse41, BCDBatch::Isa::Avx2};
+    for (const auto isa : isas) {
+        SCOPED_TRACE(BCDBatch::isa_name(isa));
+
+        std::vector<uint8_t> valid(batch.size());
+        BCDBatch::validate(batch, valid.data(), isa);
+
+        ImsiBatch good;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            ASSERT_EQ(valid[i] != 0, BCDConverter::validate_imsi(batch.at(i))) << batch.at(i);
+            if (valid[i]) good.push_back(batch.at(i));
+        }
+
+        std::vector<uint8_t> bcd(good.size() * ImsiBatch::kBcdSlot);
+        BCDBatch::encode(good, bcd.data(), isa);
+
+        std::vector<uint64_t> keys(good.size());
+        BCDBatch::pack_keys(good, keys.data(), isa);
+
+        ImsiBatch decoded;
+        BCDBatch::decode(bcd.data(), good.size(), decoded, isa);
+        for (size_t i = 0; i < good.size(); ++i) {
+            const auto expected = BCDConverter::imsi_to_bcd(std::string(good.at(i)));
+            ASSERT_TRUE(std::equal(expected.begin(), expected.end(), bcd.begin() + i * ImsiBatch::kBcdSlot));
+            ASSERT_EQ(decoded.at(i), good.at(i));
+            ASSERT_EQ(keys[i], Imsi::parse(good.at(i))->key()) << good.at(i);
+        }
+    }
+}
+
+TEST(BCDBatchTest, ParseMatchesImsiParse) {
+    const std::vector<std::string> texts = {
+        "001010123456789", "0000000000", "999999999999999", "12345", "1234567890123456",
+        "12345a678901234", "", "250010000000001", "00101012345678901234"
+    };
+    for (const auto isa : {BCDBatch::Isa::Scalar, BCDBatch::Isa::Sse41, BCDBatch::Isa::Avx2}) {
+        SCOPED_TRACE(BCDBatch::isa_name(isa));
+        const auto imsis = BCDBatch::parse(texts, isa);
+        ASSERT_EQ(imsis.size(), texts.size());
+        for (size_t i = 0; i < texts.size(); ++i) {
+            EXPECT_EQ(imsis[i], Imsi::parse(texts[i]).value_or(Imsi{})) << texts[i];
+        }
+    }
+}
+
+TEST(BCDBatchTest, DecodeRejectsMalformedBcd) {
+    // 0xA посреди номера, слишком короткий номер, 16 цифр без терминатора
+    const uint8_t bcd[3][ImsiBatch::kBcdSlot] = {
+        {0x21, 0x43, 0x6A, 0x87, 0x09, 0x21, 0x43, 0xF5},
+        {0x21, 0x43, 0xF5, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF},
+        {0x21, 0x43, 0x65, 0x87, 0x09, 0x21, 0x43, 0x65},
+    };
+    for (const auto isa : {BCDBatch::Isa::Scalar, BCDBatch::Isa::Sse41, BCDBatch::Isa::Avx2}) {
+        ImsiBatch out;
+        BCDBatch::decode(&bcd[0][0], 3, out, isa);
+        EXPECT_EQ(out.lengths, (std::vector<uint8_t>{0, 0, 0})) << BCDBatch::isa_name(isa);
+    }
+}
@@ -0,0 +1,188 @@
+#include "http/cdr_export_server.h"
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace {
+
+struct HttpResponse {
+    int status = 0;
+    std::string headers;
+    std::string body;
+};
+
+class CdrExportServerTest : public ::testing::Test {
+protected:
+    const std::filesystem::path dir = "test_cdr_export";
+    std::shared_ptr<CdrManager> cdr;
+    std::unique_ptr<CdrExportServer> server;
+    std::string segment;        // имя первого закрытого сегмента
+    std::string content;        // его содержимое
+    int port = 0;
+
+    void SetUp() override {
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+
+        // Маленький сегмент: записи расходятся по нескольким закрытым файлам
+        cdr = std::make_shared<CdrManager>((dir / "cdr.log").string(), 512);
+        for (int i = 0; i < 100; ++i) {
+            cdr->add_record(*Imsi::parse("123456789" + std::to_string(i % 7)), "created");
+            cdr->flush();
+        }
+        const auto segments = cdr->list_segments();
+        ASSERT_FALSE(segments.empty());
+        segment = segments.front().name;
+        std::ifstream file(segments.front().path, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        ASSERT_GT(content.size(), 100u);
+
+        server = std::make_unique<CdrExportServer>(0, "127.0.0.1", cdr);
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        ASSERT_EQ(::getsockname(server->socket_fd(), reinterpret_cast<sockaddr*>(&addr), &len), 0);
+        port = ntohs(addr.sin_port);
+        server->start();
+    }
+
+    void TearDown() override {
+        server.reset();
+        cdr.reset();
+        std::filesystem::remove_all(dir);
+    }
+
+    // Запрос целиком и ответ до закрытия соединения сервером
+    HttpResponse request(const std::string& method, const std::string& target, const std::string& range = "") {
+        const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+        EXPECT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+
+        std::string text = method + " " + target + " HTTP/1.1\r\nHost: localhost\r\n";
+        if (!range.empty()) {
+            text += "Range: " + range + "\r\n";
+        }
+        text += "\r\n";
+        EXPECT_EQ(::send(fd, text.data(), text.size(), 0), static_cast<ssize_t>(text.size()));
+
+        std::string raw;
+        char buffer[4096];
+        ssize_t n;
+        while ((n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+            raw.append(buffer, static_cast<size_t>(n));
+        }
+        ::close(fd);
+
+        HttpResponse response;
+        const size_t header_end = raw.find("\r\n\r\n");
+        if (raw.size() < 12 || header_end == std::string::npos) return response;
+        response.status = std::stoi(raw.substr(9, 3));
+        response.headers = raw.substr(0, header_end);
+        response.body = raw.substr(header_end + 4);
+        return response;
+    }
+
+    std::string path() const {
+        return "/cdr_export/" + segment;
+    }
+};
+
+} // namespace
+
+TEST_F(CdrExportServerTest, WholeSegment) {
+    const auto response = request("GET", path());
+    EXPECT_EQ(response.status, 200);
+    EXPECT_EQ(response.body, content);
+    EXPECT_NE(response.headers.find("Accept-Ranges: bytes"), std::string::npos);
+}
+
+TEST_F(CdrExportServerTest, ClosedRange) {
+    const auto response = request("GET", path(), "bytes=10-29");
+    EXPECT_EQ(response.status, 206);
+    EXPECT_EQ(response.body, content.substr(10, 20));
+    EXPECT_NE(response.headers.find("Content-Range: bytes 10-29/" + std::to_string(content.size())),
+              std::string::npos);
+
+    // Конец за пределами файла обрезается до последнего байта
+    const auto clipped = request("GET", path(), "bytes=10-999999");
+    EXPECT_EQ(clipped.status, 206);
+    EXPECT_EQ(clipped.body, content.substr(10));
+}
+
+TEST_F(CdrExportServerTest, SuffixRange) {
+    const auto response = request("GET", path(), "bytes=-16");
+    EXPECT_EQ(response.status, 206);
+    EXPECT_EQ(response.body, content.substr(content.size() - 16));
+
+    // Суффикс длиннее файла - весь файл
+    const auto whole = request("GET", path(), "bytes=-999999");
+    EXPECT_EQ(whole.status, 206);
+    EXPECT_EQ(whole.body, content);
+}
+
+TEST_F(CdrExportServerTest, OpenEndedRangeAndOffset) {
+    const auto range = request("GET", path(), "bytes=50-");
+    EXPECT_EQ(range.status, 206);
+    EXPECT_EQ(range.body, content.substr(50));
+
+    const auto offset = request("GET", path() + "?offset=50");
+    EXPECT_EQ(offset.status, 206);
+    EXPECT_EQ(offset.body, content.substr(50));
+}
+
+TEST_F(CdrExportServerTest, UnsatisfiableRangeIs416) {
+    const std::string size = std::to_string(content.size());
+
+    const auto past_end = request("GET", path(), "bytes=" + size + "-");
+    EXPECT_EQ(past_end.status, 416);
+    EXPECT_NE(past_end.headers.find("Content-Range: bytes */" + size), std::string::npos);
+    EXPECT_TRUE(past_end.body.empty());
+
+    EXPECT_EQ(request("GET", path(), "bytes=30-20").status, 416);
+    EXPECT_EQ(request("GET", path() + "?offset=" + size).status, 416);
+    EXPECT_EQ(request("GET", path() + "?offset=99999999").status, 416);
+}
+
+TEST_F(CdrExportServerTest, MalformedRangeIs400) {
+    EXPECT_EQ(request("GET", path(), "bytes=abc").status, 400);
+    EXPECT_EQ(request("GET", path(), "bytes=a-b").status, 400);
+    EXPECT_EQ(request("GET", path(), "bytes=-").status, 400);
+    EXPECT_EQ(request("GET", path() + "?offset=-5").status, 400);
+
+    // Несколько диапазонов не поддерживаются: отдаётся весь сегмент
+    const auto multi = request("GET", path(), "bytes=0-1,5-6");
+    EXPECT_EQ(multi.status, 200);
+    EXPECT_EQ(multi.body, content);
+}
+
+TEST_F(CdrExportServerTest, HeadHasHeadersOnly) {
+    const auto response = request("HEAD", path());
+    EXPECT_EQ(response.status, 200);
+    EXPECT_NE(response.headers.find("Content-Length: " + std::to_string(content.size())), std::string::npos);
+    EXPECT_TRUE(response.body.empty());
+
+    const auto partial = request("HEAD", path(), "bytes=0-9");
+    EXPECT_EQ(partial.status, 206);
+    EXPECT_NE(partial.headers.find("Content-Length: 10"), std::string::npos);
+    EXPECT_TRUE(partial.body.empty());
+}
+
+TEST_F(CdrExportServerTest, UnknownAndActiveSegmentsAre404) {
+    EXPECT_EQ(request("GET", "/cdr_export/cdr.log.999999").status, 404);
+    EXPECT_EQ(request("GET", "/other").status, 404);
+    EXPECT_EQ(request("POST", path()).status, 405);
+
+    // Текущий файл ещё дописывается: выгружаются только закрытые сегменты
+    const std::string active = std::filesystem::path(cdr->active_file()).filename().string();
+    EXPECT_EQ(request("GET", "/cdr_export/" + active).status, 404);
+}
@@ -0,0 +1,90 @@
+#include "cdr/cdr_manager.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <memory>
+
+using namespace imsi_literals;
+
+class CdrManagerTest : public ::testing::Test {
+protected:
+    const std::filesystem::path dir = "test_cdr_segments";
+    std::string cdr_file;
+
+    void SetUp() override {
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        cdr_file = (dir / "cdr.log").string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+};
+
+TEST_F(CdrManagerTest, IndexKeyKeepsLeadingZeros) {
+    EXPECT_NE(CdrSegmentIndex::make_key("001010123456789"), CdrSegmentIndex::make_key("1010123456789"));
+    EXPECT_EQ(CdrSegmentIndex::make_key("12a"), 0u);
+    EXPECT_EQ(CdrSegmentIndex::make_key("12345"), 0u);
+    EXPECT_EQ(CdrSegmentIndex::make_key("001010123456789"), "001010123456789"_imsi.key());
+    EXPECT_EQ(CdrSegmentIndex::key_from_record("2024-01-01 00:00:00,1234567890,created"),
+              CdrSegmentIndex::make_key("1234567890"));
+}
+
+TEST_F(CdrManagerTest, HistoryAcrossClosedSegments) {
+    {
+        // Маленький сегмент, чтобы записи разошлись по нескольким файлам
+        CdrManager cdr(cdr_file, 256);
+        for (int i = 0; i < 50; ++i) {
+            cdr.add_record(*Imsi::parse("123456789" + std::to_string(i % 5)), i < 45 ? "created" : "expired");
+        }
+    }
+
+    CdrManager cdr(cdr_file, 256);
+    EXPECT_TRUE(std::filesystem::exists(cdr_file + ".000001.idx"));
+
+    auto records = cdr.find_records("1234567890"_imsi, 100);
+    ASSERT_EQ(records.size(), 10u);
+    EXPECT_NE(records.back().find(",1234567890,expired"), std::string::npos);
+
+    EXPECT_EQ(cdr.find_records("1234567890"_imsi, 3).size(), 3u);
+    EXPECT_TRUE(cdr.find_records("999999999999"_imsi, 100).empty());
+}
+
+TEST_F(CdrManagerTest, RebuildsMissingIndex) {
+    {
+        CdrManager cdr(cdr_file, 128);
+        for (int i = 0; i < 20; ++i) {
+            cdr.add_record("1234567890"_imsi, "prolonged");
+        }
+    }
+    std::filesystem::remove(cdr_file + ".000001.idx");
+
+    CdrManager cdr(cdr_file, 128);
+    EXPECT_TRUE(std::filesystem::exists(cdr_file + ".000001.idx"));
+    EXPECT_EQ(cdr.find_records("1234567890"_imsi, 100).size(), 20u);
+}
+
+TEST_F(CdrManagerTest, ResyncPicksUpRecordsOfPreviousProcess) {
+    auto previous = std::make_unique<CdrManager>(cdr_file, 256);
+    for (int i = 0; i < 5; ++i) {
+        previous->add_record("1234567890"_imsi, "created");
+    }
+    previous->flush();
+
+    // Новый процесс открывает файлы, пока прежний ещё пишет и закрывает сегменты
+    CdrManager cdr(cdr_file, 256);
+    for (int i = 0; i < 20; ++i) {
+        previous->add_record("1234567890"_imsi, "prolonged");
+    }
+    previous.reset();
+
+    cdr.resync();
+    EXPECT_EQ(cdr.list_segments().size(), 3u);
+    EXPECT_EQ(cdr.find_records("1234567890"_imsi, 100).size(), 25u);
+
+    cdr.add_record("1234567890"_imsi, "expired");
+    cdr.flush();
+    const auto records = cdr.find_records("1234567890"_imsi, 100);
+    ASSERT_EQ(records.size(), 26u);
+    EXPECT_NE(records.back().find(",expired"), std::string::npos);
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "session/cdr_replay.h"
+#include "session/session_manager.h"
+#include "test_util.h"
+
+using namespace imsi_literals;
+
+namespace {
+
+// Строка CDR в формате CdrManager: время в локальной зоне
+std::string cdr_line(std::time_t time, std::string_view imsi, std::string_view action) {
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%F %T", std::localtime(&time));
+    return std::string(stamp) + "," + std::string(imsi) + "," + std::string(action) + "\n";
+}
+
+class CdrReplayTest : public TempDirTest {
+protected:
+    std::time_t now = std::time(nullptr);
+
+    CdrReplayTest() : TempDirTest("pgw_cdr_replay_") {}
+
+    std::string write_file(const std::string& name, const std::string& content) {
+        const std::string path = dir + "/" + name;
+        std::ofstream(path) << content;
+        return path;
+    }
+};
+
+} // namespace
+
+TEST_F(CdrReplayTest, LastRecordDecidesSessionState) {
+    std::string content;
+    content += cdr_line(now - 50, "001010000000001", "created");
+    content += cdr_line(now - 40, "001010000000002", "created");
+    content += cdr_line(now - 30, "001010000000002", "expired");
+    content += cdr_line(now - 20, "001010000000003", "created");
+    content += cdr_line(now - 10, "001010000000003", "prolonged");
+    content += cdr_line(now - 5, "001010000000004", "rejected_blacklist");
+    content += cdr_line(now - 500, "001010000000005", "created");   // старше таймаута
+    const auto path = write_file("cdr.log", content);
+
+    SessionManager manager(nullptr, 300, {}, nullptr);
+    const auto stats = CdrReplay::restore({path}, 100, manager, 2);
+
+    EXPECT_EQ(stats.records, 7u);
+    EXPECT_EQ(stats.restored, 2u);
+    EXPECT_EQ(stats.expired, 1u);
+    EXPECT_TRUE(manager.session_exists("001010000000001"_imsi));
+    EXPECT_FALSE(manager.session_exists("001010000000002"_imsi));
+    EXPECT_TRUE(manager.session_exists("001010000000003"_imsi));
+    EXPECT_FALSE(manager.session_exists("001010000000004"_imsi));
+    EXPECT_FALSE(manager.session_exists("001010000000005"_imsi));
+
+    // Срок - время последнего created/prolonged плюс таймаут
+    const auto page = manager.list_sessions({}, 10);
+    for (const auto& session : page.sessions) {
+        const auto left = std::chrono::duration_cast<std::chrono::seconds>(
+            session.expires_at - std::chrono::steady_clock::now()).count();
+        if (session.imsi == "001010000000003"_imsi) {
+            EXPECT_NEAR(left, 90, 2);
+        } else {
+            EXPECT_NEAR(left, 50, 2);
+        }
+    }
+}
+
+TEST_F(CdrReplayTest, LaterFilesOverrideEarlierOnes) {
+    const auto segment = write_file("cdr.log.000001", cdr_line(now - 20, "001010000000001", "created") +
+                                                      cdr_line(now - 20, "001010000000002", "created"));
+    const auto active = write_file("cdr.log", cdr_line(now - 10, "001010000000001", "graceful_removal"));
+
+    SessionManager manager(nullptr, 300, {}, nullptr);
+    const auto stats = CdrReplay::restore({segment, active}, 300, manager, 3);
+
+    EXPECT_EQ(stats.files, 2u);
+    EXPECT_FALSE(manager.session_exists("001010000000001"_imsi));
+    EXPECT_TRUE(manager.session_exists("001010000000002"_imsi));
+}
+
+TEST_F(CdrReplayTest, SmallChunksMatchSingleThread) {
+    // Куски по 100 байт режут строки посередине: каждая должна быть разобрана ровно раз
+    std::string content;
+    for (int i = 0; i < 5000; ++i) {
+        const std::string imsi = make_imsi(static_cast<uint64_t>(i % 700)).to_string();
+        const char* action = i % 3 == 2 ? "expired" : (i % 3 == 1 ? "prolonged" : "created");
+        content += cdr_line(now - 100 + i / 100, imsi, action);
+    }
+    content += "2026-01-01 00:00";    // недописанная строка
+    const auto path = write_file("cdr.log", content);
+
+    SessionManager single(nullptr, 300, {}, nullptr);
+    const auto expected = CdrReplay::restore({path}, 300, single, 1);
+    SessionManager parallel(nullptr, 300, {}, nullptr);
+    const auto stats = CdrReplay::restore({path}, 300, parallel, 4, 100);
+
+    EXPECT_EQ(stats.records, 5000u);
+    EXPECT_EQ(stats.records, expected.records);
+    EXPECT_EQ(stats.restored, expected.restored);
+    EXPECT_EQ(parallel.session_count(), single.session_count());
+    for (int i = 0; i < 700; ++i) {
+        const Imsi imsi = make_imsi(static_cast<uint64_t>(i));
+        EXPECT_EQ(parallel.session_exists(imsi), single.session_exists(imsi)) << i;
+    }
+}
+
+TEST_F(CdrReplayTest, SkipsBlacklistedSubscribers) {
+    const auto path = write_file("cdr.log", cdr_line(now - 10, "001010000000001", "created") +
+                                            cdr_line(now - 10, "001010000000002", "created"));
+
+    SessionManager manager(nullptr, 300, {"001010000000002"}, nullptr);
+    CdrReplay::restore({path}, 300, manager, 2);
+
+    EXPECT_TRUE(manager.session_exists("001010000000001"_imsi));
+    EXPECT_FALSE(manager.session_exists("001010000000002"_imsi));
+}
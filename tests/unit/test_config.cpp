@@ -28,6 +28,9 @@ TEST_F(ConfigTest, ClientConfigValidation) {
         ClientConfig config("test_client_config.json");
         EXPECT_EQ(config.get_server_ip(), "127.0.0.1");
         EXPECT_EQ(config.get_server_port(), 8080);
+        EXPECT_EQ(config.get_request_timeout_ms(), 1000);
+        EXPECT_EQ(config.get_max_retries(), 3);
+        EXPECT_FALSE(config.get_hedge_requests());
     });
     
     std::remove("test_client_config.json");
@@ -64,7 +67,68 @@ TEST_F(ConfigTest, ServerConfigValidation) {
         ServerConfig config("test_server_config.json");
         EXPECT_EQ(config.get_udp_port(), 5060);
         EXPECT_EQ(config.get_blacklist().size(), 1);
+        EXPECT_TRUE(config.get_shm_session_table().empty());
+        EXPECT_EQ(config.get_shm_session_capacity(), 1048576);
     });
     
     std::remove("test_server_config.json");
-}
\ No newline at end of file
+}
+TEST_F(ConfigTest, InvalidShmSessionTableNameThrows) {
+    createTestConfig("shm_server_config.json", R"({
+        "udp_ip": "0.0.0.0",
+        "udp_port": 5060,
+        "http_port": 8080,
+        "session_timeout_sec": 60,
+        "cdr_file": "cdr.csv",
+        "graceful_shutdown_rate": 10,
+        "log_level": "INFO",
+        "shm_session_table": "pgw/sessions",
+        "blacklist": []
+    })");
+
+    EXPECT_THROW({
+        ServerConfig config("shm_server_config.json");
+    }, std::runtime_error);
+
+    std::remove("shm_server_config.json");
+}
+TEST_F(ConfigTest, RelativeHandoffSocketThrows) {
+    createTestConfig("handoff_server_config.json", R"({
+        "udp_ip": "0.0.0.0",
+        "udp_port": 5060,
+        "http_port": 8080,
+        "session_timeout_sec": 60,
+        "cdr_file": "cdr.csv",
+        "graceful_shutdown_rate": 10,
+        "log_level": "INFO",
+        "handoff_socket": "run/pgw.sock",
+        "blacklist": []
+    })");
+
+    EXPECT_THROW({
+        ServerConfig config("handoff_server_config.json");
+    }, std::runtime_error);
+
+    std::remove("handoff_server_config.json");
+}
+TEST_F(ConfigTest, ReplicationPrimaryAndStandbyTogetherThrows) {
+    createTestConfig("replication_server_config.json", R"({
+        "udp_ip": "0.0.0.0",
+        "udp_port": 5060,
+        "http_port": 8080,
+        "session_timeout_sec": 60,
+        "cdr_file": "cdr.csv",
+        "graceful_shutdown_rate": 10,
+        "log_level": "INFO",
+        "replication_standby_ip": "10.0.0.2",
+        "replication_standby_port": 9300,
+        "replication_port": 9300,
+        "blacklist": []
+    })");
+
+    EXPECT_THROW({
+        ServerConfig config("replication_server_config.json");
+    }, std::runtime_error);
+
+    std::remove("replication_server_config.json");
+}
@@ -3,6 +3,7 @@
 #include <gtest/gtest.h>
 #include <fstream>
 #include <filesystem>
+#include <thread>
 
 class LoggerTest : public ::testing::Test {
 protected:
@@ -35,6 +36,76 @@ TEST_F(LoggerTest, LogLevels) {
     EXPECT_GE(line_count, 4);
 }
 
+TEST(AsyncLoggerTest, ShutdownDrainsQueue) {
+    const std::string async_log_file = "test_async_log.log";
+    std::remove(async_log_file.c_str());
+
+    LogOptions options;
+    options.async = true;
+    options.queue_size = 64;
+    options.flush_level = "OFF";
+    options.flush_interval_sec = 0;
+    Logger::init(async_log_file, "async_test_logger", "TRACE", false, options);
+
+    // Очередь меньше числа сообщений: в режиме block писатель ждёт, ничего не теряется
+    for (int i = 0; i < 1000; ++i) {
+        PGW_LOG_INFO("Async message {}", i);
+    }
+    // Счётчик читается до shutdown: после него пул потоков уже уничтожен
+    EXPECT_EQ(Logger::dropped_messages(), 0u);
+    Logger::shutdown();
+
+    std::ifstream log_file(async_log_file);
+    std::string line;
+    int line_count = 0;
+    while (std::getline(log_file, line)) {
+        line_count++;
+    }
+    EXPECT_EQ(line_count, 1000);
+    std::remove(async_log_file.c_str());
+}
+
+TEST_F(LoggerTest, DisabledLevelSkipsArguments) {
+    int evaluated = 0;
+    auto count = [&evaluated] { return ++evaluated; };
+
+    Logger::set_level("INFO");
+    PGW_LOG_DEBUG("Not logged {}", count());
+    PGW_LOG_INFO("Logged {}", count());
+
+    EXPECT_EQ(evaluated, 1);
+}
+
+TEST_F(LoggerTest, SampledMacroWritesEveryNth) {
+    for (int i = 0; i < 1000; ++i) {
+        PGW_LOG_INFO_SAMPLED(100, "Sampled message {}", i);
+    }
+    Logger::flush();
+
+    std::ifstream log_file(test_log_file);
+    std::string line;
+    int sampled = 0;
+    while (std::getline(log_file, line)) {
+        if (line.find("Sampled message") != std::string::npos) sampled++;
+    }
+    EXPECT_EQ(sampled, 10);
+}
+
+TEST(LogRateLimiterTest, LimitsPerSecondAndCountsSuppressed) {
+    LogRateLimiter limiter(5);
+    uint64_t suppressed = 0;
+    int allowed = 0;
+    for (int i = 0; i < 100; ++i) {
+        if (limiter.allow(suppressed)) allowed++;
+    }
+    EXPECT_EQ(allowed, 5);
+    EXPECT_EQ(suppressed, 0u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_TRUE(limiter.allow(suppressed));
+    EXPECT_EQ(suppressed, 95u);
+}
+
 TEST_F(LoggerTest, FileCreation) {
     EXPECT_TRUE(std::filesystem::exists(test_log_file));
 }
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "metrics/metrics.h"
+#include "metrics/latency.h"
+#include "metrics/profiler.h"
+#include "metrics/request_trace.h"
+#include <gtest/gtest.h>
+#include <csignal>
+#include <thread>
+#include <vector>
+
+TEST(MetricsTest, CountersSumAcrossThreads) {
+    const uint64_t before = Metrics::value(Counter::UdpPacketsIn);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 1000; ++i) {
+                Metrics::increment(Counter::UdpPacketsIn);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    // Потоки уже завершились: их значения должны сохраниться
+    EXPECT_EQ(Metrics::value(Counter::UdpPacketsIn) - before, 4000u);
+}
+
+TEST(MetricsTest, SlotsDoNotShareCacheLines) {
+    EXPECT_EQ(alignof(Metrics::CounterSlot), Metrics::kCacheLineSize);
+    EXPECT_EQ(sizeof(Metrics::CounterSlot) % Metrics::kCacheLineSize, 0u);
+}
+
+TEST(MetricsTest, PrometheusFormat) {
+    Metrics::increment(Counter::SessionsCreated, 5);
+    Metrics::register_gauge("pgw_test_gauge", "Test gauge", [] { return 42.0; });
+
+    const std::string text = Metrics::render_prometheus();
+    EXPECT_NE(text.find("# TYPE pgw_sessions_created_total counter\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE pgw_test_gauge gauge\npgw_test_gauge 42\n"), std::string::npos);
+
+    Metrics::unregister_gauge("pgw_test_gauge");
+    EXPECT_EQ(Metrics::render_prometheus().find("pgw_test_gauge"), std::string::npos);
+}
+
+TEST(MetricsTest, CallbackCounterHasCounterType) {
+    Metrics::register_counter("pgw_test_bytes_total", "Test counter", [] { return uint64_t{1} << 53; });
+
+    const std::string text = Metrics::render_prometheus();
+    EXPECT_NE(text.find("# TYPE pgw_test_bytes_total counter\npgw_test_bytes_total 9007199254740992\n"),
+              std::string::npos);
+
+    Metrics::unregister_gauge("pgw_test_bytes_total");
+    EXPECT_EQ(Metrics::render_prometheus().find("pgw_test_bytes_total"), std::string::npos);
+}
+
+TEST(LatencyHistogramTest, BucketsAreContiguous) {
+    for (uint64_t v = 0; v < 100000; ++v) {
+        const size_t index = LatencyHistogram::bucket_index(v);
+        ASSERT_LE(v, LatencyHistogram::bucket_upper_bound(index));
+        if (index > 0) {
+            ASSERT_GT(v, LatencyHistogram::bucket_upper_bound(index - 1));
+        }
+    }
+    EXPECT_LT(LatencyHistogram::bucket_index(LatencyHistogram::kMaxValue), LatencyHistogram::kBucketCount);
+}
+
+TEST(LatencyHistogramTest, PercentilesWithinRelativeError) {
+    LatencyHistogram histogram;
+    for (uint64_t v = 1; v <= 100000; ++v) {
+        histogram.record(v * 1000);
+    }
+
+    EXPECT_EQ(histogram.count(), 100000u);
+    EXPECT_EQ(histogram.max(), 100000000u);
+    EXPECT_NEAR(histogram.value_at_percentile(50.0), 50000000.0, 50000000.0 / 32);
+    EXPECT_NEAR(histogram.value_at_percentile(99.0), 99000000.0, 99000000.0 / 32);
+    EXPECT_EQ(histogram.value_at_percentile(100.0), 100000000u);
+}
+
+TEST(LatencyHistogramTest, MergesThreadHistograms) {
+    LatencyHistogram before;
+    Latency::snapshot(Stage::Decode, before);
+
+    std::thread([] {
+        for (int i = 0; i < 100; ++i) Latency::record(Stage::Decode, 500);
+    }).join();
+
+    LatencyHistogram after;
+    Latency::snapshot(Stage::Decode, after);
+    EXPECT_EQ(after.count() - before.count(), 100u);
+}
+
+TEST(ProfilerTest, SamplesBusyThread) {
+    std::atomic<bool> stop{false};
+    std::thread busy([&] {
+        volatile uint64_t x = 0;
+        while (!stop.load(std::memory_order_relaxed)) x = x + 1;
+    });
+
+    const auto result = Profiler::profile(std::chrono::seconds(1), 200);
+    stop = true;
+    busy.join();
+
+    EXPECT_GT(result.samples, 50u);
+    EXPECT_FALSE(result.folded.empty());
+    // Каждая строка заканчивается числом попаданий
+    EXPECT_EQ(result.folded.back(), '\n');
+    EXPECT_NE(result.folded.find(' '), std::string::npos);
+}
+
+TEST(ProfilerTest, OneHertzStartsTimer) {
+    // Период ровно в секунду: tv_usec = 1000000 таймер отверг бы
+    std::atomic<bool> stop{false};
+    std::thread busy([&] {
+        volatile uint64_t x = 0;
+        while (!stop.load(std::memory_order_relaxed)) x = x + 1;
+    });
+
+    Profiler::Result result;
+    EXPECT_NO_THROW(result = Profiler::profile(std::chrono::seconds(2), 1));
+    stop = true;
+    busy.join();
+    EXPECT_GE(result.samples, 1u);
+}
+
+TEST(ProfilerTest, RestoresPreviousHandler) {
+    struct sigaction custom{};
+    custom.sa_handler = [](int) {};
+    sigemptyset(&custom.sa_mask);
+    struct sigaction saved{};
+    sigaction(SIGPROF, &custom, &saved);
+
+    Profiler::profile(std::chrono::seconds(1), 100);
+    struct sigaction current{};
+    sigaction(SIGPROF, nullptr, &current);
+    EXPECT_EQ(current.sa_handler, custom.sa_handler);
+
+    // Флаг профиля снят: следующий профиль запускается
+    EXPECT_NO_THROW(Profiler::profile(std::chrono::seconds(1), 100));
+    sigaction(SIGPROF, &saved, nullptr);
+}
+
+TEST(RequestTracesTest, KeepsRecentAndSlowest) {
+    RequestTraces::set_slow_threshold(std::chrono::microseconds(100));
+    RequestTraces::reset_slowest();
+
+    std::thread([] {
+        for (int i = 0; i < 2000; ++i) {
+            RequestTrace trace;
+            trace.timestamp_ms = i;
+            trace.imsi = *Imsi::parse(std::to_string(100000000000000LL + i));
+            trace.set_stage(Stage::Total, static_cast<uint64_t>(i) * 1000);
+            RequestTraces::record(trace);
+        }
+    }).join();
+
+    // Кольцо завершившегося потока освобождено вместе с ним
+    EXPECT_TRUE(RequestTraces::recent(10).empty());
+
+    const auto slowest = RequestTraces::slowest();
+    ASSERT_EQ(slowest.size(), RequestTraces::kSlowestCapacity);
+    EXPECT_EQ(slowest.front().total_nanos(), 1999000u);
+    EXPECT_EQ(slowest.back().total_nanos(), (2000 - RequestTraces::kSlowestCapacity) * 1000u);
+
+    for (int i = 0; i < 5; ++i) {
+        RequestTrace trace;
+        trace.timestamp_ms = 10000 + i;
+        RequestTraces::record(trace);
+    }
+    const auto recent = RequestTraces::recent(3);
+    ASSERT_EQ(recent.size(), 3u);
+    EXPECT_EQ(recent.front().timestamp_ms, 10004);
+
+    RequestTraces::set_slow_threshold(std::chrono::microseconds(0));
+    RequestTraces::reset_slowest();
+}
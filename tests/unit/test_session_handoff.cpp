@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <thread>
+#include "session/session_handoff.h"
+#include "session/session_manager.h"
+#include "test_util.h"
+
+using namespace imsi_literals;
+
+namespace {
+
+class SessionHandoffTest : public TempDirTest {
+protected:
+    std::string path;
+
+    SessionHandoffTest() : TempDirTest("pgw_handoff_") {}
+
+    void SetUp() override {
+        TempDirTest::SetUp();
+        path = dir + "/handoff.sock";
+    }
+
+    // Принять запрос нового процесса (он приходит из другого потока)
+    static void accept(HandoffListener& listener) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!listener.accept_request()) {
+            ASSERT_LT(std::chrono::steady_clock::now(), deadline);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+} // namespace
+
+TEST_F(SessionHandoffTest, TransfersUdpSocketAndSessions) {
+    // Сокет "старого процесса" с датаграммой, которую он уже не прочитает
+    const int udp_fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(::bind(udp_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+    socklen_t addr_len = sizeof(addr);
+    ::getsockname(udp_fd, reinterpret_cast<sockaddr*>(&addr), &addr_len);
+
+    SessionManager old_manager(nullptr, 300, {}, nullptr);
+    for (uint64_t i = 0; i < 10000; ++i) {
+        old_manager.create_session(make_imsi(i));
+    }
+
+    HandoffListener listener(path);
+    auto connecting = std::async(std::launch::async, [this] {
+        return HandoffClient::connect(path, std::chrono::seconds(5));
+    });
+    accept(listener);
+    ASSERT_TRUE(listener.send_sessions(old_manager));
+    auto client = connecting.get();
+    ASSERT_NE(client, nullptr);
+    EXPECT_EQ(listener.sessions_sent(), 10000u);
+
+    // Таблица фазы 1 (обход страницами) загружается до переключения по сроку
+    auto table = client->take_sessions();
+    ASSERT_EQ(table.size(), 10000u);
+    for (size_t i = 1; i < table.size(); ++i) {
+        ASSERT_LE(table[i - 1].expires_at, table[i].expires_at);
+    }
+    SessionManager new_manager(nullptr, 300, {}, nullptr);
+    new_manager.restore_sessions(std::move(table));
+    EXPECT_EQ(new_manager.session_count(), 10000u);
+
+    // Старый процесс работает дальше, пока новый не попросит переключения
+    for (uint64_t i = 10000; i < 10500; ++i) {
+        old_manager.create_session(make_imsi(i));
+    }
+    old_manager.create_session(make_imsi(0));   // продлена: в очереди истечения дважды
+    const int sender = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    ASSERT_EQ(::sendto(sender, "queued", 6, 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 6);
+    ::close(sender);
+
+    auto switching = std::async(std::launch::async, [&client] { client->switch_over(); });
+    ASSERT_TRUE(listener.wait_switch(std::chrono::seconds(5)));
+    ASSERT_TRUE(listener.send_state({udp_fd, -1}, old_manager, std::chrono::steady_clock::now()));
+    ::close(udp_fd);
+    switching.get();
+    EXPECT_EQ(listener.changes_sent(), 501u);
+    EXPECT_EQ(client->changes_received(), 501u);
+
+    const HandoffSockets sockets = client->release_sockets();
+    ASSERT_GE(sockets.udp_fd, 0);
+    EXPECT_EQ(sockets.cdr_export_fd, -1);
+    char buffer[16];
+    EXPECT_EQ(::recv(sockets.udp_fd, buffer, sizeof(buffer), MSG_DONTWAIT), 6);
+    ::close(sockets.udp_fd);
+
+    const auto changes = client->take_sessions();
+    ASSERT_EQ(changes.size(), 501u);
+    for (size_t i = 1; i < changes.size(); ++i) {
+        ASSERT_LE(changes[i - 1].expires_at, changes[i].expires_at);
+    }
+    EXPECT_EQ(changes.back().imsi, make_imsi(0));
+
+    new_manager.restore_sessions(changes);
+    new_manager.drop_closed_sessions(client->cleaned_at());
+    EXPECT_EQ(new_manager.session_count(), 10500u);
+    EXPECT_TRUE(new_manager.session_exists(make_imsi(10499)));
+
+    EXPECT_TRUE(client->ready());
+    EXPECT_TRUE(listener.wait_ready(std::chrono::seconds(5)));
+}
+
+TEST_F(SessionHandoffTest, DropsSessionsClosedByPreviousProcess) {
+    SessionManager old_manager(nullptr, 1, {}, nullptr);
+    old_manager.create_session("001010123456789"_imsi);
+
+    HandoffListener listener(path);
+    auto connecting = std::async(std::launch::async, [this] {
+        return HandoffClient::connect(path, std::chrono::seconds(5));
+    });
+    accept(listener);
+    ASSERT_TRUE(listener.send_sessions(old_manager));
+    auto client = connecting.get();
+    ASSERT_NE(client, nullptr);
+    SessionManager new_manager(nullptr, 1, {}, nullptr);
+    new_manager.restore_sessions(client->take_sessions());
+
+    // Сессия из фазы 1 истекла, и старый процесс закрыл её последней очисткой
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    old_manager.create_session("001010123456788"_imsi);
+    const auto cleaned_at = std::chrono::steady_clock::now();
+    old_manager.cleanup_expired_sessions(cleaned_at);
+
+    auto switching = std::async(std::launch::async, [&client] { client->switch_over(); });
+    ASSERT_TRUE(listener.wait_switch(std::chrono::seconds(5)));
+    ASSERT_TRUE(listener.send_state({}, old_manager, cleaned_at));
+    switching.get();
+
+    const auto changes = client->take_sessions();
+    ASSERT_EQ(changes.size(), 1u);
+    EXPECT_EQ(changes[0].imsi, "001010123456788"_imsi);
+
+    // Закрытая старым процессом удаляется без CDR
+    new_manager.restore_sessions(changes);
+    new_manager.drop_closed_sessions(client->cleaned_at());
+    EXPECT_EQ(new_manager.session_count(), 1u);
+    EXPECT_FALSE(new_manager.session_exists("001010123456789"_imsi));
+}
+
+TEST_F(SessionHandoffTest, NoRunningProcessMeansFreshStart) {
+    EXPECT_EQ(HandoffClient::connect(path, std::chrono::seconds(1)), nullptr);
+
+    // Файл сокета остался от упавшего процесса
+    { HandoffListener stale(path); }
+    EXPECT_EQ(HandoffClient::connect(path, std::chrono::seconds(1)), nullptr);
+}
+
+TEST_F(SessionHandoffTest, NoConfirmationMeansRollback) {
+    SessionManager manager(nullptr, 300, {}, nullptr);
+    manager.create_session("001010123456789"_imsi);
+
+    HandoffListener listener(path);
+    auto taking_over = std::async(std::launch::async, [this] {
+        return HandoffClient::connect(path, std::chrono::seconds(5));
+    });
+    accept(listener);
+    ASSERT_TRUE(listener.send_sessions(manager));
+
+    // Новый процесс упал, не попросив переключения
+    taking_over.get().reset();
+    EXPECT_FALSE(listener.wait_switch(std::chrono::seconds(5)));
+    listener.reset();
+    EXPECT_FALSE(listener.accept_request());
+}
+
+TEST_F(SessionHandoffTest, ListenerKeepsPathOfSuccessor) {
+    auto old_listener = std::make_unique<HandoffListener>(path);
+    HandoffListener new_listener(path);
+    old_listener.reset();
+
+    // Удаление старого слушателя не трогает файл нового
+    EXPECT_TRUE(std::filesystem::exists(path));
+    auto taking_over = std::async(std::launch::async, [this] {
+        return HandoffClient::connect(path, std::chrono::seconds(5));
+    });
+    accept(new_listener);
+    SessionManager manager(nullptr, 300, {}, nullptr);
+    ASSERT_TRUE(new_listener.send_sessions(manager));
+    EXPECT_NE(taking_over.get(), nullptr);
+}
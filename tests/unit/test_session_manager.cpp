@@ -4,8 +4,10 @@
 #include <gtest/gtest.h>
 #include <thread>
 #include <chrono>
+#include <set>
 
 using ::testing::_;
+using namespace imsi_literals;
 
 #include <iostream>
 
@@ -13,7 +15,7 @@ class MockCdrManager : public CdrManager {
 public:
     MockCdrManager(const std::string& filename) : CdrManager(filename) {}
     
-    MOCK_METHOD(void, add_record, (std::string_view imsi, std::string_view action), (override));
+    MOCK_METHOD(void, add_record, (Imsi imsi, std::string_view action), (override));
     MOCK_METHOD(void, flush, (), (override));
 };
 
@@ -37,8 +39,110 @@ protected:
 
 
 TEST_F(SessionManagerTest, CreateSessionWritesToCDR) {
-    EXPECT_CALL(*cdr_manager, add_record("123456789012344", "created"))
+    EXPECT_CALL(*cdr_manager, add_record("123456789012344"_imsi, "created"))
         .Times(1);
         
-    session_manager->create_session("123456789012344");
-}
\ No newline at end of file
+    session_manager->create_session("123456789012344"_imsi);
+}
+
+TEST_F(SessionManagerTest, SessionsExistChecksWholeBatch) {
+    session_manager->create_session("123456789012344"_imsi);
+    session_manager->create_session("123456789012346"_imsi);
+
+    const std::vector<Imsi> imsis{"123456789012344"_imsi, "123456789012345"_imsi, "123456789012346"_imsi};
+    const auto active = session_manager->sessions_exist(imsis);
+
+    EXPECT_EQ(active, (std::vector<bool>{true, false, true}));
+}
+
+TEST_F(SessionManagerTest, ListSessionsVisitsEverySessionOnce) {
+    std::set<Imsi> expected;
+    for (int i = 0; i < 500; ++i) {
+        const Imsi imsi = *Imsi::parse(std::to_string(100000000000000LL + i));
+        session_manager->create_session(imsi);
+        expected.insert(imsi);
+    }
+
+    std::set<Imsi> seen;
+    SessionCursor cursor;
+    for (;;) {
+        SessionPage page = session_manager->list_sessions(SessionCursor::parse(cursor.to_string()), 64);
+        ASSERT_FALSE(page.restarted);
+        for (const auto& session : page.sessions) {
+            EXPECT_TRUE(seen.insert(session.imsi).second);
+        }
+        if (page.done) break;
+        cursor = page.next;
+    }
+    EXPECT_EQ(seen, expected);
+}
+
+TEST(SessionEventBusTest, PublishesFromSessionManager) {
+    auto bus = std::make_shared<SessionEventBus>();
+    auto subscription = bus->subscribe();
+    SessionManager manager(nullptr, 600, {}, bus);
+
+    manager.create_session("123456789012344"_imsi);
+    manager.create_session("123456789012344"_imsi);
+
+    std::vector<SessionEvent> events;
+    EXPECT_EQ(subscription->drain(events, std::chrono::milliseconds(0)), 0u);
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[0].type, SessionEventType::Created);
+    EXPECT_EQ(events[1].type, SessionEventType::Prolonged);
+    EXPECT_EQ(events[1].imsi, "123456789012344"_imsi);
+}
+
+TEST(SessionEventBusTest, SlowSubscriberDropsInsteadOfBlocking) {
+    SessionEventBus bus;
+    auto subscription = bus.subscribe(4);
+
+    for (int i = 0; i < 10; ++i) {
+        bus.publish(SessionEventType::Created, *Imsi::parse("12345678901234" + std::to_string(i)));
+    }
+
+    // Переполненное кольцо затирает самые старые события
+    std::vector<SessionEvent> events;
+    EXPECT_EQ(subscription->drain(events, std::chrono::milliseconds(0)), 6u);
+    ASSERT_EQ(events.size(), 4u);
+    EXPECT_EQ(events.front().imsi, "123456789012346"_imsi);
+    EXPECT_EQ(events.back().imsi, "123456789012349"_imsi);
+
+    bus.publish(SessionEventType::Expired, "123456789012340"_imsi);
+    events.clear();
+    EXPECT_EQ(subscription->drain(events, std::chrono::milliseconds(0)), 0u);
+    ASSERT_EQ(events.size(), 1u);
+    EXPECT_EQ(events[0].type, SessionEventType::Expired);
+
+    bus.unsubscribe(subscription);
+    EXPECT_EQ(bus.subscriber_count(), 0u);
+}
+
+TEST_F(SessionManagerTest, UpdatePolicyReplacesBlacklist) {
+    EXPECT_TRUE(session_manager->is_blacklisted("123456789012345"_imsi));
+
+    session_manager->update_policy(30, {"123456789012399"});
+
+    EXPECT_FALSE(session_manager->is_blacklisted("123456789012345"_imsi));
+    EXPECT_TRUE(session_manager->is_blacklisted("123456789012399"_imsi));
+    EXPECT_EQ(session_manager->session_timeout_sec(), 30);
+    EXPECT_TRUE(session_manager->create_session("123456789012345"_imsi));
+    EXPECT_FALSE(session_manager->create_session("123456789012399"_imsi));
+}
+
+TEST_F(SessionManagerTest, UpdatePolicyWhileCreatingSessions) {
+    std::atomic<bool> stop{false};
+    std::thread reader([&] {
+        for (long i = 0; !stop; ++i) {
+            session_manager->create_session(*Imsi::parse(std::to_string(100000000000000LL + i % 1000)));
+        }
+    });
+
+    for (int i = 0; i < 200; ++i) {
+        session_manager->update_policy(1 + i % 5, {std::to_string(100000000000000LL + i)});
+    }
+    stop = true;
+    reader.join();
+
+    EXPECT_TRUE(session_manager->is_blacklisted("100000000000199"_imsi));
+}
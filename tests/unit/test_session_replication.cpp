@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include "session/session_manager.h"
+#include "session/session_replication.h"
+#include "test_util.h"
+
+using namespace imsi_literals;
+
+namespace {
+
+// Репликация асинхронная: условие проверяется до истечения срока
+bool eventually(const std::function<bool()>& condition) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+class SessionReplicationTest : public ::testing::Test {
+protected:
+    std::shared_ptr<ReplicationLog> log = std::make_shared<ReplicationLog>();
+    SessionManager primary{nullptr, 300, {}, nullptr, nullptr, nullptr, log};
+    SessionManager standby{nullptr, 300, {}, nullptr};
+    ReplicationReceiver receiver{standby, "127.0.0.1", 0};
+
+    void SetUp() override {
+        receiver.start();
+    }
+
+    std::unique_ptr<SessionReplicator> replicate(SessionManager& manager, std::shared_ptr<ReplicationLog> source) {
+        auto replicator = std::make_unique<SessionReplicator>(
+            manager, std::move(source), "127.0.0.1", receiver.port(), std::chrono::milliseconds(5));
+        replicator->start();
+        return replicator;
+    }
+};
+
+} // namespace
+
+TEST_F(SessionReplicationTest, StandbyFollowsPrimary) {
+    for (uint64_t i = 0; i < 1000; ++i) {
+        primary.create_session(make_imsi(i));
+    }
+    auto replicator = replicate(primary, log);
+    ASSERT_TRUE(eventually([&] { return standby.session_count() == 1000; }));
+
+    // Изменения после полной синхронизации идут пачками
+    for (uint64_t i = 1000; i < 1100; ++i) {
+        primary.create_session(make_imsi(i));
+    }
+    ASSERT_TRUE(eventually([&] { return standby.session_count() == 1100; }));
+
+    // Срок на резервном узле тот же с точностью до задержки передачи
+    const auto page = standby.list_sessions({}, 2000);
+    const auto expected = std::chrono::steady_clock::now() + std::chrono::seconds(300);
+    for (const auto& session : page.sessions) {
+        EXPECT_NEAR(std::chrono::duration<double>(session.expires_at - expected).count(), 0, 1.0);
+    }
+
+    primary.cleanup_expired_sessions(std::chrono::steady_clock::now() + std::chrono::seconds(301));
+    ASSERT_TRUE(eventually([&] { return standby.session_count() == 0; }));
+
+    // Статистика основного узла обновляется после отправки, подтверждения - позже
+    EXPECT_TRUE(eventually([&] { return replicator->stats().lag_ms > 0 && replicator->stats().records == 2200; }));
+    const auto sent = replicator->stats();
+    EXPECT_TRUE(sent.connected);
+    EXPECT_EQ(sent.full_syncs, 1u);
+    EXPECT_LT(sent.compressed_bytes, sent.raw_bytes);
+    EXPECT_TRUE(eventually([&] { return receiver.stats().records == 2200; }));
+}
+
+TEST_F(SessionReplicationTest, FullSyncDropsSessionsClosedMeanwhile) {
+    // Сессия закрыта на основном узле, пока резервный был отключён
+    standby.create_session("001010123456789"_imsi);
+    primary.create_session("001010123456788"_imsi);
+
+    auto replicator = replicate(primary, log);
+    ASSERT_TRUE(eventually([&] { return receiver.stats().full_syncs == 1; }));
+    EXPECT_EQ(standby.session_count(), 1u);
+    EXPECT_TRUE(standby.session_exists("001010123456788"_imsi));
+}
+
+TEST_F(SessionReplicationTest, NewPrimaryReplacesStream) {
+    primary.create_session("001010123456789"_imsi);
+    auto replicator = replicate(primary, log);
+    ASSERT_TRUE(eventually([&] { return standby.session_count() == 1; }));
+
+    // Основной узел обновлён без простоя: новый процесс подключается со своей таблицей
+    auto next_log = std::make_shared<ReplicationLog>();
+    SessionManager next(nullptr, 300, {}, nullptr, nullptr, nullptr, next_log);
+    next.create_session("001010123456788"_imsi);
+    auto next_replicator = replicate(next, next_log);
+    replicator->stop();
+
+    ASSERT_TRUE(eventually([&] { return receiver.stats().full_syncs == 2; }));
+    EXPECT_FALSE(standby.session_exists("001010123456789"_imsi));
+    EXPECT_TRUE(standby.session_exists("001010123456788"_imsi));
+
+    next_replicator->stop();
+    EXPECT_TRUE(eventually([&] { return !receiver.stats().connected; }));
+}
+
+TEST(ReplicationLogTest, RecordsOnlyWhileActive) {
+    ReplicationLog log;
+    std::vector<char> batch;
+    std::chrono::steady_clock::time_point oldest;
+
+    log.append(SessionJournal::Op::Upsert, "001010123456789"_imsi);
+    EXPECT_FALSE(log.take(batch, oldest));
+
+    log.activate();
+    log.append(SessionJournal::Op::Upsert, "001010123456789"_imsi);
+    log.append(SessionJournal::Op::Erase, "001010123456789"_imsi);
+    ASSERT_TRUE(log.take(batch, oldest));
+    EXPECT_EQ(batch.size(), 2 * 17u);
+    EXPECT_FALSE(log.take(batch, oldest));
+}
@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "session/session_manager.h"
+#include "session/session_snapshot.h"
+#include "test_util.h"
+
+using namespace imsi_literals;
+
+namespace {
+
+class SessionSnapshotTest : public TempDirTest {
+protected:
+    SessionSnapshotTest() : TempDirTest("pgw_snapshot_test_") {}
+
+    std::unique_ptr<SessionManager> make_manager(int timeout_sec, std::shared_ptr<SessionJournal> journal) {
+        return std::make_unique<SessionManager>(nullptr, timeout_sec, std::vector<std::string>{},
+                                                nullptr, nullptr, std::move(journal));
+    }
+};
+
+} // namespace
+
+TEST_F(SessionSnapshotTest, RestoresSnapshotAndJournal) {
+    {
+        auto journal = std::make_shared<SessionJournal>(dir);
+        auto manager = make_manager(300, journal);
+        SessionSnapshotter snapshotter(*manager, journal, std::chrono::seconds(60));
+
+        for (uint64_t i = 0; i < 1000; ++i) {
+            manager->create_session(make_imsi(i));
+        }
+        EXPECT_EQ(snapshotter.write_snapshot(), 1000u);
+
+        // После снимка - только в журнале
+        for (uint64_t i = 1000; i < 1100; ++i) {
+            manager->create_session(make_imsi(i));
+        }
+        journal->flush();
+    }
+
+    auto journal = std::make_shared<SessionJournal>(dir);
+    auto restored = make_manager(300, journal);
+    const auto stats = SessionSnapshotter::restore(dir, *restored, 4);
+
+    EXPECT_EQ(stats.snapshot_sessions, 1000u);
+    EXPECT_EQ(stats.journal_records, 100u);
+    EXPECT_EQ(stats.restored, 1100u);
+    EXPECT_EQ(stats.expired, 0u);
+    EXPECT_EQ(restored->session_count(), 1100u);
+    EXPECT_TRUE(restored->session_exists(make_imsi(0)));
+    EXPECT_TRUE(restored->session_exists(make_imsi(1099)));
+    EXPECT_FALSE(restored->session_exists(make_imsi(1100)));
+}
+
+TEST_F(SessionSnapshotTest, JournalErasesOverrideSnapshot) {
+    {
+        auto journal = std::make_shared<SessionJournal>(dir);
+        auto manager = make_manager(1, journal);
+        SessionSnapshotter snapshotter(*manager, journal, std::chrono::seconds(60));
+        manager->create_session("001010123456789"_imsi);
+        manager->create_session("001010123456788"_imsi);
+        snapshotter.write_snapshot();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        manager->cleanup_expired_sessions();
+        journal->flush();
+    }
+
+    auto restored = make_manager(1, nullptr);
+    const auto stats = SessionSnapshotter::restore(dir, *restored, 2);
+    EXPECT_EQ(stats.journal_records, 2u);
+    EXPECT_EQ(stats.restored, 0u);
+    EXPECT_EQ(restored->session_count(), 0u);
+}
+
+TEST_F(SessionSnapshotTest, DropsSessionsExpiredWhileDown) {
+    {
+        auto journal = std::make_shared<SessionJournal>(dir);
+        auto manager = make_manager(1, journal);
+        SessionSnapshotter snapshotter(*manager, journal, std::chrono::seconds(60));
+        for (uint64_t i = 0; i < 10; ++i) {
+            manager->create_session(make_imsi(i));
+        }
+        snapshotter.write_snapshot();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+
+    auto restored = make_manager(1, nullptr);
+    const auto stats = SessionSnapshotter::restore(dir, *restored, 2);
+    EXPECT_EQ(stats.snapshot_sessions, 10u);
+    EXPECT_EQ(stats.expired, 10u);
+    EXPECT_EQ(restored->session_count(), 0u);
+}
+
+TEST_F(SessionSnapshotTest, IgnoresTornJournalTail) {
+    uint64_t journal_sequence = 0;
+    {
+        auto journal = std::make_shared<SessionJournal>(dir);
+        auto manager = make_manager(300, journal);
+        manager->create_session("001010123456789"_imsi);
+        journal->flush();
+        journal_sequence = journal->sequence();
+    }
+    // Половина записи: процесс упал посреди write
+    std::ofstream(dir + "/journal." + std::to_string(journal_sequence), std::ios::app) << "\x01\x02\x03";
+
+    auto restored = make_manager(300, nullptr);
+    const auto stats = SessionSnapshotter::restore(dir, *restored, 1);
+    EXPECT_EQ(stats.journal_records, 1u);
+    EXPECT_TRUE(restored->session_exists("001010123456789"_imsi));
+}
+
+TEST_F(SessionSnapshotTest, SnapshotDoesNotStopWriters) {
+    std::atomic<uint64_t> created{0};
+    {
+        auto journal = std::make_shared<SessionJournal>(dir);
+        auto manager = make_manager(300, journal);
+        SessionSnapshotter snapshotter(*manager, journal, std::chrono::seconds(60));
+
+        std::atomic<bool> stop{false};
+        std::thread writer([&] {
+            for (uint64_t i = 0; !stop; ++i) {
+                manager->create_session(make_imsi(i));
+                created = i + 1;
+            }
+        });
+        while (created < 20000) std::this_thread::yield();
+        snapshotter.write_snapshot();
+        while (created < 40000) std::this_thread::yield();
+        stop = true;
+        writer.join();
+        snapshotter.stop();
+    }
+
+    auto restored = make_manager(300, nullptr);
+    SessionSnapshotter::restore(dir, *restored, 4);
+    EXPECT_EQ(restored->session_count(), created.load());
+}
+
+TEST_F(SessionSnapshotTest, RehashDuringSnapshotLeavesNoDuplicates) {
+    auto journal = std::make_shared<SessionJournal>(dir);
+    auto manager = make_manager(300, journal);
+    SessionSnapshotter snapshotter(*manager, journal, std::chrono::seconds(60));
+
+    // Таблица растёт во время обхода: рехеширование перезапускает обход с начала
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> created{0};
+    std::thread writer([&] {
+        for (uint64_t i = 0; !stop; ++i) {
+            manager->create_session(make_imsi(i));
+            created = i + 1;
+        }
+    });
+    while (created < 5000) std::this_thread::yield();
+    for (int round = 0; round < 5; ++round) {
+        const uint64_t count = snapshotter.write_snapshot();
+
+        std::ifstream file(SessionSnapshotter::snapshot_path(dir), std::ios::binary);
+        file.seekg(32);
+        std::set<uint64_t> keys;
+        uint64_t record[2];
+        while (file.read(reinterpret_cast<char*>(record), sizeof(record))) {
+            keys.insert(record[0]);
+        }
+        EXPECT_EQ(keys.size(), count);
+    }
+    stop = true;
+    writer.join();
+}
+
+TEST_F(SessionSnapshotTest, RestoredSessionsAreJournaled) {
+    {
+        // Сессии не из снимка (например, из CDR): журнал - единственная их копия на диске
+        auto journal = std::make_shared<SessionJournal>(dir);
+        auto manager = make_manager(300, journal);
+        std::vector<SessionInfo> sessions;
+        for (uint64_t i = 0; i < 10; ++i) {
+            sessions.push_back({make_imsi(i), std::chrono::steady_clock::now() + std::chrono::seconds(300)});
+        }
+        manager->restore_sessions(std::move(sessions));
+        journal->flush();
+    }
+
+    auto restored = make_manager(300, nullptr);
+    const auto stats = SessionSnapshotter::restore(dir, *restored, 2);
+    EXPECT_EQ(stats.journal_records, 10u);
+    EXPECT_EQ(restored->session_count(), 10u);
+}
+
+TEST_F(SessionSnapshotTest, CorruptedSnapshotThrows) {
+    std::filesystem::create_directories(dir);
+    std::ofstream(SessionSnapshotter::snapshot_path(dir)) << "not a snapshot at all, not even close";
+
+    auto restored = make_manager(300, nullptr);
+    EXPECT_THROW(SessionSnapshotter::restore(dir, *restored, 1), std::runtime_error);
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "session/session_manager.h"
+#include "session/shm_session_reader.h"
+#include "session/shm_session_table.h"
+#include "test_util.h"
+
+using namespace imsi_literals;
+
+namespace {
+
+std::string region_name(const char* test) {
+    return "/pgw_test_" + std::string(test) + "_" + std::to_string(::getpid());
+}
+
+} // namespace
+
+TEST(ShmSessionTableTest, ReaderSeesWriterUpdates) {
+    const auto name = region_name("updates");
+    ShmSessionTable table(name, 16);
+    ShmSessionReader reader(name);
+    ASSERT_TRUE(reader.is_open());
+    EXPECT_EQ(reader.state(), shm_session::State::Ready);
+
+    const auto expires_at = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    table.upsert("001010123456789"_imsi, expires_at);
+
+    int64_t expires_ns = 0;
+    EXPECT_EQ(reader.lookup("001010123456789"_imsi, &expires_ns), ShmSessionReader::Status::Active);
+    EXPECT_EQ(expires_ns, std::chrono::duration_cast<std::chrono::nanoseconds>(expires_at.time_since_epoch()).count());
+    EXPECT_EQ(reader.lookup("001010123456788"_imsi), ShmSessionReader::Status::NotFound);
+    EXPECT_EQ(reader.session_count(), 1u);
+
+    table.erase("001010123456789"_imsi);
+    EXPECT_FALSE(reader.is_active("001010123456789"_imsi));
+    EXPECT_EQ(reader.session_count(), 0u);
+}
+
+TEST(ShmSessionTableTest, ChurnKeepsTableConsistent) {
+    const auto name = region_name("churn");
+    ShmSessionTable table(name, 64);
+    ShmSessionReader reader(name);
+    const auto expires_at = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+
+    // Много вставок и удалений в маленькой таблице: надгробия, перестроения
+    for (uint64_t round = 0; round < 50; ++round) {
+        for (uint64_t i = 0; i < 40; ++i) {
+            table.upsert(make_imsi(round * 100 + i), expires_at);
+        }
+        for (uint64_t i = 0; i < 40; i += 2) {
+            table.erase(make_imsi(round * 100 + i));
+        }
+        for (uint64_t i = 1; i < 40; i += 2) {
+            if (round > 0) table.erase(make_imsi((round - 1) * 100 + i));
+        }
+    }
+
+    EXPECT_FALSE(table.overflowed());
+    EXPECT_EQ(table.size(), 20u);
+    for (uint64_t i = 0; i < 40; ++i) {
+        EXPECT_EQ(reader.is_active(make_imsi(4900 + i)), i % 2 == 1) << i;
+    }
+    EXPECT_FALSE(reader.is_active(make_imsi(4801)));
+}
+
+TEST(ShmSessionTableTest, ConcurrentReaderNeverMissesStableSessions) {
+    const auto name = region_name("concurrent");
+    ShmSessionTable table(name, 256);
+    const auto expires_at = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    for (uint64_t i = 0; i < 64; ++i) {
+        table.upsert(make_imsi(i), expires_at);
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<uint64_t> misses{0};
+    std::thread reader_thread([&] {
+        ShmSessionReader reader(name);
+        while (!stop.load(std::memory_order_relaxed)) {
+            for (uint64_t i = 0; i < 64; ++i) {
+                if (reader.lookup(make_imsi(i)) == ShmSessionReader::Status::NotFound) {
+                    misses.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+
+    // Писатель гоняет другие ключи через вставку/удаление, вызывая перестроения
+    for (uint64_t round = 0; round < 2000; ++round) {
+        for (uint64_t i = 0; i < 100; ++i) {
+            table.upsert(make_imsi(1000 + round * 100 + i), expires_at);
+        }
+        for (uint64_t i = 0; i < 100; ++i) {
+            table.erase(make_imsi(1000 + round * 100 + i));
+        }
+    }
+    stop = true;
+    reader_thread.join();
+
+    EXPECT_EQ(misses.load(), 0u);
+    EXPECT_EQ(table.size(), 64u);
+}
+
+TEST(ShmSessionTableTest, ReaderReportsUnavailableAfterWriterCloses) {
+    const auto name = region_name("closed");
+    auto table = std::make_unique<ShmSessionTable>(name, 16);
+    ShmSessionReader reader(name);
+    const uint64_t generation = reader.generation();
+    table->upsert("001010123456789"_imsi, std::chrono::steady_clock::now());
+
+    table.reset();
+    EXPECT_EQ(reader.lookup("001010123456789"_imsi), ShmSessionReader::Status::Unavailable);
+    EXPECT_FALSE(reader.reopen());
+
+    ShmSessionTable restarted(name, 16);
+    ASSERT_TRUE(reader.reopen());
+    EXPECT_NE(reader.generation(), generation);
+    EXPECT_EQ(reader.lookup("001010123456789"_imsi), ShmSessionReader::Status::NotFound);
+}
+
+TEST(ShmSessionTableTest, StagedRegionReplacesPreviousOnPublish) {
+    const auto name = region_name("staged");
+    auto previous = std::make_unique<ShmSessionTable>(name, 16);
+    previous->upsert("001010123456789"_imsi, std::chrono::steady_clock::now() + std::chrono::seconds(30));
+    ShmSessionReader reader(name);
+
+    // Пока новый регион заполняется, читатели работают с прежним
+    ShmSessionTable next(name, 16, true);
+    next.upsert("001010123456788"_imsi, std::chrono::steady_clock::now() + std::chrono::seconds(30));
+    EXPECT_TRUE(reader.is_active("001010123456789"_imsi));
+
+    next.publish();
+    EXPECT_EQ(reader.lookup("001010123456789"_imsi), ShmSessionReader::Status::Unavailable);
+    ASSERT_TRUE(reader.reopen());
+    EXPECT_TRUE(reader.is_active("001010123456788"_imsi));
+
+    // Прежний писатель при выходе не удаляет занятое новым имя
+    previous.reset();
+    ASSERT_TRUE(reader.reopen());
+    EXPECT_TRUE(reader.is_active("001010123456788"_imsi));
+}
+
+TEST(ShmSessionTableTest, SessionManagerMirrorsSessions) {
+    const auto name = region_name("manager");
+    auto table = std::make_shared<ShmSessionTable>(name, 16);
+    SessionManager manager(nullptr, 1, {"001010000000001"}, nullptr, table);
+    ShmSessionReader reader(name);
+
+    EXPECT_TRUE(manager.create_session("001010123456789"_imsi));
+    EXPECT_FALSE(manager.create_session("001010000000001"_imsi));
+    EXPECT_TRUE(reader.is_active("001010123456789"_imsi));
+    EXPECT_FALSE(reader.is_active("001010000000001"_imsi));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    manager.cleanup_expired_sessions();
+    EXPECT_EQ(reader.lookup("001010123456789"_imsi), ShmSessionReader::Status::NotFound);
+}